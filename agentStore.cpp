@@ -0,0 +1,151 @@
+#include "agentStore.h"
+#include <algorithm>
+
+AgentStore::AgentStore()
+{
+    height = 20;
+    gravity = -0.1;
+    jumpAmount = 10;
+    maxDistanceFromSpawn = 5120;
+}
+AgentStore::AgentStore(double inputHeight, double inputGravity, double inputJumpAmount, int inputMaxDistanceFromSpawn)
+{
+    height = inputHeight;
+    gravity = inputGravity;
+    jumpAmount = inputJumpAmount;
+    maxDistanceFromSpawn = inputMaxDistanceFromSpawn;
+}
+
+int AgentStore::addAgent(Point location, double speed, double xzAngle)
+{
+    x.push_back(location.x);
+    y.push_back(location.y);
+    z.push_back(location.z);
+    velocityX.push_back(speed * cos(xzAngle));
+    velocityY.push_back(0);
+    velocityZ.push_back(speed * sin(xzAngle));
+    terrainHeight.push_back(location.y - height/2);
+    isGrounded.push_back(true);
+    return size() - 1;
+}
+void AgentStore::clear()
+{
+    for(std::vector<double> *v : {&x, &y, &z, &velocityX, &velocityY, &velocityZ, &terrainHeight})
+    {
+        v->clear();
+    }
+    isGrounded.clear();
+}
+int AgentStore::size() const
+{
+    return x.size();
+}
+
+// ==========================
+//
+//          Getters
+//
+// ==========================
+Point AgentStore::getLocation(int index) const
+{
+    return {x[index], y[index], z[index]};
+}
+Point AgentStore::getVelocity(int index) const
+{
+    return {velocityX[index], velocityY[index], velocityZ[index]};
+}
+bool AgentStore::getIsGrounded(int index) const
+{
+    return isGrounded[index];
+}
+double AgentStore::getHeight() const
+{
+    return height;
+}
+
+// ===============================
+//
+//           Movement
+//
+// ==============================
+
+void AgentStore::setHeading(int index, double speed, double xzAngle)
+{
+    velocityX[index] = speed * cos(xzAngle);
+    velocityZ[index] = speed * sin(xzAngle);
+}
+void AgentStore::tryToJump(int index)
+{
+    if(isGrounded[index])
+    {
+        velocityY[index] = jumpAmount;
+        isGrounded[index] = false;
+    }
+}
+
+void AgentStore::tick(const HeightFunction &getHeights, WorkerPool &workers)
+{
+    int numAgents = size();
+    int numRanges = std::max(1, std::min(workers.getNumThreads() + 1, numAgents));
+    if(numRanges == 1)
+    {
+        tickRange(getHeights, 0, numAgents);
+        return;
+    }
+    // Each thread gets its own contiguous range of agents, so no two threads write to the same place
+    workers.run(numRanges, [this, &getHeights, numAgents, numRanges](int t)
+    {
+        int first = t*(numAgents / numRanges) + std::min(t, numAgents % numRanges);
+        int count = numAgents / numRanges + (t < numAgents % numRanges ? 1 : 0);
+        tickRange(getHeights, first, count);
+    });
+}
+
+void AgentStore::tickRange(const HeightFunction &getHeights, int first, int count)
+{
+    double halfHeight = height/2;
+    for(int i = first; i < first + count; i++)
+    {
+        // Same steps as Player::tick()
+        // move
+        x[i] += velocityX[i];
+        y[i] += velocityY[i];
+        z[i] += velocityZ[i];
+
+        // correctGround
+        double groundLevel = terrainHeight[i] + halfHeight;
+        if(y[i] < groundLevel)
+        {
+            y[i] = groundLevel;
+            isGrounded[i] = true;
+            velocityY[i] = 0;
+        }
+
+        // applyGravity
+        if(!isGrounded[i])
+        {
+            velocityY[i] += gravity;
+        }
+        else if(y[i] > groundLevel)
+        {
+            // If we moved and the terrain became lower, we need to fall down
+            y[i] = groundLevel;
+        }
+
+        // stayWithinBoundary
+        x[i] = std::max((double)-maxDistanceFromSpawn, std::min((double)maxDistanceFromSpawn, x[i]));
+        z[i] = std::max((double)-maxDistanceFromSpawn, std::min((double)maxDistanceFromSpawn, z[i]));
+    }
+
+    // The ground under the new locations, for the next tick. Where there is no
+    // terrain the height is NAN, and the agents keep their old ground height.
+    std::vector<double> heights(count);
+    getHeights(x.data() + first, z.data() + first, heights.data(), count);
+    for(int k = 0; k < count; k++)
+    {
+        if(!std::isnan(heights[k]))
+        {
+            terrainHeight[first + k] = heights[k];
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef RANDOM_TERRAIN_AGENTSTORE_H
+#define RANDOM_TERRAIN_AGENTSTORE_H
+
+// Stores many simulated agents (crowds, wildlife) as parallel arrays. Every agent
+// follows the same movement, gravity, jump, and boundary rules as the Player, but
+// the whole store is ticked at once, split across threads, and each thread looks
+// up the terrain heights for its agents in one batch.
+
+#include "structs.h"
+#include "mathHelper.h"
+#include "workerPool.h"
+#include <vector>
+#include <functional>
+
+class AgentStore
+{
+public:
+    // Fills heights[k] with the terrain height at (xs[k], zs[k]) for k < count.
+    // This gets called from several threads at once, so it must not change anything shared.
+    typedef std::function<void(const double *xs, const double *zs, double *heights, int count)> HeightFunction;
+private:
+    std::vector<double> x, y, z;
+    std::vector<double> velocityX, velocityY, velocityZ;
+    std::vector<double> terrainHeight; // The height of the ground beneath each agent
+    std::vector<char> isGrounded;
+
+    // Shared by every agent, like the Player's fields
+    double height;
+    double gravity;
+    double jumpAmount;
+    int maxDistanceFromSpawn;
+
+    // Tick agents first to first+count-1
+    void tickRange(const HeightFunction &getHeights, int first, int count);
+public:
+    AgentStore();
+    AgentStore(double inputHeight, double inputGravity, double inputJumpAmount, int inputMaxDistanceFromSpawn);
+
+    // Returns the index of the new agent. It starts on the ground at location.
+    int addAgent(Point location, double speed, double xzAngle);
+    void clear();
+    int size() const;
+
+    // Getters
+    Point getLocation(int index) const;
+    Point getVelocity(int index) const;
+    bool getIsGrounded(int index) const;
+    double getHeight() const;
+
+    // Set the xz velocity to move at speed in the xz direction given by the angle
+    void setHeading(int index, double speed, double xzAngle);
+    void tryToJump(int index);
+
+    // Move every agent, keep them above the ground and within the boundary,
+    // then find the terrain height at their new locations. The agents are split
+    // between the pool's threads and the calling thread.
+    void tick(const HeightFunction &getHeights, WorkerPool &workers);
+};
+
+#endif //RANDOM_TERRAIN_AGENTSTORE_H
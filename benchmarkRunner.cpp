@@ -0,0 +1,168 @@
+#include "benchmarkRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+static volatile double keptResult;
+void keepResult(double value)
+{
+    keptResult = keptResult + value;
+}
+
+BenchmarkRunner::BenchmarkRunner()
+{
+    minMilliseconds = 100;
+    repetitions = 5;
+}
+BenchmarkRunner::BenchmarkRunner(double inputMinMilliseconds, int inputRepetitions, std::string inputFilter)
+{
+    minMilliseconds = inputMinMilliseconds;
+    repetitions = std::max(1, inputRepetitions);
+    filter = inputFilter;
+}
+
+double BenchmarkRunner::timeOp(const std::function<void(long)> &op, long iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    op(iterations);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool BenchmarkRunner::matches(const std::string &name) const
+{
+    return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string &name, std::function<void(long)> op)
+{
+    if(!matches(name))
+    {
+        return;
+    }
+    // Find how many iterations take at least minMilliseconds. This also warms up the caches.
+    long iterations = 1;
+    double milliseconds = timeOp(op, iterations);
+    while(milliseconds < minMilliseconds)
+    {
+        double scale = milliseconds > 0 ? 1.2 * minMilliseconds / milliseconds : 10;
+        iterations = (long)(iterations * std::max(2.0, std::min(10.0, scale)));
+        milliseconds = timeOp(op, iterations);
+    }
+
+    std::vector<double> nsPerOp;
+    for(int i = 0; i < repetitions; i++)
+    {
+        nsPerOp.push_back(timeOp(op, iterations) * 1e6 / iterations);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    BenchmarkResult result = {name, iterations, nsPerOp[nsPerOp.size() / 2], nsPerOp.front(), nsPerOp.back()};
+    results.push_back(result);
+    printf("%-48s %12.1f ns/op  (%ld iterations, %.1f to %.1f)\n", name.c_str(), result.nsPerOp, iterations,
+           result.minNsPerOp, result.maxNsPerOp);
+    fflush(stdout);
+}
+
+const std::vector<BenchmarkResult> &BenchmarkRunner::getResults() const
+{
+    return results;
+}
+
+std::string BenchmarkRunner::toJSON() const
+{
+    std::ostringstream out;
+    out << "{\"benchmarks\": [\n";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult &r = results[i];
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "  {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, "
+                 "\"max_ns_per_op\": %.3f}%s\n",
+                 r.name.c_str(), r.iterations, r.nsPerOp, r.minNsPerOp, r.maxNsPerOp,
+                 i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+// The number after "key": on the line, or 0
+static double readNumber(const std::string &line, const std::string &key)
+{
+    size_t at = line.find("\"" + key + "\":");
+    if(at == std::string::npos)
+    {
+        return 0;
+    }
+    return atof(line.c_str() + at + key.size() + 3);
+}
+
+bool readBenchmarkJSON(const std::string &path, std::vector<BenchmarkResult> &results)
+{
+    std::ifstream in(path);
+    if(!in)
+    {
+        return false;
+    }
+    std::string line;
+    while(std::getline(in, line))
+    {
+        size_t nameAt = line.find("\"name\": \"");
+        if(nameAt == std::string::npos)
+        {
+            continue;
+        }
+        size_t nameStart = nameAt + 9;
+        size_t nameEnd = line.find('"', nameStart);
+        if(nameEnd == std::string::npos)
+        {
+            continue;
+        }
+        BenchmarkResult r;
+        r.name = line.substr(nameStart, nameEnd - nameStart);
+        r.iterations = (long)readNumber(line, "iterations");
+        r.nsPerOp = readNumber(line, "ns_per_op");
+        r.minNsPerOp = readNumber(line, "min_ns_per_op");
+        r.maxNsPerOp = readNumber(line, "max_ns_per_op");
+        results.push_back(r);
+    }
+    return true;
+}
+
+int compareBenchmarks(const std::vector<BenchmarkResult> &baseline, const std::vector<BenchmarkResult> &current,
+                      double thresholdPercent)
+{
+    std::unordered_map<std::string, double> baselineNs;
+    for(const BenchmarkResult &r : baseline)
+    {
+        baselineNs[r.name] = r.nsPerOp;
+    }
+    int slower = 0;
+    printf("\n%-48s %14s %14s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+    for(const BenchmarkResult &r : current)
+    {
+        auto it = baselineNs.find(r.name);
+        if(it == baselineNs.end() || it->second <= 0)
+        {
+            printf("%-48s %14s %14.1f %9s\n", r.name.c_str(), "-", r.nsPerOp, "new");
+            continue;
+        }
+        double change = 100 * (r.nsPerOp - it->second) / it->second;
+        const char *mark = "";
+        if(change > thresholdPercent)
+        {
+            mark = "  slower";
+            slower++;
+        }
+        else if(change < -thresholdPercent)
+        {
+            mark = "  faster";
+        }
+        printf("%-48s %14.1f %14.1f %+8.1f%%%s\n", r.name.c_str(), it->second, r.nsPerOp, change, mark);
+    }
+    return slower;
+}
@@ -0,0 +1,57 @@
+#ifndef RANDOM_TERRAIN_BENCHMARKRUNNER_H
+#define RANDOM_TERRAIN_BENCHMARKRUNNER_H
+
+// Times small pieces of the engine. Each benchmark is run enough times to take
+// at least minMilliseconds, then timed that many times over several repetitions,
+// and the median is kept. Results can be written as JSON and compared against
+// a run that was saved earlier.
+
+#include <string>
+#include <vector>
+#include <functional>
+
+struct BenchmarkResult
+{
+    std::string name;
+    long iterations;    // per repetition
+    double nsPerOp;     // the median of the repetitions
+    double minNsPerOp;
+    double maxNsPerOp;
+};
+
+class BenchmarkRunner
+{
+private:
+    double minMilliseconds;
+    int repetitions;
+    std::string filter; // only run benchmarks whose names contain this
+    std::vector<BenchmarkResult> results;
+
+    // Milliseconds for op(iterations)
+    static double timeOp(const std::function<void(long)> &op, long iterations);
+public:
+    BenchmarkRunner();
+    BenchmarkRunner(double inputMinMilliseconds, int inputRepetitions, std::string inputFilter);
+
+    // Whether run() would run this one, so expensive setup can be skipped
+    bool matches(const std::string &name) const;
+    // op(n) does the thing being measured n times. Nothing outside op is timed.
+    void run(const std::string &name, std::function<void(long)> op);
+
+    const std::vector<BenchmarkResult> &getResults() const;
+    // One result per line
+    std::string toJSON() const;
+};
+
+// Read results written by toJSON. Returns false if the file can't be read.
+bool readBenchmarkJSON(const std::string &path, std::vector<BenchmarkResult> &results);
+
+// Print each result next to the baseline's. Returns how many got slower
+// by more than thresholdPercent.
+int compareBenchmarks(const std::vector<BenchmarkResult> &baseline, const std::vector<BenchmarkResult> &current,
+                      double thresholdPercent);
+
+// Keeps the compiler from optimizing away work whose result isn't used
+void keepResult(double value);
+
+#endif //RANDOM_TERRAIN_BENCHMARKRUNNER_H
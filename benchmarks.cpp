@@ -0,0 +1,301 @@
+// Microbenchmarks for the terrain generation hot paths. Nothing here opens a window.
+//
+// benchmarks [--json file] [--compare baseline.json] [--threshold percent] [--filter text]
+//            [--min-ms n] [--repetitions n] [--points a,b,...] [--radius a,b,...]
+//            [--agents n] [--agent-threads a,b,...]
+//
+// --points sweeps the points per chunk side and --radius sweeps the render radius.
+// --agents sets how many agents the agent ticks are timed with, and
+// --agent-threads sweeps how many threads tick them.
+// --compare exits with 1 if anything got slower than the baseline by more than
+// the threshold (10% by default).
+
+#include "benchmarkRunner.h"
+#include "world.h"
+#include "worldSettings.h"
+#include "chunk.h"
+#include "mathHelper.h"
+#include "perlinNoiseGenerator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// "1,2,3" to {1, 2, 3}
+static std::vector<int> parseList(const char *text)
+{
+    std::vector<int> values;
+    const char *p = text;
+    while(*p != '\0')
+    {
+        values.push_back(atoi(p));
+        const char *comma = strchr(p, ',');
+        if(comma == nullptr)
+        {
+            break;
+        }
+        p = comma + 1;
+    }
+    return values;
+}
+
+static std::shared_ptr<Chunk> makeChunk(const std::vector<std::vector<double>> &noise, int pointsPerChunk, bool hasCity)
+{
+    std::vector<double> noBorder;
+    const TerrainColors &colors = COLOR_SCHEMES[Plain];
+    return std::make_shared<Chunk>(Point2D{0, 0}, CHUNK_SIZE, pointsPerChunk, noise, TERRAIN_HEIGHT_FACTOR, 0.5,
+                                   noBorder, noBorder, noBorder, noBorder,
+                                   SNOW_LIMIT, ROCK_LIMIT, GRASS_LIMIT, WATER_LEVEL,
+                                   colors.snow, colors.rock, colors.grass, colors.sand, colors.water, hasCity);
+}
+
+static void benchmarkNoise(BenchmarkRunner &runner, int pointsPerChunk)
+{
+    std::string suffix = "/points=" + std::to_string(pointsPerChunk);
+    runner.run("perlin/construct" + suffix, [pointsPerChunk](long n)
+    {
+        for(long i = 0; i < n; i++)
+        {
+            PerlinNoiseGenerator png(pointsPerChunk, pointsPerChunk, 1);
+            keepResult(png.getPerlinNoise()[0][0]);
+        }
+    });
+
+    PerlinNoiseGenerator png(pointsPerChunk, pointsPerChunk, 1);
+    std::vector<std::vector<double>> seed = png.getPerlinNoise();
+    int numOctaves = (int)floor(log(pointsPerChunk));
+    runner.run("perlin/calculatePerlinNoise2D" + suffix, [&png, &seed, pointsPerChunk, numOctaves](long n)
+    {
+        for(long i = 0; i < n; i++)
+        {
+            keepResult(png.calculatePerlinNoise2D(pointsPerChunk, pointsPerChunk, seed, numOctaves)[0][0]);
+        }
+    });
+}
+
+static void benchmarkChunks(BenchmarkRunner &runner, int pointsPerChunk)
+{
+    std::string suffix = "/points=" + std::to_string(pointsPerChunk);
+    std::vector<std::vector<double>> noise = PerlinNoiseGenerator(pointsPerChunk, pointsPerChunk, 1).getScaledNoise(0, 1);
+
+    // Everything the game does to a new chunk before drawing it
+    for(bool hasCity : {false, true})
+    {
+        runner.run(std::string(hasCity ? "chunk/make-city" : "chunk/make") + suffix, [&noise, pointsPerChunk, hasCity](long n)
+        {
+            for(long i = 0; i < n; i++)
+            {
+                std::shared_ptr<Chunk> c = makeChunk(noise, pointsPerChunk, hasCity);
+                c->ensureMeshReady();
+                if(hasCity)
+                {
+                    c->ensureBuildings();
+                }
+                keepResult(c->getMaxHeight());
+            }
+        });
+    }
+
+    if(runner.matches("chunk/getHeightAt" + suffix))
+    {
+        std::shared_ptr<Chunk> c = makeChunk(noise, pointsPerChunk, false);
+        c->ensurePhysicsReady();
+        std::vector<Point> points;
+        srand(1);
+        for(int i = 0; i < 1024; i++)
+        {
+            points.push_back({CHUNK_SIZE * (rand() / (double)RAND_MAX), 0, CHUNK_SIZE * (rand() / (double)RAND_MAX)});
+        }
+        runner.run("chunk/getHeightAt" + suffix, [&c, &points](long n)
+        {
+            double sum = 0;
+            for(long i = 0; i < n; i++)
+            {
+                sum += c->getHeightAt(points[i % points.size()]);
+            }
+            keepResult(sum);
+        });
+    }
+}
+
+static void benchmarkChunkMath(BenchmarkRunner &runner, const std::vector<int> &radii)
+{
+    runner.run("math/chunkIDRoundTrip", [](long n)
+    {
+        long sum = 0;
+        for(long i = 0; i < n; i++)
+        {
+            sum += point2DtoChunkID(chunkIDtoPoint2D(i % 1000000));
+        }
+        keepResult(sum);
+    });
+    for(int radius : radii)
+    {
+        runner.run("math/getChunkTopLeftCornersAroundPoint/radius=" + std::to_string(radius), [radius](long n)
+        {
+            for(long i = 0; i < n; i++)
+            {
+                keepResult(getChunkTopLeftCornersAroundPoint(Point2D{(int)(i % 64), 0}, radius).size());
+            }
+        });
+    }
+}
+
+static void benchmarkWorlds(BenchmarkRunner &runner, const std::vector<int> &pointsPerChunk, const std::vector<int> &radii)
+{
+    for(int radius : radii)
+    {
+        for(int points : pointsPerChunk)
+        {
+            std::string name = "game/updateColorScheme/radius=" + std::to_string(radius) + "/points=" + std::to_string(points);
+            if(!runner.matches(name))
+            {
+                continue;
+            }
+            World world(radius, points);
+            world.finishChunkJobs();
+            runner.run(name, [&world](long n)
+            {
+                for(long i = 0; i < n; i++)
+                {
+                    world.updateColorScheme((ColorScheme)(i % 4));
+                }
+            });
+        }
+    }
+}
+
+// One tick of every agent, in the same world every time
+static void benchmarkAgents(BenchmarkRunner &runner, int numAgents, const std::vector<int> &threadCounts)
+{
+    for(int threads : threadCounts)
+    {
+        std::string name = "game/agentTick/agents=" + std::to_string(numAgents) + "/threads=" + std::to_string(threads);
+        if(!runner.matches(name))
+        {
+            continue;
+        }
+        World world(5, 30, 1);
+        // Make all of the chunks around the player before spawning on them
+        world.finishChunkJobs();
+        world.spawnAgents(numAgents, 0);
+        world.setNumAgentThreads(threads);
+        // The first tick gets the chunks ready, so don't time it
+        world.agentTick();
+        runner.run(name, [&world](long n)
+        {
+            for(long i = 0; i < n; i++)
+            {
+                world.agentTick();
+            }
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *jsonPath = nullptr;
+    const char *comparePath = nullptr;
+    double threshold = 10;
+    std::string filter;
+    double minMilliseconds = 100;
+    int repetitions = 5;
+    std::vector<int> pointsPerChunk = {15, 30, 60};
+    std::vector<int> radii = {5, 10, 20};
+    int numAgents = 50000;
+    std::vector<int> agentThreads = {1};
+    if(std::thread::hardware_concurrency() > 1)
+    {
+        agentThreads.push_back(std::thread::hardware_concurrency());
+    }
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+        {
+            comparePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+        {
+            threshold = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if(strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc)
+        {
+            minMilliseconds = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+        {
+            repetitions = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--points") == 0 && i + 1 < argc)
+        {
+            pointsPerChunk = parseList(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--radius") == 0 && i + 1 < argc)
+        {
+            radii = parseList(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--agents") == 0 && i + 1 < argc)
+        {
+            numAgents = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--agent-threads") == 0 && i + 1 < argc)
+        {
+            agentThreads = parseList(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // Read the baseline first, so a bad path doesn't waste a whole run
+    std::vector<BenchmarkResult> baseline;
+    if(comparePath != nullptr && !readBenchmarkJSON(comparePath, baseline))
+    {
+        fprintf(stderr, "Can't read %s\n", comparePath);
+        return 2;
+    }
+
+    BenchmarkRunner runner(minMilliseconds, repetitions, filter);
+    for(int points : pointsPerChunk)
+    {
+        benchmarkNoise(runner, points);
+    }
+    for(int points : pointsPerChunk)
+    {
+        benchmarkChunks(runner, points);
+    }
+    benchmarkChunkMath(runner, radii);
+    benchmarkWorlds(runner, pointsPerChunk, radii);
+    benchmarkAgents(runner, numAgents, agentThreads);
+
+    if(jsonPath != nullptr)
+    {
+        std::ofstream out(jsonPath);
+        out << runner.toJSON();
+        if(!out)
+        {
+            fprintf(stderr, "Can't write %s\n", jsonPath);
+            return 2;
+        }
+    }
+    if(comparePath != nullptr)
+    {
+        int slower = compareBenchmarks(baseline, runner.getResults(), threshold);
+        printf("%d slower by more than %.0f%%\n", slower, threshold);
+        return slower > 0 ? 1 : 0;
+    }
+    return 0;
+}
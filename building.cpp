@@ -39,17 +39,30 @@ std::vector<std::shared_ptr<Solid>> Building::getSolids() const
     return solids;
 }
 
-typeOfBuilding Building::getBuildingType() const
+Point Building::getCenter() const
 {
-    return buildingType;
+    return center;
+}
+int Building::getSideLength() const
+{
+    return sideLength;
+}
+int Building::getHeight() const
+{
+    return height;
+}
+RGBAcolor Building::getColor() const
+{
+    return color;
+}
+RGBAcolor Building::getEdgeColor() const
+{
+    return edgeColor;
 }
 
-void Building::draw() const
+typeOfBuilding Building::getBuildingType() const
 {
-    for(std::shared_ptr<Solid> s : solids)
-    {
-        s->draw();
-    }
+    return buildingType;
 }
 
 // Check each solid for a collision with this point (or if the point is within
@@ -57,5 +70,34 @@ void Building::draw() const
 // and doesn't check any more. If none of the solids have a problem, it returns nullopt.
 std::experimental::optional<Point> Building::correctCollision(Point p, int buffer)
 {
+    for(std::shared_ptr<Solid> s : solids)
+    {
+        // Work in the solid's frame, where its sides line up with the x and z axes
+        Point solidCenter = s->getCenter();
+        Point local = getRotatedPointAroundPoint(p, solidCenter, 0, -s->getXZAngle(), 0);
+        double dx = local.x - solidCenter.x;
+        double dy = local.y - solidCenter.y;
+        double dz = local.z - solidCenter.z;
+        double halfX = s->getXWidth()/2 + buffer;
+        double halfY = s->getYWidth()/2 + buffer;
+        double halfZ = s->getZWidth()/2 + buffer;
+        if(fabs(dx) >= halfX || fabs(dy) >= halfY || fabs(dz) >= halfZ)
+        {
+            continue;
+        }
+
+        // Push the point out through whichever side is closest
+        double penetrationX = halfX - fabs(dx);
+        double penetrationZ = halfZ - fabs(dz);
+        if(penetrationX < penetrationZ)
+        {
+            local.x = solidCenter.x + (dx < 0 ? -halfX : halfX);
+        }
+        else
+        {
+            local.z = solidCenter.z + (dz < 0 ? -halfZ : halfZ);
+        }
+        return getRotatedPointAroundPoint(local, solidCenter, 0, s->getXZAngle(), 0);
+    }
     return std::experimental::nullopt;
 }
\ No newline at end of file
@@ -34,10 +34,14 @@ public:
 
     // Getters
     std::vector<std::shared_ptr<Solid>> getSolids() const;
+    Point getCenter() const;
+    int getSideLength() const;
+    int getHeight() const;
+    RGBAcolor getColor() const;
+    RGBAcolor getEdgeColor() const;
 
     typeOfBuilding getBuildingType() const;
 
-    void draw() const;
 
     // Check each solid for a collision with this point (or if the point is within
     // buffer of the solid). If it finds one, it returns that solid's corrected point,
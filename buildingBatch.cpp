@@ -0,0 +1,255 @@
+#include "buildingBatch.h"
+#include <iostream>
+
+GLuint BuildingBatch::unitBoxBuffer = 0;
+GLuint BuildingBatch::program = 0;
+bool BuildingBatch::sharedInitialized = false;
+
+BuildingBatch::BuildingBatch()
+{
+    instanceBuffer = 0;
+    numInstances = 0;
+    lineBuffer = 0;
+    numLineVertices = 0;
+}
+
+void BuildingBatch::initializeShared()
+{
+    sharedInitialized = true;
+
+    // A box from -0.5 to 0.5, as triangles. The corner order matches RecPrism::initializeCorners()
+    const float c[8][3] = {{.5,.5,.5}, {-.5,.5,.5}, {.5,-.5,.5}, {-.5,-.5,.5},
+                           {.5,.5,-.5}, {-.5,.5,-.5}, {.5,-.5,-.5}, {-.5,-.5,-.5}};
+    // The same quads as RecPrism::drawFaces()
+    const int quads[6][4] = {{0,1,3,2}, {5,4,6,7}, {6,4,0,2}, {4,5,1,0}, {6,2,3,7}, {3,1,5,7}};
+    std::vector<float> vertices;
+    for(const int *q : quads)
+    {
+        const int triangleCorners[6] = {q[0], q[1], q[2], q[0], q[2], q[3]};
+        for(int corner : triangleCorners)
+        {
+            vertices.insert(vertices.end(), c[corner], c[corner] + 3);
+        }
+    }
+    glFuncs.genBuffers(1, &unitBoxBuffer);
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, unitBoxBuffer);
+    glFuncs.bufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    const char *vertexSource =
+            "#version 120\n"
+            "attribute vec3 unitPosition;\n"
+            "attribute vec3 instanceCenter;\n"
+            "attribute vec3 instanceSize;\n"
+            "attribute float instanceAngle;\n"
+            "attribute vec4 instanceColor;\n"
+            "varying vec4 color;\n"
+            "void main()\n"
+            "{\n"
+            "    color = instanceColor;\n"
+            "    // Turned in the xz plane the same way as rotatePointAroundPoint()\n"
+            "    vec3 p = unitPosition*instanceSize;\n"
+            "    float c = cos(instanceAngle), s = sin(instanceAngle);\n"
+            "    p = vec3(p.x*c - p.z*s, p.y, p.x*s + p.z*c);\n"
+            "    gl_Position = gl_ModelViewProjectionMatrix * vec4(instanceCenter + p, 1.0);\n"
+            "}\n";
+    const char *fragmentSource =
+            "#version 120\n"
+            "varying vec4 color;\n"
+            "void main()\n"
+            "{\n"
+            "    gl_FragColor = color;\n"
+            "}\n";
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    program = glFuncs.createProgram();
+    glFuncs.attachShader(program, vertexShader);
+    glFuncs.attachShader(program, fragmentShader);
+    glFuncs.bindAttribLocation(program, UNIT_POSITION_ATTRIB, "unitPosition");
+    glFuncs.bindAttribLocation(program, CENTER_ATTRIB, "instanceCenter");
+    glFuncs.bindAttribLocation(program, SIZE_ATTRIB, "instanceSize");
+    glFuncs.bindAttribLocation(program, COLOR_ATTRIB, "instanceColor");
+    glFuncs.bindAttribLocation(program, ANGLE_ATTRIB, "instanceAngle");
+    glFuncs.linkProgram(program);
+    glFuncs.deleteShader(vertexShader);
+    glFuncs.deleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glFuncs.getProgramiv(program, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE)
+    {
+        char log[1024];
+        glFuncs.getProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Building shader failed to link: " << log << std::endl;
+        // Stop trying to draw buildings this way
+        glFuncs.deleteProgram(program);
+        program = 0;
+        glFuncs.hasInstancing = false;
+    }
+}
+
+GLuint BuildingBatch::compileShader(GLenum type, const char *source)
+{
+    GLuint shader = glFuncs.createShader(type);
+    glFuncs.shaderSource(shader, 1, &source, nullptr);
+    glFuncs.compileShader(shader);
+    GLint compiled = GL_FALSE;
+    glFuncs.getShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if(compiled != GL_TRUE)
+    {
+        char log[1024];
+        glFuncs.getShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Building shader failed to compile: " << log << std::endl;
+    }
+    return shader;
+}
+
+void BuildingBatch::build(const SolidStore &solids)
+{
+    if(!sharedInitialized)
+    {
+        initializeShared();
+    }
+    release();
+    if(!glFuncs.hasInstancing)
+    {
+        // The shader didn't link, so the buildings are drawn one by one
+        return;
+    }
+
+    std::vector<float> instances;
+    const SolidStore::Group &prisms = solids.getGroup(RectangularPrism);
+    for(int i = 0; i < prisms.size(); i++)
+    {
+        RGBAcolor color = prisms.color[i];
+        float instance[INSTANCE_FLOATS] = {(float)prisms.centerX[i], (float)prisms.centerY[i], (float)prisms.centerZ[i],
+                                           (float)prisms.xWidth[i], (float)prisms.yWidth[i], (float)prisms.zWidth[i],
+                                           (float)prisms.xzAngle[i], (float)color.r, (float)color.g, (float)color.b, (float)color.a};
+        instances.insert(instances.end(), instance, instance + INSTANCE_FLOATS);
+    }
+
+    std::vector<float> lineVertices;
+    std::vector<Point> segments;
+    std::vector<RGBAcolor> lineColors;
+    solids.getLineSegments(RectangularPrism, segments, lineColors);
+    for(int k = 0; k < (int)segments.size(); k++)
+    {
+        const Point &p = segments[k];
+        const RGBAcolor &lineColor = lineColors[k];
+        float vertex[LINE_VERTEX_FLOATS] = {(float)p.x, (float)p.y, (float)p.z,
+                                            (float)lineColor.r, (float)lineColor.g,
+                                            (float)lineColor.b, (float)lineColor.a};
+        lineVertices.insert(lineVertices.end(), vertex, vertex + LINE_VERTEX_FLOATS);
+    }
+
+    numInstances = instances.size() / INSTANCE_FLOATS;
+    numLineVertices = lineVertices.size() / LINE_VERTEX_FLOATS;
+    if(numInstances > 0)
+    {
+        glFuncs.genBuffers(1, &instanceBuffer);
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glFuncs.bufferData(GL_ARRAY_BUFFER, instances.size()*sizeof(float), instances.data(), GL_STATIC_DRAW);
+    }
+    if(numLineVertices > 0)
+    {
+        glFuncs.genBuffers(1, &lineBuffer);
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, lineBuffer);
+        glFuncs.bufferData(GL_ARRAY_BUFFER, lineVertices.size()*sizeof(float), lineVertices.data(), GL_STATIC_DRAW);
+    }
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BuildingBatch::release()
+{
+    if(instanceBuffer != 0)
+    {
+        glFuncs.deleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+    }
+    if(lineBuffer != 0)
+    {
+        glFuncs.deleteBuffers(1, &lineBuffer);
+        lineBuffer = 0;
+    }
+    numInstances = 0;
+    numLineVertices = 0;
+}
+
+void BuildingBatch::releaseShared()
+{
+    if(unitBoxBuffer != 0)
+    {
+        glFuncs.deleteBuffers(1, &unitBoxBuffer);
+        unitBoxBuffer = 0;
+    }
+    if(program != 0)
+    {
+        glFuncs.deleteProgram(program);
+        program = 0;
+    }
+    sharedInitialized = false;
+}
+
+bool BuildingBatch::isBuilt() const
+{
+    return instanceBuffer != 0 || lineBuffer != 0;
+}
+
+void BuildingBatch::draw() const
+{
+    glDisable(GL_CULL_FACE);
+
+    // Lines first, like RecPrism::draw()
+    if(numLineVertices > 0)
+    {
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, lineBuffer);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        GLsizei stride = LINE_VERTEX_FLOATS*sizeof(float);
+        glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<const void*>(0));
+        glColorPointer(4, GL_FLOAT, stride, reinterpret_cast<const void*>(3*sizeof(float)));
+        glDrawArrays(GL_LINES, 0, numLineVertices);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+
+    if(numInstances > 0)
+    {
+        glFuncs.useProgram(program);
+
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, unitBoxBuffer);
+        glFuncs.enableVertexAttribArray(UNIT_POSITION_ATTRIB);
+        glFuncs.vertexAttribPointer(UNIT_POSITION_ATTRIB, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const void*>(0));
+
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        GLsizei stride = INSTANCE_FLOATS*sizeof(float);
+        glFuncs.enableVertexAttribArray(CENTER_ATTRIB);
+        glFuncs.vertexAttribPointer(CENTER_ATTRIB, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(0));
+        glFuncs.vertexAttribDivisor(CENTER_ATTRIB, 1);
+        glFuncs.enableVertexAttribArray(SIZE_ATTRIB);
+        glFuncs.vertexAttribPointer(SIZE_ATTRIB, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(3*sizeof(float)));
+        glFuncs.vertexAttribDivisor(SIZE_ATTRIB, 1);
+        glFuncs.enableVertexAttribArray(ANGLE_ATTRIB);
+        glFuncs.vertexAttribPointer(ANGLE_ATTRIB, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(6*sizeof(float)));
+        glFuncs.vertexAttribDivisor(ANGLE_ATTRIB, 1);
+        glFuncs.enableVertexAttribArray(COLOR_ATTRIB);
+        glFuncs.vertexAttribPointer(COLOR_ATTRIB, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(7*sizeof(float)));
+        glFuncs.vertexAttribDivisor(COLOR_ATTRIB, 1);
+
+        glFuncs.drawArraysInstanced(GL_TRIANGLES, 0, 36, numInstances);
+
+        glFuncs.vertexAttribDivisor(CENTER_ATTRIB, 0);
+        glFuncs.vertexAttribDivisor(SIZE_ATTRIB, 0);
+        glFuncs.vertexAttribDivisor(ANGLE_ATTRIB, 0);
+        glFuncs.vertexAttribDivisor(COLOR_ATTRIB, 0);
+        glFuncs.disableVertexAttribArray(UNIT_POSITION_ATTRIB);
+        glFuncs.disableVertexAttribArray(CENTER_ATTRIB);
+        glFuncs.disableVertexAttribArray(SIZE_ATTRIB);
+        glFuncs.disableVertexAttribArray(ANGLE_ATTRIB);
+        glFuncs.disableVertexAttribArray(COLOR_ATTRIB);
+        glFuncs.useProgram(0);
+    }
+
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnable(GL_CULL_FACE);
+}
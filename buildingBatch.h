@@ -0,0 +1,64 @@
+#ifndef RANDOM_TERRAIN_BUILDINGBATCH_H
+#define RANDOM_TERRAIN_BUILDINGBATCH_H
+
+// All of the buildings in a chunk, drawn together. The faces are drawn as
+// instances of a unit box with one (center, size, xz angle, color) entry per solid,
+// and every edge and gridline goes into a single line buffer.
+// This needs glFuncs.hasInstancing; otherwise draw the buildings one by one.
+
+#include "solidStore.h"
+#include "glFunctions.h"
+#include <vector>
+#include <memory>
+
+class BuildingBatch
+{
+private:
+    GLuint instanceBuffer;
+    GLsizei numInstances;
+    GLuint lineBuffer;
+    GLsizei numLineVertices;
+
+    // Shared by every batch
+    static GLuint unitBoxBuffer;
+    static GLuint program;
+    static bool sharedInitialized;
+
+    // Floats per instance: center x,y,z, size x,y,z, xz angle, color r,g,b,a
+    const static int INSTANCE_FLOATS = 11;
+    // Floats per line vertex: x,y,z, r,g,b,a
+    const static int LINE_VERTEX_FLOATS = 7;
+    // Attribute locations in the shader
+    const static GLuint UNIT_POSITION_ATTRIB = 0;
+    const static GLuint CENTER_ATTRIB = 1;
+    const static GLuint SIZE_ATTRIB = 2;
+    const static GLuint COLOR_ATTRIB = 3;
+    const static GLuint ANGLE_ATTRIB = 4;
+
+    static void initializeShared();
+    static GLuint compileShader(GLenum type, const char *source);
+public:
+    // Deleting a batch doesn't delete its buffers, since there may be no
+    // context by then. Call release() first.
+    BuildingBatch();
+
+    // Owns GL buffers, so it can't be copied
+    BuildingBatch(const BuildingBatch &) = delete;
+    BuildingBatch &operator=(const BuildingBatch &) = delete;
+
+    // Fill the buffers from the solids in the store. If the shader can't be
+    // made, glFuncs.hasInstancing is turned off and nothing is built.
+    void build(const SolidStore &solids);
+    // Delete the buffers
+    void release();
+    // Delete the box and shader every batch shares. They are made again if
+    // another batch is built.
+    static void releaseShared();
+
+    bool isBuilt() const;
+
+    // One instanced call for the faces and one call for the lines
+    void draw() const;
+};
+
+#endif //RANDOM_TERRAIN_BUILDINGBATCH_H
@@ -6,7 +6,7 @@
 #include <string>
 #include <cmath>
 #include "structs.h"
-#include "graphics.h"
+#include "glFunctions.h"
 #include "mathHelper.h"
 
 class Button
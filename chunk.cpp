@@ -1,9 +1,21 @@
 #include "chunk.h"
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 Chunk::Chunk()
 {
     topLeft = {0, 0};
     sideLength = 512;
+    hasCity = false;
+    buildingSeed = 0;
+    std::shared_ptr<ChunkVersion> v = std::make_shared<ChunkVersion>();
+    v->version = 0;
+    v->heights = std::make_shared<ChunkHeights>();
+    current.store(v);
+    stage = HeightsOnly;
     initializeCenter();
     initializeChunkID();
 }
@@ -13,7 +25,7 @@ Chunk::Chunk(Point2D inputTopLeft, int inputSideLength, int inputPointsPerSide,
              const std::vector<double> &absoluteHeightsLeft, const std::vector<double> &absoluteHeightsRight,
              double inputSnowLimit, double inputRockLimit, double inputGrassLimit, double inputWaterLevel,
              RGBAcolor inputSnowColor, RGBAcolor inputRockColor, RGBAcolor inputGrassColor, RGBAcolor inputSandColor,
-             RGBAcolor inputWaterColor, bool hasCity)
+             RGBAcolor inputWaterColor, bool inputHasCity, int inputBuildingSeed)
 {
     topLeft = inputTopLeft;
     sideLength = inputSideLength;
@@ -24,22 +36,31 @@ Chunk::Chunk(Point2D inputTopLeft, int inputSideLength, int inputPointsPerSide,
     grassLimit = inputGrassLimit;
     waterLevel = inputWaterLevel;
     perlinSeed = inputPerlinSeed > 0 ? inputPerlinSeed : 0.1; // can't be zero, gets divided by
+    hasCity = inputHasCity;
+    stage = HeightsOnly;
     initializeCenter();
     initializeChunkID();
-    initializeTerrainPoints(terrainHeights);
-    overwriteBorderHeights(absoluteHeightsAbove, absoluteHeightsBelow, absoluteHeightsLeft, absoluteHeightsRight);
-    initializeNormalVectors();
-    initializeTerrainColorMap(inputSnowColor, inputRockColor, inputGrassColor, inputSandColor, inputWaterColor);
-    initializeSquareTerrainType();
-    initializeSquareColors();
-    initializeDrawWaterAt();
+    std::shared_ptr<ChunkHeights> heights = std::make_shared<ChunkHeights>();
+    initializeTerrainPoints(terrainHeights, *heights);
+    overwriteBorderHeights(absoluteHeightsAbove, absoluteHeightsBelow, absoluteHeightsLeft, absoluteHeightsRight, *heights);
+    heights->heightPyramid.build(heights->terrainPoints);
+    std::shared_ptr<ChunkVersion> v = std::make_shared<ChunkVersion>();
+    v->version = 0;
+    v->heights = heights;
+    initializeTerrainColorMap(inputSnowColor, inputRockColor, inputGrassColor, inputSandColor, inputWaterColor, *v);
+    current.store(v);
+    buildingSeed = 0;
     if(hasCity)
     {
+        buildingSeed = inputBuildingSeed;
+        if(buildingSeed < 0)
+        {
+            RandomNumberGenerator rng;
+            buildingSeed = static_cast<int>(rng.getRandom() * rng.modulus);
+        }
         initializeRandomCityCenter();
-        initializeBuildings();
     }
 }
-
 void Chunk::initializeCenter()
 {
     center = {sideLength*topLeft.x + sideLength/2.0, 0,sideLength*topLeft.z + sideLength/2.0};
@@ -48,29 +69,39 @@ void Chunk::initializeChunkID()
 {
     chunkID = point2DtoChunkID(topLeft);
 }
-void Chunk::initializeTerrainPoints(std::vector<std::vector<double>> terrainHeights)
+void Chunk::initializeTerrainPoints(std::vector<std::vector<double>> terrainHeights, ChunkHeights &heights) const
 {
+    SharedRows<Point> &terrainPoints = heights.terrainPoints;
     double squareSize = sideLength / (pointsPerSide-1.0);
     for(int i = 0; i < pointsPerSide; i++)
     {
-        terrainPoints.emplace_back(std::vector<Point>());
+        std::vector<Point> row;
         for(int j = 0; j < pointsPerSide; j++)
         {
             // A perlin seed of 0.5 will make the max height in this chunk be heightScaleFactor
             double x = center.x - sideLength/2 + i*squareSize;
             double y = relativeToAbsoluteHeight(terrainHeights[i][j]);
             double z = center.z - sideLength/2 + j*squareSize;
-            terrainPoints[i].push_back({x, y, z});
+            row.push_back({x, y, z});
         }
+        terrainPoints.addRow(row);
     }
 }
-void Chunk::initializeNormalVectors()
+void Chunk::initializeNormalVectors(const ChunkHeights &heights, ChunkPhysics &physics) const
 {
-    for(int i = 0; i < pointsPerSide - 1; i++)
+    int squaresPerSide = pointsPerSide - 1;
+    physics.upperNormals = SharedRows<Point>(squaresPerSide, squaresPerSide);
+    physics.lowerNormals = SharedRows<Point>(squaresPerSide, squaresPerSide);
+    updateNormalVectors(heights, physics, {0, 0, squaresPerSide - 1, squaresPerSide - 1});
+}
+void Chunk::updateNormalVectors(const ChunkHeights &heights, ChunkPhysics &physics, SquareRange squares) const
+{
+    const SharedRows<Point> &terrainPoints = heights.terrainPoints;
+    SharedRows<Point> &upperNormals = physics.upperNormals;
+    SharedRows<Point> &lowerNormals = physics.lowerNormals;
+    for(int i = squares.iMin; i <= squares.iMax; i++)
     {
-        upperNormals.emplace_back(std::vector<Point>());
-        lowerNormals.emplace_back(std::vector<Point>());
-        for(int j = 0; j < pointsPerSide - 1; j++)
+        for(int j = squares.jMin; j <= squares.jMax; j++)
         {
             Point p1 = terrainPoints[i][j];
             Point p2 = terrainPoints[i+1][j];
@@ -78,16 +109,71 @@ void Chunk::initializeNormalVectors()
             Point p4 = terrainPoints[i+1][j+1];
             Point v1 = {p2.x - p1.x, p2.y - p1.y, p2.z - p1.z};
             Point v2 = {p3.x - p1.x, p3.y - p1.y, p3.z - p1.z};
-            upperNormals[i].push_back(crossProduct(v2, v1));
+            upperNormals[i][j] = crossProduct(v2, v1);
             Point v3 = {p2.x - p4.x, p2.y - p4.y, p2.z - p4.z};
             Point v4 = {p3.x - p4.x, p3.y - p4.y, p3.z - p4.z};
-            lowerNormals[i].push_back(crossProduct(v3, v4));
+            lowerNormals[i][j] = crossProduct(v3, v4);
+        }
+    }
+}
+void Chunk::initializePlaneCoefficients(const ChunkHeights &heights, ChunkPhysics &physics) const
+{
+    int squaresPerSide = pointsPerSide - 1;
+    for(SharedRows<double> *v : {&physics.upperPlaneA, &physics.upperPlaneB, &physics.upperPlaneC,
+                                 &physics.lowerPlaneA, &physics.lowerPlaneB, &physics.lowerPlaneC})
+    {
+        *v = SharedRows<double>(squaresPerSide, squaresPerSide);
+    }
+    updatePlaneCoefficients(heights, physics, {0, 0, squaresPerSide - 1, squaresPerSide - 1});
+}
+void Chunk::updatePlaneCoefficients(const ChunkHeights &heights, ChunkPhysics &physics, SquareRange squares) const
+{
+    const SharedRows<Point> &terrainPoints = heights.terrainPoints;
+    const SharedRows<Point> &upperNormals = physics.upperNormals;
+    const SharedRows<Point> &lowerNormals = physics.lowerNormals;
+    SharedRows<double> &upperPlaneA = physics.upperPlaneA, &upperPlaneB = physics.upperPlaneB, &upperPlaneC = physics.upperPlaneC;
+    SharedRows<double> &lowerPlaneA = physics.lowerPlaneA, &lowerPlaneB = physics.lowerPlaneB, &lowerPlaneC = physics.lowerPlaneC;
+    for(int i = squares.iMin; i <= squares.iMax; i++)
+    {
+        for(int j = squares.jMin; j <= squares.jMax; j++)
+        {
+            // Solve the plane equation n.x*x + n.y*y + n.z*z = n . p for y
+            Point p = terrainPoints[i][j];
+            Point n = upperNormals[i][j];
+            if(n.y != 0)
+            {
+                upperPlaneA[i][j] = dotProduct(n, p) / n.y;
+                upperPlaneB[i][j] = -n.x / n.y;
+                upperPlaneC[i][j] = -n.z / n.y;
+            }
+            else
+            {
+                upperPlaneA[i][j] = p.y;
+                upperPlaneB[i][j] = 0;
+                upperPlaneC[i][j] = 0;
+            }
+            p = terrainPoints[i+1][j+1];
+            n = lowerNormals[i][j];
+            if(n.y != 0)
+            {
+                lowerPlaneA[i][j] = dotProduct(n, p) / n.y;
+                lowerPlaneB[i][j] = -n.x / n.y;
+                lowerPlaneC[i][j] = -n.z / n.y;
+            }
+            else
+            {
+                lowerPlaneA[i][j] = p.y;
+                lowerPlaneB[i][j] = 0;
+                lowerPlaneC[i][j] = 0;
+            }
         }
     }
 }
 void Chunk::overwriteBorderHeights(const std::vector<double> &absoluteHeightsAbove, const std::vector<double> &absoluteHeightsBelow,
-                            const std::vector<double> &absoluteHeightsLeft, const std::vector<double> &absoluteHeightsRight)
+                            const std::vector<double> &absoluteHeightsLeft, const std::vector<double> &absoluteHeightsRight,
+                            ChunkHeights &heights) const
 {
+    SharedRows<Point> &terrainPoints = heights.terrainPoints;
     if(absoluteHeightsAbove.size() == pointsPerSide)
     {
         for(int i = 0; i < pointsPerSide; i++)
@@ -117,50 +203,66 @@ void Chunk::overwriteBorderHeights(const std::vector<double> &absoluteHeightsAbo
         }
     }
 }
-void Chunk::initializeTerrainColorMap(RGBAcolor snowColor, RGBAcolor rockColor, RGBAcolor grassColor, RGBAcolor sandColor, RGBAcolor waterColor)
+void Chunk::initializeTerrainColorMap(RGBAcolor snowColor, RGBAcolor rockColor, RGBAcolor grassColor, RGBAcolor sandColor,
+                                      RGBAcolor waterColor, ChunkVersion &v) const
 {
+    std::unordered_map<TerrainType, RGBAcolor> &terrainToColor = v.terrainToColor;
     terrainToColor[Snow] = snowColor;
     terrainToColor[Rock] = rockColor;
     terrainToColor[Grass] = grassColor;
     terrainToColor[Sand] = sandColor;
     terrainToColor[Water] = waterColor;
 }
-void Chunk::initializeSquareTerrainType()
+void Chunk::initializeSquareTerrainType(const ChunkVersion &v, ChunkSurface &surface) const
 {
-    for(int i = 0; i < pointsPerSide - 1; i++)
+    int squaresPerSide = pointsPerSide - 1;
+    surface.squareTerrainType = SharedRows<TerrainType>(squaresPerSide, squaresPerSide);
+    updateSquareTerrainType(v, surface, {0, 0, squaresPerSide - 1, squaresPerSide - 1});
+}
+void Chunk::updateSquareTerrainType(const ChunkVersion &v, ChunkSurface &surface, SquareRange squares) const
+{
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    SharedRows<TerrainType> &squareTerrainType = surface.squareTerrainType;
+    for(int i = squares.iMin; i <= squares.iMax; i++)
     {
-        squareTerrainType.emplace_back(std::vector<TerrainType>());
-        for(int j = 0; j < pointsPerSide - 1; j++)
+        for(int j = squares.jMin; j <= squares.jMax; j++)
         {
             double y = terrainPoints[i][j].y;
             if(y > snowLimit)
             {
-                squareTerrainType[i].push_back(Snow);
+                squareTerrainType[i][j] = Snow;
             }
             else if(y > rockLimit)
             {
-                squareTerrainType[i].push_back(Rock);
+                squareTerrainType[i][j] = Rock;
             }
             else if(y > grassLimit)
             {
-                squareTerrainType[i].push_back(Grass);
+                squareTerrainType[i][j] = Grass;
             }
             else
             {
-                squareTerrainType[i].push_back(Sand);
+                squareTerrainType[i][j] = Sand;
             }
         }
     }
 }
 
-void Chunk::initializeSquareColors()
+void Chunk::initializeSquareColors(const ChunkVersion &v, ChunkSurface &surface) const
+{
+    int squaresPerSide = pointsPerSide - 1;
+    surface.squareColors = SharedRows<RGBAcolor>(squaresPerSide, squaresPerSide);
+    updateSquareColors(v, surface, {0, 0, squaresPerSide - 1, squaresPerSide - 1});
+}
+void Chunk::updateSquareColors(const ChunkVersion &v, ChunkSurface &surface, SquareRange squares) const
 {
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    const std::unordered_map<TerrainType, RGBAcolor> &terrainToColor = v.terrainToColor;
+    SharedRows<RGBAcolor> &squareColors = surface.squareColors;
     RGBAcolor color;
-    squareColors = std::vector<std::vector<RGBAcolor>>();
-    for(int i = 0; i < pointsPerSide - 1; i++)
+    for(int i = squares.iMin; i <= squares.iMax; i++)
     {
-        squareColors.emplace_back(std::vector<RGBAcolor>());
-        for(int j = 0; j < pointsPerSide - 1; j++)
+        for(int j = squares.jMin; j <= squares.jMax; j++)
         {
             double y = terrainPoints[i][j].y;
             if(y > snowLimit)
@@ -188,40 +290,66 @@ void Chunk::initializeSquareColors()
                 color.g = color.g * (y/grassLimit + 0.5);
                 color.b = color.b * (y/grassLimit + 0.5);
             }
-            squareColors[i].push_back(color);
+            squareColors[i][j] = color;
         }
     }
 }
-void Chunk::initializeDrawWaterAt()
+void Chunk::initializeDrawWaterAt(const ChunkVersion &v, ChunkSurface &surface) const
 {
-    for(int i = 0; i < pointsPerSide - 1; i++)
+    int squaresPerSide = pointsPerSide - 1;
+    surface.drawWaterAt = SharedRows<bool>(squaresPerSide, squaresPerSide, false);
+    if(getHasWater(v))
     {
-        drawWaterAt.emplace_back(std::vector<bool>());
-        for(int j = 0; j < pointsPerSide - 1; j++)
+        updateDrawWaterAt(v, surface, {0, 0, squaresPerSide - 1, squaresPerSide - 1});
+    }
+}
+void Chunk::updateDrawWaterAt(const ChunkVersion &v, ChunkSurface &surface, SquareRange squares) const
+{
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    SharedRows<bool> &drawWaterAt = surface.drawWaterAt;
+    for(int i = squares.iMin; i <= squares.iMax; i++)
+    {
+        for(int j = squares.jMin; j <= squares.jMax; j++)
         {
-            if(terrainPoints[i][j].y < waterLevel || terrainPoints[i+1][j].y < waterLevel ||
-            terrainPoints[i][j+1].y < waterLevel || terrainPoints[i+1][j+1].y < waterLevel)
-            {
-                drawWaterAt[i].push_back(true);
-            }
-            else
-            {
-                drawWaterAt[i].push_back(false);
-            }
+            drawWaterAt[i][j] = terrainPoints[i][j].y < waterLevel || terrainPoints[i+1][j].y < waterLevel ||
+                                terrainPoints[i][j+1].y < waterLevel || terrainPoints[i+1][j+1].y < waterLevel;
         }
     }
 }
 void Chunk::initializeRandomCityCenter()
 {
-    RandomNumberGenerator rng;
+    RandomNumberGenerator rng(buildingSeed);
     double x = center.x - sideLength/4 + rng.getRandom()*sideLength/2;
     double z = center.z - sideLength/4 + rng.getRandom()*sideLength/2;
     cityCenter = {x, 0, z};
 }
-void Chunk::initializeBuildings()
+// The solids go in the store so the buildings can be drawn all at once
+static void addBuildingSolids(const Building &building, SolidStore &store)
+{
+    for(const std::shared_ptr<Solid> &s : building.getSolids())
+    {
+        std::shared_ptr<RecPrism> prism = std::dynamic_pointer_cast<RecPrism>(s);
+        if(prism)
+        {
+            store.addRecPrism(*prism);
+        }
+    }
+}
+void Chunk::initializeBuildings(const ChunkVersion &v, ChunkBuildings &b) const
 {
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    const SharedRows<Point> &upperNormals = v.physics->upperNormals;
+    const SharedRows<TerrainType> &squareTerrainType = v.surface->squareTerrainType;
+    std::vector<std::shared_ptr<Building>> &buildings = b.buildings;
+    b.buildingTop = -INFINITY;
     double buildingSideLength = sideLength / (pointsPerSide - 1);
-    RandomNumberGenerator rng;
+    // Skip the two numbers used for the city center
+    RandomNumberGenerator rng(buildingSeed);
+    rng.getRandom();
+    rng.getRandom();
+    double squareSize = sideLength / (pointsPerSide - 1.0);
+    b.buildingGrid = SpatialGrid(topLeft.x*sideLength, topLeft.z*sideLength, squareSize,
+                               pointsPerSide - 1, pointsPerSide - 1);
     double distanceFromCity, minHeight, maxHeight, terrainAngle, bottomY, height;
     bool closeEnough, flatEnough, randomFactor, isGrass;
     for(int i = 0; i < pointsPerSide - 1; i++)
@@ -240,17 +368,401 @@ void Chunk::initializeBuildings()
                 minHeight = fmax(50, 100 - 50*(distanceFromCity / (sideLength/4)));
                 maxHeight = fmax(150, 300 - 50*(distanceFromCity / (sideLength/4)));
                 height = rng.getRandom()*maxHeight + minHeight;
-                bottomY = getMinSquareHeight(i, j);
+                bottomY = getMinSquareHeight(*v.heights, i, j);
                 // Find the actual bottom of the base of the building
                 Point inputCenter = {terrainPoints[i][j].x + buildingSideLength/2, bottomY + height/2, terrainPoints[i][j].z + buildingSideLength/2};
                 buildings.push_back(std::make_shared<Building>(Building(inputCenter, buildingSideLength, height, {.5,.5,.5,1},{1,1,1,1}, PlainRectangle)));
+                b.buildingTop = fmax(b.buildingTop, bottomY + height);
+                b.buildingGrid.insert(buildings.size() - 1,
+                                    inputCenter.x - buildingSideLength/2, inputCenter.z - buildingSideLength/2,
+                                    inputCenter.x + buildingSideLength/2, inputCenter.z + buildingSideLength/2);
+                addBuildingSolids(*buildings.back(), b.buildingSolids);
             }
         }
     }
 }
+bool Chunk::reseatBuildings(const ChunkHeights &oldHeights, const ChunkVersion &v, SquareRange squares,
+                            ChunkBuildings &b) const
+{
+    double squareSize = sideLength / (pointsPerSide - 1.0);
+    // Each building stands on the square its center is in
+    std::vector<std::pair<int, int>> buildingSquares;
+    bool moved = false;
+    for(std::shared_ptr<Building> &building : b.buildings)
+    {
+        Point center = building->getCenter();
+        int i = floor((center.x - topLeft.x*sideLength) / squareSize);
+        int j = floor((center.z - topLeft.z*sideLength) / squareSize);
+        buildingSquares.emplace_back(i, j);
+        if(i < squares.iMin || i > squares.iMax || j < squares.jMin || j > squares.jMax)
+        {
+            continue;
+        }
+        double change = getMinSquareHeight(*v.heights, i, j) - getMinSquareHeight(oldHeights, i, j);
+        if(change != 0)
+        {
+            // Buildings are shared with older versions, so the moved one is a new building
+            center.y += change;
+            building = std::make_shared<Building>(center, building->getSideLength(), building->getHeight(),
+                                                  building->getColor(), building->getEdgeColor(),
+                                                  building->getBuildingType());
+            moved = true;
+        }
+    }
+    if(!moved)
+    {
+        return false;
+    }
+    // The footprints didn't move, so the grid stays the same
+    b.buildingTop = -INFINITY;
+    b.buildingSolids = SolidStore();
+    for(int k = 0; k < (int)b.buildings.size(); k++)
+    {
+        // The roof is as far above the center as the base is below it
+        double bottomY = getMinSquareHeight(*v.heights, buildingSquares[k].first, buildingSquares[k].second);
+        b.buildingTop = fmax(b.buildingTop, 2*b.buildings[k]->getCenter().y - bottomY);
+        addBuildingSolids(*b.buildings[k], b.buildingSolids);
+    }
+    return true;
+}
 
+// =================================
+//
+//           Chunk Stages
+//
+// =================================
 
+std::shared_ptr<ChunkVersion> Chunk::copyCurrentVersion() const
+{
+    return std::make_shared<ChunkVersion>(*current.load());
+}
+void Chunk::ensurePhysicsReady()
+{
+    if(stage >= PhysicsReady)
+    {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(stage >= PhysicsReady)
+    {
+        return; // another thread got here first
+    }
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    std::shared_ptr<ChunkPhysics> physics = std::make_shared<ChunkPhysics>();
+    initializeNormalVectors(*v->heights, *physics);
+    initializePlaneCoefficients(*v->heights, *physics);
+    v->physics = physics;
+    current.store(v);
+    stage = PhysicsReady;
+}
+void Chunk::ensureRenderReady()
+{
+    if(stage >= RenderReady)
+    {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(stage >= RenderReady)
+    {
+        return;
+    }
+    ensurePhysicsReady();
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    std::shared_ptr<ChunkSurface> surface = std::make_shared<ChunkSurface>();
+    initializeSquareTerrainType(*v, *surface);
+    initializeSquareColors(*v, *surface);
+    initializeDrawWaterAt(*v, *surface);
+    v->surface = surface;
+    current.store(v);
+    stage = RenderReady;
+}
+void Chunk::ensureMeshReady()
+{
+    if(stage >= MeshReady)
+    {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(stage >= MeshReady)
+    {
+        return;
+    }
+    ensureRenderReady();
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    std::shared_ptr<std::vector<float>> mesh = std::make_shared<std::vector<float>>(getMeshVertexCount(*v) * FLOATS_PER_VERTEX);
+    writeMesh(*v, mesh->data());
+    v->mesh = mesh;
+    current.store(v);
+    stage = MeshReady;
+}
+int Chunk::getMeshVertexCount(const ChunkVersion &v) const
+{
+    int squares = (pointsPerSide - 1)*(pointsPerSide - 1);
+    if(getHasWater(v))
+    {
+        const SharedRows<bool> &drawWaterAt = v.surface->drawWaterAt;
+        for(int i = 0; i < drawWaterAt.size(); i++)
+        {
+            squares += std::count(drawWaterAt[i].begin(), drawWaterAt[i].end(), true);
+        }
+    }
+    return 6*squares;
+}
+// One vertex of the mesh, FLOATS_PER_VERTEX floats
+static float *writeVertex(float *vertices, double x, double y, double z, RGBAcolor color)
+{
+    *vertices++ = x;
+    *vertices++ = y;
+    *vertices++ = z;
+    *vertices++ = color.r;
+    *vertices++ = color.g;
+    *vertices++ = color.b;
+    *vertices++ = color.a;
+    return vertices;
+}
+void Chunk::writeMesh(const ChunkVersion &v, float *vertices) const
+{
+    vertices = writeTerrainSquares(v, {0, 0, pointsPerSide - 2, pointsPerSide - 2}, vertices);
+    if(!getHasWater(v))
+    {
+        return;
+    }
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    const SharedRows<bool> &drawWaterAt = v.surface->drawWaterAt;
+    RGBAcolor waterColor = v.terrainToColor.at(Water);
+    for(int i = 0; i < pointsPerSide - 1; i++)
+    {
+        for(int j = 0; j < pointsPerSide - 1; j++)
+        {
+            if(drawWaterAt[i][j])
+            {
+                for(Point p : {terrainPoints[i][j], terrainPoints[i][j+1], terrainPoints[i+1][j+1],
+                               terrainPoints[i][j], terrainPoints[i+1][j+1], terrainPoints[i+1][j]})
+                {
+                    vertices = writeVertex(vertices, p.x, waterLevel, p.z, waterColor);
+                }
+            }
+        }
+    }
+}
+float *Chunk::writeTerrainSquares(const ChunkVersion &v, SquareRange squares, float *vertices) const
+{
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    const SharedRows<RGBAcolor> &squareColors = v.surface->squareColors;
+    // The same triangles drawTerrain() makes, with each square in its own color
+    for(int i = squares.iMin; i <= squares.iMax; i++)
+    {
+        for(int j = squares.jMin; j <= squares.jMax; j++)
+        {
+            RGBAcolor color = squareColors[i][j];
+            for(Point p : {terrainPoints[i][j], terrainPoints[i][j+1], terrainPoints[i+1][j],
+                           terrainPoints[i][j+1], terrainPoints[i+1][j], terrainPoints[i+1][j+1]})
+            {
+                vertices = writeVertex(vertices, p.x, p.y, p.z, color);
+            }
+        }
+    }
+    return vertices;
+}
+void Chunk::ensureBuildings()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(!hasCity || current.load()->buildings)
+    {
+        return;
+    }
+    // Buildings are only put on grass
+    ensureRenderReady();
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    std::shared_ptr<ChunkBuildings> b = std::make_shared<ChunkBuildings>();
+    initializeBuildings(*v, *b);
+    v->buildings = b;
+    current.store(v);
+}
+void Chunk::releaseBuildings()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(!current.load()->buildings)
+    {
+        return;
+    }
+    // The ChunkUploader deletes the batch's buffers on the drawing thread,
+    // whether or not the chunk is drawn again
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    v->buildings = nullptr;
+    current.store(v);
+}
+bool Chunk::deformTerrain(const TerrainBrush &brush)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    int squaresPerSide = pointsPerSide - 1;
+    double squareSize = sideLength / (pointsPerSide - 1.0);
+    // Points are placed by their index in the whole world's grid of points, so a
+    // point on a border is at exactly the same place for both chunks that have it
+    int firstI = topLeft.x*squaresPerSide, firstJ = topLeft.z*squaresPerSide;
+    int iMin = std::max(0, (int)ceil((brush.x - brush.radius) / squareSize) - firstI);
+    int iMax = std::min(squaresPerSide, (int)floor((brush.x + brush.radius) / squareSize) - firstI);
+    int jMin = std::max(0, (int)ceil((brush.z - brush.radius) / squareSize) - firstJ);
+    int jMax = std::min(squaresPerSide, (int)floor((brush.z + brush.radius) / squareSize) - firstJ);
+    if(iMin > iMax || jMin > jMax)
+    {
+        return false;
+    }
+
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    std::shared_ptr<const ChunkHeights> oldHeights = v->heights;
+    // The new parts share every row with the old ones except the rows the brush touches
+    std::shared_ptr<ChunkHeights> heights = std::make_shared<ChunkHeights>(*v->heights);
+    heights->terrainPoints.ownRows(iMin, iMax);
+    // The points that actually changed
+    int changedIMin = pointsPerSide, changedJMin = pointsPerSide, changedIMax = -1, changedJMax = -1;
+    for(int i = iMin; i <= iMax; i++)
+    {
+        for(int j = jMin; j <= jMax; j++)
+        {
+            double dx = (firstI + i)*squareSize - brush.x;
+            double dz = (firstJ + j)*squareSize - brush.z;
+            double distance2 = (dx*dx + dz*dz) / (brush.radius*brush.radius);
+            if(distance2 >= 1)
+            {
+                continue;
+            }
+            double falloff = (1 - distance2)*(1 - distance2);
+            double &y = heights->terrainPoints[i][j].y;
+            double newY = y;
+            if(brush.mode == Raise)
+            {
+                newY = y + brush.amount*falloff;
+            }
+            else if(brush.mode == Dig)
+            {
+                newY = y - brush.amount*falloff;
+            }
+            else if(brush.mode == Flatten)
+            {
+                newY = y + (brush.targetHeight - y)*fmin(1, brush.amount)*falloff;
+            }
+            if(newY != y)
+            {
+                y = newY;
+                changedIMin = std::min(changedIMin, i);
+                changedJMin = std::min(changedJMin, j);
+                changedIMax = std::max(changedIMax, i);
+                changedJMax = std::max(changedJMax, j);
+            }
+        }
+    }
+    if(changedIMax == -1)
+    {
+        return false;
+    }
+
+    // Every square with a changed corner
+    SquareRange squares = {std::max(0, changedIMin - 1), std::max(0, changedJMin - 1),
+                           std::min(squaresPerSide - 1, changedIMax), std::min(squaresPerSide - 1, changedJMax)};
+    heights->heightPyramid.update(heights->terrainPoints, squares.iMin, squares.jMin, squares.iMax, squares.jMax);
+    v->heights = heights;
+    v->version++;
+    if(v->physics)
+    {
+        std::shared_ptr<ChunkPhysics> physics = std::make_shared<ChunkPhysics>(*v->physics);
+        for(SharedRows<Point> *grid : {&physics->upperNormals, &physics->lowerNormals})
+        {
+            grid->ownRows(squares.iMin, squares.iMax);
+        }
+        for(SharedRows<double> *grid : {&physics->upperPlaneA, &physics->upperPlaneB, &physics->upperPlaneC,
+                                        &physics->lowerPlaneA, &physics->lowerPlaneB, &physics->lowerPlaneC})
+        {
+            grid->ownRows(squares.iMin, squares.iMax);
+        }
+        updateNormalVectors(*heights, *physics, squares);
+        updatePlaneCoefficients(*heights, *physics, squares);
+        v->physics = physics;
+    }
+    bool waterChanged = false;
+    if(v->surface)
+    {
+        std::shared_ptr<ChunkSurface> surface = std::make_shared<ChunkSurface>(*v->surface);
+        surface->squareTerrainType.ownRows(squares.iMin, squares.iMax);
+        surface->squareColors.ownRows(squares.iMin, squares.iMax);
+        surface->drawWaterAt.ownRows(squares.iMin, squares.iMax);
+        updateSquareTerrainType(*v, *surface, squares);
+        updateSquareColors(*v, *surface, squares);
+        updateDrawWaterAt(*v, *surface, squares);
+        for(int i = squares.iMin; i <= squares.iMax && !waterChanged; i++)
+        {
+            for(int j = squares.jMin; j <= squares.jMax && !waterChanged; j++)
+            {
+                waterChanged = surface->drawWaterAt[i][j] != v->surface->drawWaterAt[i][j];
+            }
+        }
+        v->surface = surface;
+    }
+    if(v->buildings)
+    {
+        // So the buildings don't float over a dug square or sink into a raised one
+        std::shared_ptr<ChunkBuildings> b = std::make_shared<ChunkBuildings>(*v->buildings);
+        if(reseatBuildings(*oldHeights, *v, squares, *b))
+        {
+            v->buildings = b;
+        }
+    }
 
+    // The water is at the end of the mesh, and where it starts depends on how
+    // much of it there is, so a change to the water means sending it all again
+    ChunkStage newStage = stage;
+    if(stage >= MeshReady)
+    {
+        if(!waterChanged && (stage == Uploaded || v->meshPatch))
+        {
+            SquareRange patchSquares = squares;
+            if(v->meshPatch)
+            {
+                // It hasn't been sent since the last edit
+                const SquareRange &previous = v->meshPatch->squares;
+                patchSquares = {std::min(squares.iMin, previous.iMin), std::min(squares.jMin, previous.jMin),
+                                std::max(squares.iMax, previous.iMax), std::max(squares.jMax, previous.jMax)};
+            }
+            std::shared_ptr<ChunkMeshPatch> patch = std::make_shared<ChunkMeshPatch>();
+            patch->squares = patchSquares;
+            patch->vertices = std::vector<float>((patchSquares.iMax - patchSquares.iMin + 1) *
+                                                 (patchSquares.jMax - patchSquares.jMin + 1) * 6 * FLOATS_PER_VERTEX);
+            writeTerrainSquares(*v, patchSquares, patch->vertices.data());
+            v->meshPatch = patch;
+            newStage = MeshReady;
+        }
+        else
+        {
+            v->mesh = nullptr;
+            v->meshPatch = nullptr;
+            newStage = RenderReady;
+        }
+    }
+    current.store(v);
+    stage = newStage;
+    return true;
+}
+void Chunk::updateTerrainColors(RGBAcolor snowColor, RGBAcolor rockColor, RGBAcolor grassColor,
+                                RGBAcolor sandColor, RGBAcolor waterColor)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    initializeTerrainColorMap(snowColor, rockColor, grassColor, sandColor, waterColor, *v);
+    if(v->surface)
+    {
+        std::shared_ptr<ChunkSurface> surface = std::make_shared<ChunkSurface>(*v->surface);
+        initializeSquareColors(*v, *surface);
+        v->surface = surface;
+        // The old colors are baked into the mesh and the vertex buffer (or display list)
+        v->mesh = nullptr;
+        v->meshPatch = nullptr;
+    }
+    current.store(v);
+    if(stage >= RenderReady)
+    {
+        stage = RenderReady;
+    }
+}
 
 // Getters
 Point2D Chunk::getTopLeft() const
@@ -273,8 +785,56 @@ double Chunk::getPerlinSeed() const
 {
     return perlinSeed;
 }
+int Chunk::getPointsPerSide() const
+{
+    return pointsPerSide;
+}
+std::shared_ptr<const ChunkVersion> Chunk::getCurrentVersion() const
+{
+    return current.load();
+}
+int Chunk::getVersion() const
+{
+    return current.load()->version;
+}
+ChunkStage Chunk::getStage() const
+{
+    return stage;
+}
+bool Chunk::getHasCity() const
+{
+    return hasCity;
+}
+double Chunk::getMinHeight() const
+{
+    return current.load()->heights->heightPyramid.getMinHeight();
+}
+double Chunk::getMaxHeight() const
+{
+    return current.load()->heights->heightPyramid.getMaxHeight();
+}
+double Chunk::getTopHeight() const
+{
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    double buildingTop = v->buildings ? v->buildings->buildingTop : -INFINITY;
+    return fmax(v->heights->heightPyramid.getMaxHeight(), buildingTop);
+}
+bool Chunk::getHasWater() const
+{
+    return getHasWater(*current.load());
+}
+bool Chunk::getHasWater(const ChunkVersion &v) const
+{
+    return v.heights->heightPyramid.getMinHeight() < waterLevel;
+}
+bool Chunk::getBuildingsInitialized() const
+{
+    return current.load()->buildings != nullptr;
+}
 std::vector<double> Chunk::getTopTerrainHeights(bool isRelative) const
 {
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    const SharedRows<Point> &terrainPoints = v->heights->terrainPoints;
     std::vector<double> top;
     for(int i = 0; i < pointsPerSide; i++)
     {
@@ -291,6 +851,8 @@ std::vector<double> Chunk::getTopTerrainHeights(bool isRelative) const
 }
 std::vector<double> Chunk::getBottomTerrainHeights(bool isRelative) const
 {
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    const SharedRows<Point> &terrainPoints = v->heights->terrainPoints;
     std::vector<double> bottom;
     for(int i = 0; i < pointsPerSide; i++)
     {
@@ -307,6 +869,8 @@ std::vector<double> Chunk::getBottomTerrainHeights(bool isRelative) const
 }
 std::vector<double> Chunk::getLeftTerrainHeights(bool isRelative) const
 {
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    const SharedRows<Point> &terrainPoints = v->heights->terrainPoints;
     std::vector<double> left;
     for(int j = 0; j < pointsPerSide; j++)
     {
@@ -323,6 +887,8 @@ std::vector<double> Chunk::getLeftTerrainHeights(bool isRelative) const
 }
 std::vector<double> Chunk::getRightTerrainHeights(bool isRelative) const
 {
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    const SharedRows<Point> &terrainPoints = v->heights->terrainPoints;
     std::vector<double> right;
     for(int j = 0; j < pointsPerSide; j++)
     {
@@ -339,34 +905,96 @@ std::vector<double> Chunk::getRightTerrainHeights(bool isRelative) const
 }
 
 
-double Chunk::getHeightAt(Point p) const
+double Chunk::getHeightAt(Point p)
+{
+    double height;
+    getHeightsAt(&p.x, &p.z, &height, 1);
+    return height;
+}
+void Chunk::getHeightsAt(const double *xs, const double *zs, double *heights, int count)
 {
+    ensurePhysicsReady();
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    const SharedRows<Point> &terrainPoints = v->heights->terrainPoints;
+    const SharedRows<double> &upperPlaneA = v->physics->upperPlaneA, &upperPlaneB = v->physics->upperPlaneB,
+                             &upperPlaneC = v->physics->upperPlaneC;
+    const SharedRows<double> &lowerPlaneA = v->physics->lowerPlaneA, &lowerPlaneB = v->physics->lowerPlaneB,
+                             &lowerPlaneC = v->physics->lowerPlaneC;
+    int squaresPerSide = pointsPerSide - 1;
     double squareSize = sideLength / (pointsPerSide-1.0);
-    int topLeftI = (p.x - topLeft.x*sideLength) / squareSize;
-    int topLeftJ = (p.z - topLeft.z*sideLength) / squareSize;
-    Point squareTopLeft = terrainPoints[topLeftI][topLeftJ];
-    Point squareBottomRight = terrainPoints[topLeftI+1][topLeftJ+1];
-    if(distance2d(squareTopLeft, p) < distance2d(squareBottomRight, p))
+    double originX = terrainPoints[0][0].x;
+    double originZ = terrainPoints[0][0].z;
+
+    // Which square the point is in, clamped so points on the far edges still work
+    auto findSquare = [&](double x, double z, int &i, int &j, double &squareX, double &squareZ)
     {
-        Point normal = upperNormals[topLeftI][topLeftJ];
-        double b = normal.y;
-        if(b != 0)
-        {
-            return (dotProduct(normal, squareTopLeft) - normal.x*p.x - normal.z*p.z) / b;
-        }
-        return squareTopLeft.y;
+        i = std::max(0, std::min(squaresPerSide - 1, (int)((x - originX) / squareSize)));
+        j = std::max(0, std::min(squaresPerSide - 1, (int)((z - originZ) / squareSize)));
+        squareX = originX + i*squareSize;
+        squareZ = originZ + j*squareSize;
+    };
+
+    int k = 0;
+#ifdef __SSE2__
+    __m128d size = _mm_set1_pd(squareSize);
+    for(; k + 2 <= count; k += 2)
+    {
+        int i0, j0, i1, j1;
+        double squareX0, squareZ0, squareX1, squareZ1;
+        findSquare(xs[k], zs[k], i0, j0, squareX0, squareZ0);
+        findSquare(xs[k+1], zs[k+1], i1, j1, squareX1, squareZ1);
+        __m128d x = _mm_loadu_pd(xs + k);
+        __m128d z = _mm_loadu_pd(zs + k);
+
+        // Compare the squared distances to the top left and bottom right corners
+        __m128d u = _mm_sub_pd(x, _mm_set_pd(squareX1, squareX0));
+        __m128d v = _mm_sub_pd(z, _mm_set_pd(squareZ1, squareZ0));
+        __m128d uFar = _mm_sub_pd(size, u);
+        __m128d vFar = _mm_sub_pd(size, v);
+        __m128d distanceTopLeft = _mm_add_pd(_mm_mul_pd(u, u), _mm_mul_pd(v, v));
+        __m128d distanceBottomRight = _mm_add_pd(_mm_mul_pd(uFar, uFar), _mm_mul_pd(vFar, vFar));
+        __m128d useUpper = _mm_cmplt_pd(distanceTopLeft, distanceBottomRight);
+
+        __m128d upper = _mm_add_pd(_mm_set_pd(upperPlaneA[i1][j1], upperPlaneA[i0][j0]),
+                        _mm_add_pd(_mm_mul_pd(_mm_set_pd(upperPlaneB[i1][j1], upperPlaneB[i0][j0]), x),
+                                   _mm_mul_pd(_mm_set_pd(upperPlaneC[i1][j1], upperPlaneC[i0][j0]), z)));
+        __m128d lower = _mm_add_pd(_mm_set_pd(lowerPlaneA[i1][j1], lowerPlaneA[i0][j0]),
+                        _mm_add_pd(_mm_mul_pd(_mm_set_pd(lowerPlaneB[i1][j1], lowerPlaneB[i0][j0]), x),
+                                   _mm_mul_pd(_mm_set_pd(lowerPlaneC[i1][j1], lowerPlaneC[i0][j0]), z)));
+        _mm_storeu_pd(heights + k, _mm_or_pd(_mm_and_pd(useUpper, upper), _mm_andnot_pd(useUpper, lower)));
     }
-    else
+#endif
+    for(; k < count; k++)
     {
-        Point normal = lowerNormals[topLeftI][topLeftJ];
-        double b = normal.y;
-        if(b != 0)
+        int i, j;
+        double squareX, squareZ;
+        findSquare(xs[k], zs[k], i, j, squareX, squareZ);
+        double u = xs[k] - squareX, v = zs[k] - squareZ;
+        double uFar = squareSize - u, vFar = squareSize - v;
+        if(u*u + v*v < uFar*uFar + vFar*vFar)
+        {
+            heights[k] = upperPlaneA[i][j] + upperPlaneB[i][j]*xs[k] + upperPlaneC[i][j]*zs[k];
+        }
+        else
         {
-            return (dotProduct(normal, squareBottomRight) - normal.x*p.x - normal.z*p.z) / b;
+            heights[k] = lowerPlaneA[i][j] + lowerPlaneB[i][j]*xs[k] + lowerPlaneC[i][j]*zs[k];
         }
-        return squareBottomRight.y;
     }
 }
+std::vector<std::shared_ptr<Building>> Chunk::getBuildingsNear(Point p, double radius) const
+{
+    std::vector<std::shared_ptr<Building>> result;
+    std::shared_ptr<const ChunkVersion> v = current.load();
+    if(!v->buildings)
+    {
+        return result;
+    }
+    for(int index : v->buildings->buildingGrid.query(p.x - radius, p.z - radius, p.x + radius, p.z + radius))
+    {
+        result.push_back(v->buildings->buildings[index]);
+    }
+    return result;
+}
 double Chunk::relativeToAbsoluteHeight(double y) const
 {
     return perlinSeed*heightScaleFactor*(y + 1);
@@ -375,8 +1003,9 @@ double Chunk::absoluteToRelativeHeight(double y) const
 {
     return y / (perlinSeed*heightScaleFactor) - 1;
 }
-double Chunk::getMinSquareHeight(int i, int j) const
+double Chunk::getMinSquareHeight(const ChunkHeights &heights, int i, int j)
 {
+    const SharedRows<Point> &terrainPoints = heights.terrainPoints;
     double topMin = fmin(terrainPoints[i][j].y, terrainPoints[i+1][j].y);
     double bottomMin = fmin(terrainPoints[i][j+1].y, terrainPoints[i+1][j+1].y);
     return fmin(topMin, bottomMin);
@@ -384,8 +1013,9 @@ double Chunk::getMinSquareHeight(int i, int j) const
 
 
 
-RGBAcolor Chunk::chooseColor(double y) const
+RGBAcolor Chunk::chooseColor(const ChunkVersion &v, double y) const
 {
+    const std::unordered_map<TerrainType, RGBAcolor> &terrainToColor = v.terrainToColor;
     double r,g,b,a;
     RGBAcolor currentColor;
     if(y > snowLimit)
@@ -411,53 +1041,3 @@ RGBAcolor Chunk::chooseColor(double y) const
     a = currentColor.a;
     return {r, g, b,a};
 }
-void Chunk::draw() const
-{
-    glDisable(GL_CULL_FACE);
-    glShadeModel( GL_FLAT );
-    for(int j = 0; j < pointsPerSide - 1; j++)
-    {
-        setGLColor(squareColors[0][j]);
-        glBegin(GL_TRIANGLE_STRIP);
-        drawPoint(terrainPoints[0][j]);
-        drawPoint(terrainPoints[0][j+1]);
-        for(int i = 1; i < pointsPerSide; i++)
-        {
-            setGLColor(squareColors[i-1][j]);
-            drawPoint(terrainPoints[i][j]);
-            drawPoint(terrainPoints[i][j+1]);
-        }
-        glEnd();
-    }
-
-    glShadeModel( GL_SMOOTH );
-    drawWater();
-
-    glEnable(GL_CULL_FACE);
-
-    for(std::shared_ptr<Building> b : buildings)
-    {
-        b->draw();
-    }
-}
-
-void Chunk::drawWater() const
-{
-    setGLColor(terrainToColor.at(Water));
-    glBegin(GL_QUADS);
-    for(int i = 0; i < pointsPerSide - 1; i++)
-    {
-        for(int j = 0; j < pointsPerSide; j++)
-        {
-            if(drawWaterAt[i][j])
-            {
-                glVertex3f(terrainPoints[i][j].x, waterLevel, terrainPoints[i][j].z);
-                glVertex3f(terrainPoints[i][j+1].x, waterLevel, terrainPoints[i][j+1].z);
-                glVertex3f(terrainPoints[i+1][j+1].x, waterLevel, terrainPoints[i+1][j+1].z);
-                glVertex3f(terrainPoints[i+1][j].x, waterLevel, terrainPoints[i+1][j].z);
-
-            }
-        }
-    }
-    glEnd();
-}
\ No newline at end of file
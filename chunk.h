@@ -6,14 +6,117 @@
 #include <stdlib.h>
 #include <time.h>
 #include <unordered_map>
-#include "graphics.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "structs.h"
 #include "mathHelper.h"
 #include "building.h"
+#include "solidStore.h"
+#include "spatialGrid.h"
+#include "heightPyramid.h"
+#include "sharedRows.h"
 #include "randomNumberGenerator.h"
+#include "snapshotPointer.h"
+
+struct ChunkGraphics;
 
 enum TerrainType {Snow, Grass, Rock, Sand, Water};
 
+// How an edit changes the heights inside its brush
+enum BrushMode {Raise,    // add amount at the center
+                Dig,      // take away amount at the center
+                Flatten}; // move toward targetHeight, all the way at the center if amount is 1
+
+// A circle in the xz plane, in world coordinates. An edit changes the heights
+// the most at the center and fades out to nothing at the radius.
+struct TerrainBrush
+{
+    double x, z;
+    double radius;
+    BrushMode mode;
+    double amount;
+    double targetHeight; // only for Flatten
+};
+
+// Terrain squares iMin to iMax and jMin to jMax, inclusive
+struct SquareRange
+{
+    int iMin, jMin, iMax, jMax;
+};
+
+// A chunk is built in stages, and each stage is only computed the first time
+// something needs it. Only the heights are made when the chunk is created.
+// PhysicsReady: normal vectors, so getHeightAt() works
+// RenderReady:  terrain types, colors, and water
+// MeshReady:    the terrain and water as triangles in memory, usually made by
+//               a chunk worker
+// Uploaded:     the mesh is in the chunk's vertex buffer, and freed from memory.
+//               The ChunkUploader decides when. Only graphics cards without
+//               vertex buffers get a display list instead.
+enum ChunkStage {HeightsOnly, PhysicsReady, RenderReady, MeshReady, Uploaded};
+
+// The parts of a chunk that can change after it is made. A part is never
+// changed once something can see it. Changing a chunk makes new parts and
+// publishes a new ChunkVersion, which shares the parts that didn't change.
+// The grids are SharedRows, so a new part also shares the rows that didn't change.
+struct ChunkHeights
+{
+    SharedRows<Point> terrainPoints;
+    // Min and max heights of the terrain, for skipping whole regions at once
+    HeightPyramid heightPyramid;
+};
+struct ChunkPhysics
+{
+    // Store the normal vector of the plane containing each triangle
+    SharedRows<Point> upperNormals;
+    SharedRows<Point> lowerNormals;
+    // The plane of each triangle as y = a + b*x + c*z, so heights can be
+    // found without any square roots or divisions
+    SharedRows<double> upperPlaneA, upperPlaneB, upperPlaneC;
+    SharedRows<double> lowerPlaneA, lowerPlaneB, lowerPlaneC;
+};
+struct ChunkSurface
+{
+    SharedRows<TerrainType> squareTerrainType;
+    SharedRows<RGBAcolor> squareColors;
+    SharedRows<bool> drawWaterAt;
+};
+// The terrain squares of an Uploaded mesh that changed since it was uploaded,
+// so only those parts of the vertex buffer are sent again. The vertices are the
+// squares' triangles, row by row.
+struct ChunkMeshPatch
+{
+    SquareRange squares;
+    std::vector<float> vertices;
+};
+struct ChunkBuildings
+{
+    std::vector<std::shared_ptr<Building>> buildings;
+    double buildingTop; // the highest roof, or -INFINITY with no buildings
+    // Which buildings are in each terrain square, for collisions
+    SpatialGrid buildingGrid;
+    // The buildings' solids as arrays, for drawing them all at once
+    SolidStore buildingSolids;
+};
+struct ChunkVersion
+{
+    // Goes up every time the terrain changes, so anything cached from it
+    // (like the pathfinder's cost grids) can tell when it is out of date
+    int version;
+    std::unordered_map<TerrainType, RGBAcolor> terrainToColor;
+    std::shared_ptr<const ChunkHeights> heights;
+    std::shared_ptr<const ChunkPhysics> physics;     // nullptr until PhysicsReady
+    std::shared_ptr<const ChunkSurface> surface;     // nullptr until RenderReady
+    std::shared_ptr<const std::vector<float>> mesh;  // only kept from MeshReady until Uploaded
+    std::shared_ptr<const ChunkMeshPatch> meshPatch; // the changes to send instead of mesh, if there were edits
+    std::shared_ptr<const ChunkBuildings> buildings; // nullptr unless the buildings are made
+};
+
+// Any thread can read a chunk without a lock, and always sees one whole
+// version of it. Changing a chunk holds the chunk's lock while it makes and
+// publishes the new version. Old versions are freed once nothing holds them.
+// GL objects are only made, used, and deleted by the drawing thread.
 class Chunk
 {
 private:
@@ -26,11 +129,6 @@ private:
     int pointsPerSide;
     double heightScaleFactor;  // The average height of terrain in the world
     double perlinSeed;         // The average height of this chunk
-    std::vector<std::vector<Point>> terrainPoints;
-    // Store the normal vector of the plane containing each triangle
-    std::vector<std::vector<Point>> upperNormals;
-    std::vector<std::vector<Point>> lowerNormals;
-
 
     Point center;   // The actual center (y-coordinate = 0)
 
@@ -41,13 +139,28 @@ private:
     double rockLimit;  // draw rock above here
     double grassLimit; // draw grass above here, sand below
     double waterLevel;
-    std::vector<std::vector<TerrainType>> squareTerrainType;
-    std::unordered_map<TerrainType, RGBAcolor> terrainToColor;
-    std::vector<std::vector<RGBAcolor>> squareColors;
-    std::vector<std::vector<bool>> drawWaterAt;
 
-    std::vector<std::shared_ptr<Building>> buildings;
+    bool hasCity;
     Point cityCenter; // where the game tries to put buildings within this chunk
+    // Buildings are only made while the chunk is close to the player. The seed
+    // makes them come out the same every time they are made. A negative seed
+    // given to the constructor picks one from the shared generator.
+    int buildingSeed;
+
+    SnapshotPointer<ChunkVersion> current;
+    std::atomic<ChunkStage> stage;
+    // Only held by threads changing the chunk. The stage functions call each
+    // other, so the same thread can lock more than once.
+    std::recursive_mutex mutex;
+
+    // What the renderer drew the chunk with, made the first time it is uploaded.
+    // Only used by the drawing thread.
+    std::shared_ptr<ChunkGraphics> graphics;
+
+    // A copy of the current version, to change and publish as the next one.
+    // The chunk's lock has to be held from this until the publish.
+    std::shared_ptr<ChunkVersion> copyCurrentVersion() const;
+    bool getHasWater(const ChunkVersion &v) const;
 
 public:
     Chunk();
@@ -57,20 +170,80 @@ public:
           const std::vector<double> &absoluteHeightsLeft, const std::vector<double> &absoluteHeightsRight,
           double inputSnowLimit, double inputRockLimit, double inputGrassLimit, double inputWaterLevel,
           RGBAcolor inputSnowColor, RGBAcolor inputRockColor, RGBAcolor inputGrassColor, RGBAcolor inputSandColor,
-          RGBAcolor inputWaterColor, bool hasCity);
+          RGBAcolor inputWaterColor, bool inputHasCity, int inputBuildingSeed = -1);
+    // The graphics can't be shared between copies
+    Chunk(const Chunk &) = delete;
+    Chunk &operator=(const Chunk &) = delete;
 
     void initializeCenter();
     void initializeChunkID();
-    void initializeTerrainPoints(std::vector<std::vector<double>> terrainHeights);
-    void initializeNormalVectors();
+    void initializeTerrainPoints(std::vector<std::vector<double>> terrainHeights, ChunkHeights &heights) const;
+    // The update functions redo only the given squares of grids that were already initialized
+    void initializeNormalVectors(const ChunkHeights &heights, ChunkPhysics &physics) const;
+    void updateNormalVectors(const ChunkHeights &heights, ChunkPhysics &physics, SquareRange squares) const;
+    void initializePlaneCoefficients(const ChunkHeights &heights, ChunkPhysics &physics) const;
+    void updatePlaneCoefficients(const ChunkHeights &heights, ChunkPhysics &physics, SquareRange squares) const;
     void overwriteBorderHeights(const std::vector<double> &absoluteHeightsAbove, const std::vector<double> &absoluteHeightsBelow,
-                                const std::vector<double> &absoluteHeightsLeft, const std::vector<double> &absoluteHeightsRight);
-    void initializeTerrainColorMap(RGBAcolor snowColor, RGBAcolor rockColor, RGBAcolor grassColor, RGBAcolor sandColor, RGBAcolor waterColor);
-    void initializeSquareTerrainType();
-    void initializeSquareColors();
-    void initializeDrawWaterAt();
+                                const std::vector<double> &absoluteHeightsLeft, const std::vector<double> &absoluteHeightsRight,
+                                ChunkHeights &heights) const;
+    void initializeTerrainColorMap(RGBAcolor snowColor, RGBAcolor rockColor, RGBAcolor grassColor, RGBAcolor sandColor,
+                                   RGBAcolor waterColor, ChunkVersion &v) const;
+    void initializeSquareTerrainType(const ChunkVersion &v, ChunkSurface &surface) const;
+    void updateSquareTerrainType(const ChunkVersion &v, ChunkSurface &surface, SquareRange squares) const;
+    void initializeSquareColors(const ChunkVersion &v, ChunkSurface &surface) const;
+    void updateSquareColors(const ChunkVersion &v, ChunkSurface &surface, SquareRange squares) const;
+    void initializeDrawWaterAt(const ChunkVersion &v, ChunkSurface &surface) const;
+    void updateDrawWaterAt(const ChunkVersion &v, ChunkSurface &surface, SquareRange squares) const;
     void initializeRandomCityCenter();
-    void initializeBuildings();
+    void initializeBuildings(const ChunkVersion &v, ChunkBuildings &b) const;
+    // Move the buildings on the given squares up or down as much as the lowest
+    // corner of their square moved when the heights changed from oldHeights to
+    // v's. Returns false if none of them moved.
+    bool reseatBuildings(const ChunkHeights &oldHeights, const ChunkVersion &v, SquareRange squares,
+                         ChunkBuildings &b) const;
+
+    // Compute whatever stages are missing up to the requested one
+    void ensurePhysicsReady();
+    void ensureRenderReady();
+    void ensureMeshReady();
+    // Compiles a display list, for graphics cards without vertex buffers.
+    // uploadMesh() calls it then, and otherwise it isn't used.
+    void ensureUploaded();
+
+    // The terrain and water of a RenderReady version as triangles,
+    // FLOATS_PER_VERTEX floats per vertex (x, y, z, r, g, b, a)
+    const static int FLOATS_PER_VERTEX = 7;
+    int getMeshVertexCount(const ChunkVersion &v) const;
+    void writeMesh(const ChunkVersion &v, float *vertices) const;
+    // Only the terrain triangles of the given squares, row by row.
+    // Returns the end of what was written.
+    float *writeTerrainSquares(const ChunkVersion &v, SquareRange squares, float *vertices) const;
+    // Make the chunk Uploaded. The mesh is made MeshReady if it isn't yet, then
+    // sent straight from memory into the chunk's vertex buffer, or compiled into
+    // a display list without vertex buffers. Returns the number of bytes sent,
+    // or 0 if it was already Uploaded.
+    long uploadMesh();
+    // The vertex buffer read back from the graphics card, to check what was
+    // uploaded. Empty if the chunk has no vertex buffer.
+    std::vector<float> readUploadedMesh() const;
+    // Delete the GL objects the chunk was drawn with, while the context is
+    // still current. It is uploaded again if it is drawn after this.
+    void releaseGraphics();
+
+    // Buildings are made and released based on distance to the player
+    void ensureBuildings();
+    void releaseBuildings();
+
+    // Change the heights inside the brush. Only the squares the brush reaches are
+    // redone, and only their part of the mesh is uploaded again. Every chunk
+    // the brush reaches has to get the same edit, so the borders still match.
+    // Returns false if nothing in this chunk changed.
+    bool deformTerrain(const TerrainBrush &brush);
+
+    // Change the terrain colors. Colors that were already computed are redone,
+    // and the chunk is uploaded again. It is drawn in the old colors until then.
+    void updateTerrainColors(RGBAcolor snowColor, RGBAcolor rockColor, RGBAcolor grassColor,
+                             RGBAcolor sandColor, RGBAcolor waterColor);
 
     // Getters
     Point2D getTopLeft() const;
@@ -78,6 +251,19 @@ public:
     Point getCenter() const;
     int getChunkID();
     double getPerlinSeed() const;
+    int getPointsPerSide() const;
+    // Everything about the chunk that can change, as one consistent version.
+    // It stays the same for as long as it is held, even if the chunk changes.
+    std::shared_ptr<const ChunkVersion> getCurrentVersion() const;
+    int getVersion() const;
+    ChunkStage getStage() const;
+    bool getHasCity() const;
+    // Summaries of the whole chunk, from the height pyramid
+    double getMinHeight() const;
+    double getMaxHeight() const;
+    double getTopHeight() const; // the max height including buildings
+    bool getHasWater() const;
+    bool getBuildingsInitialized() const;
     std::vector<double> getTopTerrainHeights(bool isRelative) const;
     std::vector<double> getBottomTerrainHeights(bool isRelative) const;
     std::vector<double> getLeftTerrainHeights(bool isRelative) const;
@@ -85,19 +271,34 @@ public:
 
     // Returns the height of the terrain at the given point,
     // assuming that the point is in this chunk
-    double getHeightAt(Point p) const;
+    double getHeightAt(Point p);
+    // The same for count points at once, stored as separate x and z arrays
+    void getHeightsAt(const double *xs, const double *zs, double *heights, int count);
+
+    // The buildings whose footprints come within radius of p in the xz plane
+    std::vector<std::shared_ptr<Building>> getBuildingsNear(Point p, double radius) const;
 
     // Check the 4 corners for the lowest height
-    double getMinSquareHeight(int i, int j) const;
+    static double getMinSquareHeight(const ChunkHeights &heights, int i, int j);
 
     // Use the perlin seed and the height scale factor to convert a double
     // between 0 and 1 (the relative height) to the actual height
     double relativeToAbsoluteHeight(double y) const;
     double absoluteToRelativeHeight(double y) const;
 
-    RGBAcolor chooseColor(double y) const;
-    void draw() const;
-    void drawWater() const;
+    RGBAcolor chooseColor(const ChunkVersion &v, double y) const;
+
+    // Uploading and drawing are in chunkGraphics.cpp, which is part of the
+    // renderer, so the rest of the chunk doesn't need OpenGL.
+    // Draws whatever was uploaded last, so nothing until the chunk is first Uploaded
+    void draw();
+    void drawTerrain(const ChunkVersion &v) const;
+    void drawWater(const ChunkVersion &v) const;
+    void drawBuildings();
+    // Build the instanced batch of the buildings if they changed since it was
+    // built, or release it if they were released. Returns whether the chunk
+    // has a batch now.
+    bool updateBuildingBatch();
 };
 
 #endif //RANDOM_TERRAIN_CHUNK_H
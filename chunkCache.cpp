@@ -0,0 +1,143 @@
+#include "chunkCache.h"
+
+ChunkCache::Table::Table(int numBuckets) : buckets(numBuckets)
+{
+    for(std::atomic<const Node*> &bucket : buckets)
+    {
+        bucket = nullptr;
+    }
+}
+ChunkCache::Table::~Table()
+{
+    for(std::atomic<const Node*> &bucket : buckets)
+    {
+        const Node *node = bucket.load();
+        while(node != nullptr)
+        {
+            const Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+}
+const ChunkCache::Node *ChunkCache::Table::find(int chunkID) const
+{
+    const Node *node = buckets[hash(chunkID) & (buckets.size() - 1)].load(std::memory_order_acquire);
+    while(node != nullptr && node->chunkID != chunkID)
+    {
+        node = node->next;
+    }
+    return node;
+}
+void ChunkCache::Table::add(int chunkID, const std::shared_ptr<Chunk> &chunk)
+{
+    std::atomic<const Node*> &bucket = buckets[hash(chunkID) & (buckets.size() - 1)];
+    // Readers only see the node once it is filled in
+    bucket.store(new Node{chunkID, chunk, bucket.load(std::memory_order_relaxed)}, std::memory_order_release);
+}
+
+ChunkCache::ChunkCache()
+{
+    for(Shard &shard : shards)
+    {
+        shard.table = new Table(INITIAL_BUCKETS);
+        shard.size = 0;
+    }
+    numChunks = 0;
+}
+ChunkCache::~ChunkCache()
+{
+    for(Shard &shard : shards)
+    {
+        delete shard.table.load();
+    }
+}
+
+unsigned int ChunkCache::hash(int chunkID)
+{
+    // Neighboring chunks have IDs close together, so spread them out
+    return static_cast<unsigned int>(chunkID) * 2654435761u;
+}
+int ChunkCache::getShardIndex(int chunkID)
+{
+    // The low bits pick the bucket, so use high ones for the shard
+    return (hash(chunkID) >> 16) % NUM_SHARDS;
+}
+
+std::shared_ptr<Chunk> ChunkCache::find(int chunkID) const
+{
+    EpochGuard guard;
+    const Node *node = shards[getShardIndex(chunkID)].table.load()->find(chunkID);
+    return node == nullptr ? nullptr : node->chunk;
+}
+bool ChunkCache::contains(int chunkID) const
+{
+    return find(chunkID) != nullptr;
+}
+int ChunkCache::size() const
+{
+    return numChunks;
+}
+void ChunkCache::forEach(const std::function<void(const std::shared_ptr<Chunk>&)> &f) const
+{
+    for(const Shard &shard : shards)
+    {
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        {
+            EpochGuard guard;
+            const Table *table = shard.table.load();
+            for(const std::atomic<const Node*> &bucket : table->buckets)
+            {
+                for(const Node *node = bucket.load(std::memory_order_acquire); node != nullptr; node = node->next)
+                {
+                    chunks.push_back(node->chunk);
+                }
+            }
+        }
+        // f can take as long as it needs without holding up reclamation
+        for(const std::shared_ptr<Chunk> &c : chunks)
+        {
+            f(c);
+        }
+    }
+}
+
+bool ChunkCache::publish(int chunkID, const std::shared_ptr<Chunk> &chunk)
+{
+    Shard &shard = shards[getShardIndex(chunkID)];
+    const Table *oldTable = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        Table *table = shard.table.load();
+        if(table->find(chunkID) != nullptr)
+        {
+            return false;
+        }
+        if(shard.size >= (int)table->buckets.size())
+        {
+            // Readers may still be in the old table's lists, so the nodes are copied
+            Table *bigger = new Table(table->buckets.size() * 2);
+            for(std::atomic<const Node*> &bucket : table->buckets)
+            {
+                for(const Node *node = bucket.load(); node != nullptr; node = node->next)
+                {
+                    bigger->add(node->chunkID, node->chunk);
+                }
+            }
+            oldTable = table;
+            table = bigger;
+            shard.table = bigger;
+        }
+        table->add(chunkID, chunk);
+        shard.size++;
+        numChunks++;
+    }
+    if(oldTable != nullptr)
+    {
+        retireAfterReaders([oldTable]()
+                           {
+                               delete oldTable;
+                           });
+    }
+    return true;
+}
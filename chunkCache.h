@@ -0,0 +1,83 @@
+#ifndef RANDOM_TERRAIN_CHUNKCACHE_H
+#define RANDOM_TERRAIN_CHUNKCACHE_H
+
+// Every chunk that has been made, by chunk ID, readable from any thread.
+// The chunks are split into shards, and each shard is a hash table whose
+// buckets are lists that only grow. Adding a chunk puts a new node at the
+// front of its bucket, so readers never take a lock or wait for a writer, and
+// nothing is copied. When a shard's table gets as many chunks as buckets, it is
+// copied once into a table with twice as many buckets and swapped in.
+//
+// An old table can't be deleted while a reader might still be looking at it,
+// so replaced tables are retired with epochs (see epoch.h).
+//
+// Chunks are published once and never removed, since coming back to a place
+// has to show the same terrain. So a chunk found here stays alive as long as the cache does.
+
+#include "chunk.h"
+#include "epoch.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ChunkCache
+{
+private:
+    // Never changed once it is in a bucket
+    struct Node
+    {
+        int chunkID;
+        std::shared_ptr<Chunk> chunk;
+        const Node *next;
+    };
+    // Owns its nodes. The number of buckets is a power of 2.
+    struct Table
+    {
+        std::vector<std::atomic<const Node*>> buckets;
+
+        explicit Table(int numBuckets);
+        ~Table();
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+
+        const Node *find(int chunkID) const;
+        // Only called by the shard's writer
+        void add(int chunkID, const std::shared_ptr<Chunk> &chunk);
+    };
+
+    struct Shard
+    {
+        std::atomic<Table*> table;
+        int size; // guarded by writeMutex
+        std::mutex writeMutex; // only writers to this shard wait on each other
+    };
+    const static int NUM_SHARDS = 16;
+    const static int INITIAL_BUCKETS = 16;
+    Shard shards[NUM_SHARDS];
+    std::atomic<int> numChunks;
+
+    static int getShardIndex(int chunkID);
+    static unsigned int hash(int chunkID);
+public:
+    ChunkCache();
+    ~ChunkCache();
+
+    // Readers may hold pointers into the tables
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    // Nullptr if the chunk hasn't been published
+    std::shared_ptr<Chunk> find(int chunkID) const;
+    bool contains(int chunkID) const;
+    int size() const;
+    // Calls f on every chunk. Chunks published while this runs may be missed.
+    void forEach(const std::function<void(const std::shared_ptr<Chunk>&)> &f) const;
+
+    // Add the chunk unless one was already published with the same ID.
+    // Returns false if there already was one, which is kept.
+    bool publish(int chunkID, const std::shared_ptr<Chunk> &chunk);
+};
+
+#endif //RANDOM_TERRAIN_CHUNKCACHE_H
@@ -0,0 +1,299 @@
+#include "chunkGraphics.h"
+#include "trace.h"
+#include <algorithm>
+
+ChunkGraphics::ChunkGraphics()
+{
+    displayList = 0;
+    meshBuffer = 0;
+    meshVertexCount = 0;
+}
+
+// One solid in immediate mode, for when the buildings can't be batched
+static void drawSolid(const Solid &s)
+{
+    glDisable(GL_CULL_FACE);
+    std::vector<Point> segments = s.getLineSegments();
+    if(!segments.empty())
+    {
+        setGLColor(s.getLineColor());
+        glBegin(GL_LINES);
+        for(const Point &p : segments)
+        {
+            drawPoint(p);
+        }
+        glEnd();
+    }
+    setGLColor(s.getColor());
+    glBegin(GL_QUADS);
+    for(const Point &p : s.getFaces())
+    {
+        drawPoint(p);
+    }
+    glEnd();
+    glEnable(GL_CULL_FACE);
+}
+
+void Chunk::ensureUploaded()
+{
+    if(stage >= Uploaded)
+    {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    ensureRenderReady();
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    if(!graphics)
+    {
+        graphics = std::make_shared<ChunkGraphics>();
+    }
+    if(graphics->displayList == 0)
+    {
+        graphics->displayList = glGenLists(1);
+    }
+    glNewList(graphics->displayList, GL_COMPILE);
+    drawTerrain(*v);
+    drawWater(*v);
+    glEndList();
+    if(v->mesh || v->meshPatch)
+    {
+        v->mesh = nullptr;
+        v->meshPatch = nullptr;
+        current.store(v);
+    }
+    stage = Uploaded;
+}
+
+long Chunk::uploadMesh()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(stage >= Uploaded)
+    {
+        return 0;
+    }
+    if(!glFuncs.hasBuffers)
+    {
+        ensureUploaded();
+        return getMeshVertexCount(*current.load()) * FLOATS_PER_VERTEX * sizeof(float);
+    }
+    ensureMeshReady();
+    if(!graphics)
+    {
+        graphics = std::make_shared<ChunkGraphics>();
+    }
+    std::shared_ptr<ChunkVersion> v = copyCurrentVersion();
+    if(v->meshPatch && graphics->meshBuffer != 0)
+    {
+        // Only send the squares that were edited, one row at a time
+        std::shared_ptr<const ChunkMeshPatch> patch = v->meshPatch;
+        SquareRange squares = patch->squares;
+        int rowFloats = (squares.jMax - squares.jMin + 1) * 6 * FLOATS_PER_VERTEX;
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, graphics->meshBuffer);
+        for(int i = squares.iMin; i <= squares.iMax; i++)
+        {
+            GLintptr offset = (i*(pointsPerSide - 1) + squares.jMin) * 6 * FLOATS_PER_VERTEX * sizeof(float);
+            glFuncs.bufferSubData(GL_ARRAY_BUFFER, offset, rowFloats * sizeof(float),
+                                  patch->vertices.data() + (i - squares.iMin)*rowFloats);
+        }
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+        v->meshPatch = nullptr;
+        current.store(v);
+        stage = Uploaded;
+        return patch->vertices.size() * sizeof(float);
+    }
+    if(!v->mesh)
+    {
+        // It was edited, but there is no buffer to patch
+        std::shared_ptr<std::vector<float>> mesh = std::make_shared<std::vector<float>>(getMeshVertexCount(*v) * FLOATS_PER_VERTEX);
+        writeMesh(*v, mesh->data());
+        v->mesh = mesh;
+        v->meshPatch = nullptr;
+        current.store(v);
+        v = copyCurrentVersion();
+    }
+    const std::vector<float> &meshVertices = *v->mesh;
+    int vertexCount = meshVertices.size() / FLOATS_PER_VERTEX;
+    GLsizeiptr size = meshVertices.size() * sizeof(float);
+    if(graphics->meshBuffer == 0)
+    {
+        glFuncs.genBuffers(1, &graphics->meshBuffer);
+    }
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, graphics->meshBuffer);
+    glFuncs.bufferData(GL_ARRAY_BUFFER, size, meshVertices.data(), GL_STATIC_DRAW);
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+    graphics->meshVertexCount = vertexCount;
+    // The graphics card has its own copy now
+    v->mesh = nullptr;
+    current.store(v);
+    stage = Uploaded;
+    return size;
+}
+void Chunk::releaseGraphics()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if(!graphics)
+    {
+        return;
+    }
+    if(graphics->displayList != 0)
+    {
+        glDeleteLists(graphics->displayList, 1);
+    }
+    if(graphics->meshBuffer != 0)
+    {
+        glFuncs.deleteBuffers(1, &graphics->meshBuffer);
+    }
+    graphics->buildingBatch.release();
+    graphics = nullptr;
+    if(stage == Uploaded)
+    {
+        // The mesh was freed when it was uploaded, so it has to be made again
+        stage = RenderReady;
+    }
+}
+std::vector<float> Chunk::readUploadedMesh() const
+{
+    std::vector<float> vertices;
+    if(!graphics || graphics->meshBuffer == 0 || !glFuncs.getBufferSubData)
+    {
+        return vertices;
+    }
+    vertices.resize(graphics->meshVertexCount * FLOATS_PER_VERTEX);
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, graphics->meshBuffer);
+    glFuncs.getBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+    glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+    return vertices;
+}
+
+void Chunk::draw()
+{
+    TRACE_SCOPE("chunk draw");
+    if(!graphics || (graphics->meshBuffer == 0 && graphics->displayList == 0))
+    {
+        return;
+    }
+
+    glDisable(GL_CULL_FACE);
+    if(graphics->meshBuffer != 0)
+    {
+        GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, graphics->meshBuffer);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<void*>(0));
+        glColorPointer(4, GL_FLOAT, stride, reinterpret_cast<void*>(3 * sizeof(float)));
+        glDrawArrays(GL_TRIANGLES, 0, graphics->meshVertexCount);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glFuncs.bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    else
+    {
+        glCallList(graphics->displayList);
+    }
+    glEnable(GL_CULL_FACE);
+
+    drawBuildings();
+}
+
+void Chunk::drawTerrain(const ChunkVersion &v) const
+{
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    const SharedRows<RGBAcolor> &squareColors = v.surface->squareColors;
+    glShadeModel( GL_FLAT );
+    for(int j = 0; j < pointsPerSide - 1; j++)
+    {
+        setGLColor(squareColors[0][j]);
+        glBegin(GL_TRIANGLE_STRIP);
+        drawPoint(terrainPoints[0][j]);
+        drawPoint(terrainPoints[0][j+1]);
+        for(int i = 1; i < pointsPerSide; i++)
+        {
+            setGLColor(squareColors[i-1][j]);
+            drawPoint(terrainPoints[i][j]);
+            drawPoint(terrainPoints[i][j+1]);
+        }
+        glEnd();
+    }
+
+    glShadeModel( GL_SMOOTH );
+}
+
+void Chunk::drawWater(const ChunkVersion &v) const
+{
+    if(!getHasWater(v))
+    {
+        return;
+    }
+    const SharedRows<Point> &terrainPoints = v.heights->terrainPoints;
+    const SharedRows<bool> &drawWaterAt = v.surface->drawWaterAt;
+    setGLColor(v.terrainToColor.at(Water));
+    glBegin(GL_QUADS);
+    for(int i = 0; i < pointsPerSide - 1; i++)
+    {
+        for(int j = 0; j < pointsPerSide - 1; j++)
+        {
+            if(drawWaterAt[i][j])
+            {
+                glVertex3f(terrainPoints[i][j].x, waterLevel, terrainPoints[i][j].z);
+                glVertex3f(terrainPoints[i][j+1].x, waterLevel, terrainPoints[i][j+1].z);
+                glVertex3f(terrainPoints[i+1][j+1].x, waterLevel, terrainPoints[i+1][j+1].z);
+                glVertex3f(terrainPoints[i+1][j].x, waterLevel, terrainPoints[i+1][j].z);
+
+            }
+        }
+    }
+    glEnd();
+}
+
+void Chunk::drawBuildings()
+{
+    // Building the batch can turn instancing off if the shader doesn't link,
+    // so the buildings are drawn one by one from the same frame on
+    if(updateBuildingBatch())
+    {
+        graphics->buildingBatch.draw();
+        return;
+    }
+    std::shared_ptr<const ChunkBuildings> b = current.load()->buildings;
+    if(!glFuncs.hasInstancing && b)
+    {
+        for(const std::shared_ptr<Building> &building : b->buildings)
+        {
+            for(const std::shared_ptr<Solid> &s : building->getSolids())
+            {
+                drawSolid(*s);
+            }
+        }
+    }
+}
+bool Chunk::updateBuildingBatch()
+{
+    if(!glFuncs.hasInstancing)
+    {
+        return false;
+    }
+    std::shared_ptr<const ChunkBuildings> b = current.load()->buildings;
+    if(!graphics)
+    {
+        if(!b)
+        {
+            return false;
+        }
+        graphics = std::make_shared<ChunkGraphics>();
+    }
+    if(b != graphics->batchBuildings)
+    {
+        // The buildings were released or remade since the batch was built
+        if(graphics->buildingBatch.isBuilt())
+        {
+            graphics->buildingBatch.release();
+        }
+        if(b && !b->buildings.empty())
+        {
+            graphics->buildingBatch.build(b->buildingSolids);
+        }
+        graphics->batchBuildings = b;
+    }
+    return graphics->buildingBatch.isBuilt();
+}
@@ -0,0 +1,31 @@
+#ifndef RANDOM_TERRAIN_CHUNKGRAPHICS_H
+#define RANDOM_TERRAIN_CHUNKGRAPHICS_H
+
+// The GL objects a chunk is drawn with. Chunk only holds a pointer to these,
+// so the terrain code builds without OpenGL. The Chunk functions that upload
+// and draw are in chunkGraphics.cpp, which is part of the renderer.
+
+#include "chunk.h"
+#include "glFunctions.h"
+#include "buildingBatch.h"
+#include <memory>
+
+struct ChunkGraphics
+{
+    GLuint displayList; // 0 unless the chunk was Uploaded without vertex buffers
+    GLuint meshBuffer;  // 0 unless the chunk was Uploaded with vertex buffers
+    int meshVertexCount;
+    // Draws all of the buildings at once, if the graphics card can
+    BuildingBatch buildingBatch;
+    std::shared_ptr<const ChunkBuildings> batchBuildings; // what the batch was built from
+
+    // There may be no context by the time a chunk is freed, so the GL objects
+    // aren't deleted with it. Chunk::releaseGraphics() deletes them.
+    ChunkGraphics();
+
+    // Owns GL objects, so it can't be copied
+    ChunkGraphics(const ChunkGraphics &) = delete;
+    ChunkGraphics &operator=(const ChunkGraphics &) = delete;
+};
+
+#endif //RANDOM_TERRAIN_CHUNKGRAPHICS_H
@@ -0,0 +1,417 @@
+#include "chunkScheduler.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+ChunkScheduler::ChunkScheduler()
+{
+    focus = {0, 0};
+    radius = INT_MAX;
+    queues = std::vector<std::deque<std::shared_ptr<ChunkJob>>>(1);
+    nextQueue = 0;
+    running = false;
+}
+ChunkScheduler::~ChunkScheduler()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopWorkers(lock);
+}
+
+void ChunkScheduler::setFunctions(StepFunction inputRunStep, PublishFunction inputPublish,
+                                  IsPublishedFunction inputIsPublished)
+{
+    runStep = inputRunStep;
+    publish = inputPublish;
+    isPublished = inputIsPublished;
+}
+void ChunkScheduler::setNumThreads(int numThreads)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopWorkers(lock);
+    // Put the waiting jobs into the new queues
+    std::vector<std::shared_ptr<ChunkJob>> waiting;
+    for(std::deque<std::shared_ptr<ChunkJob>> &queue : queues)
+    {
+        waiting.insert(waiting.end(), queue.begin(), queue.end());
+    }
+    // A job that was partway done on the game's thread can be picked up by a worker
+    if(cooperativeJob)
+    {
+        waiting.push_back(cooperativeJob);
+        cooperativeJob = nullptr;
+    }
+    queues = std::vector<std::deque<std::shared_ptr<ChunkJob>>>(std::max(numThreads, 1));
+    nextQueue = 0;
+    for(std::shared_ptr<ChunkJob> &job : waiting)
+    {
+        job->queue = nextQueue;
+        queues[nextQueue].push_back(job);
+        nextQueue = (nextQueue + 1) % queues.size();
+    }
+    running = true;
+    for(int i = 0; i < numThreads; i++)
+    {
+        workers.emplace_back(&ChunkScheduler::workerLoop, this, i);
+    }
+}
+int ChunkScheduler::getNumThreads() const
+{
+    return workers.size();
+}
+void ChunkScheduler::stopWorkers(std::unique_lock<std::mutex> &lock)
+{
+    // Workers finish the job they have before stopping
+    running = false;
+    changed.notify_all();
+    lock.unlock();
+    for(std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    lock.lock();
+    workers.clear();
+}
+
+int ChunkScheduler::getDistance(Point2D topLeft) const
+{
+    return abs(topLeft.x - focus.x) + abs(topLeft.z - focus.z);
+}
+bool ChunkScheduler::hasUnpublishedNeighbor(const ChunkJob &job) const
+{
+    for(int dx = -1; dx <= 1; dx++)
+    {
+        for(int dz = -1; dz <= 1; dz++)
+        {
+            if((dx != 0 || dz != 0) && unpublished.count(point2DtoChunkID({job.topLeft.x + dx, job.topLeft.z + dz})) > 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+bool ChunkScheduler::canStart(const ChunkJob &job) const
+{
+    if(job.step > Stitch)
+    {
+        return true; // it started on another thread already
+    }
+    if(hasUnpublishedNeighbor(job))
+    {
+        return false;
+    }
+    int distance = getDistance(job.topLeft);
+    for(Point2D neighbor : {Point2D{job.topLeft.x - 1, job.topLeft.z}, Point2D{job.topLeft.x + 1, job.topLeft.z},
+                            Point2D{job.topLeft.x, job.topLeft.z - 1}, Point2D{job.topLeft.x, job.topLeft.z + 1}})
+    {
+        if(getDistance(neighbor) < distance && !isPublished(point2DtoChunkID(neighbor)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChunkScheduler::setFocus(Point2D inputFocus, int inputRadius)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    focus = inputFocus;
+    radius = inputRadius;
+    std::vector<std::shared_ptr<ChunkJob>> outside;
+    for(const std::pair<const int, std::shared_ptr<ChunkJob>> &idAndJob : jobs)
+    {
+        if(getDistance(idAndJob.second->topLeft) > radius)
+        {
+            outside.push_back(idAndJob.second);
+        }
+    }
+    for(std::shared_ptr<ChunkJob> &job : outside)
+    {
+        if(job->queue != -1)
+        {
+            // Nothing has been done for it yet
+            removeFromQueue(job);
+            jobs.erase(job->chunkID);
+        }
+        else
+        {
+            job->cancelled = true;
+        }
+    }
+    changed.notify_all();
+}
+
+void ChunkScheduler::addJob(int chunkID, Point2D topLeft)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(chunkID);
+    if(it != jobs.end())
+    {
+        // It may have been cancelled, and then come back into the radius
+        it->second->cancelled = false;
+        return;
+    }
+    std::shared_ptr<ChunkJob> job = std::make_shared<ChunkJob>();
+    job->chunkID = chunkID;
+    job->topLeft = topLeft;
+    job->step = Stitch;
+    job->distance = getDistance(topLeft);
+    job->colorVersion = 0;
+    job->hasCity = false;
+    job->queue = nextQueue;
+    job->cancelled = false;
+    job->dropped = false;
+    job->published = false;
+    jobs[chunkID] = job;
+    queues[nextQueue].push_back(job);
+    nextQueue = (nextQueue + 1) % queues.size();
+    changed.notify_all();
+}
+bool ChunkScheduler::hasJob(int chunkID) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.count(chunkID) > 0;
+}
+int ChunkScheduler::getNumJobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+std::shared_ptr<ChunkJob> ChunkScheduler::takeJob(int queueIndex)
+{
+    std::shared_ptr<ChunkJob> best = nullptr;
+    int bestDistance = INT_MAX;
+    // Look in this thread's own queue first, then steal from the others
+    for(int k = 0; k < (int)queues.size() && !best; k++)
+    {
+        for(const std::shared_ptr<ChunkJob> &job : queues[(queueIndex + k) % queues.size()])
+        {
+            int distance = getDistance(job->topLeft);
+            if(distance < bestDistance && canStart(*job))
+            {
+                best = job;
+                bestDistance = distance;
+            }
+        }
+    }
+    if(best)
+    {
+        removeFromQueue(best);
+    }
+    return best;
+}
+void ChunkScheduler::removeFromQueue(const std::shared_ptr<ChunkJob> &job)
+{
+    std::deque<std::shared_ptr<ChunkJob>> &queue = queues[job->queue];
+    queue.erase(std::find(queue.begin(), queue.end(), job));
+    job->queue = -1;
+}
+
+bool ChunkScheduler::runNextStep(const std::shared_ptr<ChunkJob> &job, std::unique_lock<std::mutex> &lock)
+{
+    if(job->cancelled)
+    {
+        // Nobody has seen the chunk, so its neighbors can stitch without it
+        unpublished.erase(job->chunkID);
+        job->dropped = true;
+        forget(job);
+        changed.notify_all();
+        return false;
+    }
+    if(job->step == Done)
+    {
+        readyToPublish.push_back(job);
+        changed.notify_all();
+        return false;
+    }
+    ChunkJobStep step = job->step;
+    job->distance = getDistance(job->topLeft);
+    if(step == Stitch)
+    {
+        unpublished.insert(job->chunkID);
+    }
+    lock.unlock();
+    runStep(*job);
+    lock.lock();
+    job->step = static_cast<ChunkJobStep>(step + 1);
+    return true;
+}
+void ChunkScheduler::forget(const std::shared_ptr<ChunkJob> &job)
+{
+    auto it = jobs.find(job->chunkID);
+    if(it != jobs.end() && it->second == job)
+    {
+        jobs.erase(it);
+    }
+}
+void ChunkScheduler::publishReady(std::unique_lock<std::mutex> &lock)
+{
+    if(readyToPublish.empty())
+    {
+        return;
+    }
+    std::vector<std::shared_ptr<ChunkJob>> ready;
+    ready.swap(readyToPublish);
+    // The chunks stay unpublished until they're in the game, so no neighbor
+    // stitches without them in the meantime
+    lock.unlock();
+    for(std::shared_ptr<ChunkJob> &job : ready)
+    {
+        publish(*job);
+    }
+    lock.lock();
+    for(std::shared_ptr<ChunkJob> &job : ready)
+    {
+        job->published = true;
+        unpublished.erase(job->chunkID);
+        forget(job);
+    }
+    changed.notify_all();
+}
+
+void ChunkScheduler::workerLoop(int queueIndex)
+{
+    setTraceThreadName("chunk worker " + std::to_string(queueIndex));
+    std::unique_lock<std::mutex> lock(mutex);
+    while(running)
+    {
+        std::shared_ptr<ChunkJob> job = takeJob(queueIndex);
+        if(!job)
+        {
+            changed.wait(lock);
+            continue;
+        }
+        while(runNextStep(job, lock))
+        {
+        }
+    }
+}
+
+void ChunkScheduler::finishJob(int chunkID)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    publishReady(lock);
+    auto it = jobs.find(chunkID);
+    if(it == jobs.end())
+    {
+        return;
+    }
+    std::shared_ptr<ChunkJob> job = it->second;
+    if(job->queue != -1)
+    {
+        // Take it before a worker does. Marking it unpublished keeps the
+        // workers from starting on its neighbors in the meantime.
+        removeFromQueue(job);
+        unpublished.insert(chunkID);
+        // Neighbors that are already stitching have to be published first
+        while(hasUnpublishedNeighbor(*job))
+        {
+            if(cooperativeJob && unpublished.count(cooperativeJob->chunkID) > 0)
+            {
+                if(!runNextStep(cooperativeJob, lock))
+                {
+                    cooperativeJob = nullptr;
+                }
+            }
+            else
+            {
+                changed.wait(lock);
+            }
+            publishReady(lock);
+        }
+        while(runNextStep(job, lock))
+        {
+        }
+        publishReady(lock);
+    }
+    else if(job == cooperativeJob)
+    {
+        while(runNextStep(job, lock))
+        {
+        }
+        cooperativeJob = nullptr;
+        publishReady(lock);
+    }
+    else
+    {
+        // A worker has it already
+        while(!job->published && !job->dropped)
+        {
+            changed.wait(lock);
+            publishReady(lock);
+        }
+    }
+}
+void ChunkScheduler::finishAll()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    publishReady(lock);
+    while(!jobs.empty())
+    {
+        if(workers.empty())
+        {
+            if(!cooperativeJob)
+            {
+                cooperativeJob = takeJob(0);
+                if(!cooperativeJob)
+                {
+                    break;
+                }
+            }
+            if(!runNextStep(cooperativeJob, lock))
+            {
+                cooperativeJob = nullptr;
+            }
+        }
+        else
+        {
+            changed.wait(lock);
+        }
+        publishReady(lock);
+    }
+}
+
+int ChunkScheduler::run(double budgetMilliseconds)
+{
+    return runOnThisThread(budgetMilliseconds, -1);
+}
+int ChunkScheduler::runSteps(int numSteps)
+{
+    return runOnThisThread(-1, numSteps);
+}
+int ChunkScheduler::runOnThisThread(double budgetMilliseconds, int maxSteps)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    publishReady(lock);
+    if(!workers.empty())
+    {
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    int stepsRun = 0;
+    while(maxSteps < 0 || stepsRun < maxSteps)
+    {
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if(budgetMilliseconds >= 0 && stepsRun > 0 && elapsed >= budgetMilliseconds)
+        {
+            break;
+        }
+        if(!cooperativeJob)
+        {
+            cooperativeJob = takeJob(0);
+            if(!cooperativeJob)
+            {
+                break;
+            }
+        }
+        if(!runNextStep(cooperativeJob, lock))
+        {
+            cooperativeJob = nullptr;
+        }
+        publishReady(lock);
+        stepsRun++;
+    }
+    return stepsRun;
+}
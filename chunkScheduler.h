@@ -0,0 +1,165 @@
+#ifndef RANDOM_TERRAIN_CHUNKSCHEDULER_H
+#define RANDOM_TERRAIN_CHUNKSCHEDULER_H
+
+// Spreads the work of making new chunks out, so walking into a new chunk
+// doesn't stall the game while all of the chunks around it are made. Making a
+// chunk is broken into steps. With worker threads, each worker has its own
+// queue of jobs and steals from the others when it runs out. Without workers,
+// the steps run on the game's thread, as many per update as fit in its time budget.
+//
+// Jobs closest to the focus (the player's chunk) always go first, measured
+// when a job is picked rather than when it was added, so a job added in a far
+// corner doesn't hold up the chunks the player is walking toward. Jobs for
+// chunks that leave the radius are dropped, or stopped before their next step
+// if a worker already has them.
+//
+// Every step is done before the chunk is published, so nothing changes a chunk
+// after the game's thread can see it except the game's thread itself.
+//
+// A chunk's noise is stitched to the borders of the neighbors that exist when
+// it starts, so no job can stitch while a chunk touching it (even at a corner)
+// has stitched but not been published yet. Otherwise the two could miss each
+// other's borders. Chunks that only touch at a corner don't stitch to each
+// other at all, and only agree on that corner if a chunk next to both was made
+// first. So a job also waits until its neighbors that are closer to the focus
+// have been published, which is the order the chunks were always made in.
+// Once a job is done, it is handed back to the game's thread to publish,
+// which is the only thread that changes the game's list of chunks.
+
+#include "structs.h"
+#include "chunk.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// The steps of making a chunk, in order
+enum ChunkJobStep {Stitch,    // get the borders of the neighbors that exist
+                   Noise,     // make the heights, matching those borders
+                   Create,    // make the chunk
+                   Physics,   // normal vectors, for height queries
+                   Classify,  // terrain types, colors, and water
+                   Mesh,      // the triangles to send to the graphics card
+                   Buildings, // if the chunk has a city close enough to the player
+                   Done};     // ready for the game's thread to publish
+
+struct ChunkJob
+{
+    int chunkID;
+    Point2D topLeft;
+    ChunkJobStep step; // the next step to run
+    int distance;      // how many chunks from the focus when the step started
+
+    // Filled in by the steps as they go
+    std::vector<double> relativeHeightsAbove, relativeHeightsBelow, relativeHeightsLeft, relativeHeightsRight;
+    std::vector<double> absoluteHeightsAbove, absoluteHeightsBelow, absoluteHeightsLeft, absoluteHeightsRight;
+    RGBAcolor snowColor, rockColor, grassColor, sandColor, waterColor;
+    int colorVersion;
+    int editCount;     // how many terrain edits had been made when it stitched
+    std::vector<std::vector<double>> noise;
+    bool hasCity;
+    int buildingSeed;
+    std::shared_ptr<Chunk> chunk;
+
+    // Kept by the scheduler
+    int queue;      // which worker's queue it's waiting in, or -1 once a thread has it
+    bool cancelled; // drop it before the next step
+    bool dropped;
+    bool published;
+};
+
+class ChunkScheduler
+{
+public:
+    // Does job.step. Runs on whichever thread has the job.
+    typedef std::function<void(ChunkJob &job)> StepFunction;
+    // Makes a created chunk part of the game. Runs on the thread that calls run(),
+    // without the scheduler's lock, so the workers keep going meanwhile.
+    typedef std::function<void(ChunkJob &job)> PublishFunction;
+    // Whether the game has the chunk. Runs on any thread, with the lock held.
+    typedef std::function<bool(int chunkID)> IsPublishedFunction;
+private:
+    StepFunction runStep;
+    PublishFunction publish;
+    IsPublishedFunction isPublished;
+
+    // Everything below is guarded by mutex
+    mutable std::mutex mutex;
+    std::condition_variable changed; // a job was added, dropped, published, or finished
+    Point2D focus;
+    int radius;
+    // Every job that hasn't been published or dropped yet
+    std::unordered_map<int, std::shared_ptr<ChunkJob>> jobs;
+    // One queue per worker, or just one with no workers
+    std::vector<std::deque<std::shared_ptr<ChunkJob>>> queues;
+    int nextQueue;
+    // Chunks whose jobs have stitched (or are about to) but aren't published yet
+    std::unordered_set<int> unpublished;
+    std::vector<std::shared_ptr<ChunkJob>> readyToPublish;
+    // The job being worked on between calls to run(), with no workers
+    std::shared_ptr<ChunkJob> cooperativeJob;
+    std::vector<std::thread> workers;
+    bool running;
+
+    int getDistance(Point2D topLeft) const;
+    bool hasUnpublishedNeighbor(const ChunkJob &job) const;
+    // Whether the job is allowed to stitch now
+    bool canStart(const ChunkJob &job) const;
+    // The closest job that can start in the given queue, or else the closest one
+    // in any other queue. Nullptr if none can start right now.
+    std::shared_ptr<ChunkJob> takeJob(int queueIndex);
+    void removeFromQueue(const std::shared_ptr<ChunkJob> &job);
+    // Run the job's next step, with the lock held on entry and exit.
+    // Returns false once there is nothing left to do with the job.
+    bool runNextStep(const std::shared_ptr<ChunkJob> &job, std::unique_lock<std::mutex> &lock);
+    void forget(const std::shared_ptr<ChunkJob> &job);
+    // Unlocks while the jobs are published
+    void publishReady(std::unique_lock<std::mutex> &lock);
+    // run() and runSteps() without workers. A negative limit isn't checked.
+    int runOnThisThread(double budgetMilliseconds, int maxSteps);
+    void workerLoop(int queueIndex);
+    void stopWorkers(std::unique_lock<std::mutex> &lock);
+public:
+    ChunkScheduler();
+    ~ChunkScheduler();
+
+    // The workers and the lock belong to one scheduler
+    ChunkScheduler(const ChunkScheduler&) = delete;
+    ChunkScheduler& operator=(const ChunkScheduler&) = delete;
+
+    // Must be set before any jobs are added
+    void setFunctions(StepFunction inputRunStep, PublishFunction inputPublish, IsPublishedFunction inputIsPublished);
+    // 0 runs every step on the thread that calls run()
+    void setNumThreads(int numThreads);
+    int getNumThreads() const;
+
+    // Jobs are done closest to the focus first. Jobs farther than radius
+    // chunks away are cancelled.
+    void setFocus(Point2D inputFocus, int inputRadius);
+
+    // Does nothing if the chunk already has a job
+    void addJob(int chunkID, Point2D topLeft);
+    bool hasJob(int chunkID) const;
+    int getNumJobs() const;
+
+    // Make the chunk right away on this thread, ignoring the budget, and publish it.
+    // Only waits for the jobs touching it that have already stitched, or for
+    // its own job if a worker has it already.
+    void finishJob(int chunkID);
+    void finishAll();
+
+    // Publish the chunks the workers have finished. Without workers, also run steps,
+    // closest job first, until budgetMilliseconds have passed. At least one step
+    // is run so the jobs always make progress. Returns the number of steps run.
+    int run(double budgetMilliseconds);
+    // The same, but without workers it runs numSteps steps, however long they
+    // take, so the same calls always make the same chunks
+    int runSteps(int numSteps);
+};
+
+#endif //RANDOM_TERRAIN_CHUNKSCHEDULER_H
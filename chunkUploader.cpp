@@ -0,0 +1,94 @@
+#include "chunkUploader.h"
+#include "chunkGraphics.h"
+#include "trace.h"
+#include <algorithm>
+
+ChunkUploader::ChunkUploader() : ChunkUploader(1024*1024, 4)
+{
+}
+ChunkUploader::ChunkUploader(long inputMaxBytesPerFrame, int inputMaxChunksPerFrame)
+{
+    maxBytesPerFrame = inputMaxBytesPerFrame;
+    maxChunksPerFrame = inputMaxChunksPerFrame;
+}
+
+void ChunkUploader::destroy(const World &world)
+{
+    chunksWithBuildingBatches.clear();
+    world.forEachChunk([](const std::shared_ptr<Chunk> &c)
+                       {
+                           c->releaseGraphics();
+                       });
+    BuildingBatch::releaseShared();
+}
+
+void ChunkUploader::setMaxBytesPerFrame(long input)
+{
+    maxBytesPerFrame = input;
+}
+void ChunkUploader::setMaxChunksPerFrame(int input)
+{
+    maxChunksPerFrame = input;
+}
+long ChunkUploader::getMaxBytesPerFrame() const
+{
+    return maxBytesPerFrame;
+}
+int ChunkUploader::getMaxChunksPerFrame() const
+{
+    return maxChunksPerFrame;
+}
+
+int ChunkUploader::uploadChunks(const std::vector<std::shared_ptr<Chunk>> &visibleChunks, Point cameraLocation)
+{
+    TRACE_SCOPE("uploadChunks");
+    std::vector<std::pair<double, std::shared_ptr<Chunk>>> waiting;
+    for(const std::shared_ptr<Chunk> &c : visibleChunks)
+    {
+        if(c->getStage() < Uploaded)
+        {
+            Point center = c->getCenter();
+            waiting.emplace_back(distance2d(center, cameraLocation), c);
+        }
+    }
+    std::sort(waiting.begin(), waiting.end(),
+              [](const std::pair<double, std::shared_ptr<Chunk>> &a, const std::pair<double, std::shared_ptr<Chunk>> &b)
+              {
+                  return a.first < b.first;
+              });
+
+    long bytesUploaded = 0;
+    int chunksUploaded = 0;
+    for(const std::pair<double, std::shared_ptr<Chunk>> &entry : waiting)
+    {
+        if(chunksUploaded > 0 && (chunksUploaded >= maxChunksPerFrame || bytesUploaded >= maxBytesPerFrame))
+        {
+            break;
+        }
+        bytesUploaded += entry.second->uploadMesh();
+        chunksUploaded++;
+    }
+    updateBuildingBatches(visibleChunks);
+    return chunksUploaded;
+}
+
+void ChunkUploader::updateBuildingBatches(const std::vector<std::shared_ptr<Chunk>> &visibleChunks)
+{
+    std::vector<std::shared_ptr<Chunk>> stillBatched;
+    for(const std::shared_ptr<Chunk> &c : chunksWithBuildingBatches)
+    {
+        if(c->updateBuildingBatch())
+        {
+            stillBatched.push_back(c);
+        }
+    }
+    for(const std::shared_ptr<Chunk> &c : visibleChunks)
+    {
+        if(c->getHasCity() && std::find(stillBatched.begin(), stillBatched.end(), c) == stillBatched.end() &&
+           c->updateBuildingBatch())
+        {
+            stillBatched.push_back(c);
+        }
+    }
+    chunksWithBuildingBatches.swap(stillBatched);
+}
@@ -0,0 +1,47 @@
+#ifndef RANDOM_TERRAIN_CHUNKUPLOADER_H
+#define RANDOM_TERRAIN_CHUNKUPLOADER_H
+
+// Sends chunks' meshes to the graphics card a few at a time, so walking into
+// new terrain doesn't make one frame take much longer than the others. Each
+// frame, the visible chunks that haven't been uploaded go in order of distance
+// from the camera until the frame's budget is used up. The meshes are made ahead
+// of time, by the chunk workers if there are any, so uploading one is a single
+// glBufferData from memory.
+
+#include "chunk.h"
+#include "world.h"
+#include <memory>
+#include <vector>
+
+class ChunkUploader
+{
+private:
+    long maxBytesPerFrame;
+    int maxChunksPerFrame;
+    // Every chunk with a building batch. Chunks the game released the buildings
+    // of are usually out of view, so they aren't drawn again to notice.
+    std::vector<std::shared_ptr<Chunk>> chunksWithBuildingBatches;
+
+    // Build the batches of visible chunks whose buildings changed, and release
+    // the batches of chunks whose buildings were released
+    void updateBuildingBatches(const std::vector<std::shared_ptr<Chunk>> &visibleChunks);
+public:
+    ChunkUploader();
+    ChunkUploader(long inputMaxBytesPerFrame, int inputMaxChunksPerFrame);
+
+    // Delete the GL objects of every chunk in the world. Call it
+    // while the window's context is still current, before it is destroyed.
+    void destroy(const World &world);
+
+    void setMaxBytesPerFrame(long input);
+    void setMaxChunksPerFrame(int input);
+    long getMaxBytesPerFrame() const;
+    int getMaxChunksPerFrame() const;
+
+    // Call once per frame, before drawing. The closest chunk that hasn't been
+    // uploaded is always uploaded, even if it's bigger than the budget.
+    // Building batches are kept up to date too. Returns the number of chunks uploaded.
+    int uploadChunks(const std::vector<std::shared_ptr<Chunk>> &visibleChunks, Point cameraLocation);
+};
+
+#endif //RANDOM_TERRAIN_CHUNKUPLOADER_H
@@ -0,0 +1,126 @@
+#include "epoch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+static std::atomic<uint64_t> globalEpoch(1);
+
+// Each thread that reads gets a slot to announce its epoch in, and gives it back
+// when the thread ends
+const static int MAX_READERS = 128;
+struct ReaderSlot
+{
+    std::atomic<uint64_t> epoch{0}; // 0 while the thread isn't reading
+    std::atomic<bool> taken{false};
+    char padding[48];               // keep each slot in its own cache line
+};
+static ReaderSlot readerSlots[MAX_READERS];
+// Threads that are reading without a slot, if there were ever more than
+// MAX_READERS. Nothing is freed while any of them are.
+static std::atomic<int> readersWithoutSlots(0);
+
+struct ThreadSlot
+{
+    int index = -1;
+    int depth = 0;
+    bool hasSlot()
+    {
+        if(index == -1)
+        {
+            for(int i = 0; i < MAX_READERS && index == -1; i++)
+            {
+                bool expected = false;
+                if(readerSlots[i].taken.compare_exchange_strong(expected, true))
+                {
+                    index = i;
+                }
+            }
+        }
+        return index != -1;
+    }
+    ~ThreadSlot()
+    {
+        if(index != -1)
+        {
+            readerSlots[index].taken = false;
+        }
+    }
+};
+static thread_local ThreadSlot threadSlot;
+
+// What was retired, and the epoch it was retired in
+static std::mutex retiredMutex;
+static std::vector<std::pair<uint64_t, std::function<void()>>> retired;
+
+EpochGuard::EpochGuard()
+{
+    ThreadSlot &slot = threadSlot;
+    if(slot.depth++ > 0)
+    {
+        return;
+    }
+    if(slot.hasSlot())
+    {
+        readerSlots[slot.index].epoch = globalEpoch.load();
+    }
+    else
+    {
+        readersWithoutSlots++;
+    }
+}
+EpochGuard::~EpochGuard()
+{
+    ThreadSlot &slot = threadSlot;
+    if(--slot.depth > 0)
+    {
+        return;
+    }
+    if(slot.index != -1)
+    {
+        readerSlots[slot.index].epoch = 0;
+    }
+    else
+    {
+        readersWithoutSlots--;
+    }
+}
+
+void retireAfterReaders(std::function<void()> free)
+{
+    // A reader that announces a later epoch started after the data became unreachable
+    uint64_t epoch = globalEpoch.fetch_add(1);
+    // Things retired by other threads after this point may have been reachable
+    // during the scan below, so they have to wait for a later call
+    uint64_t oldestReading = readersWithoutSlots > 0 ? 0 : epoch + 1;
+    for(ReaderSlot &slot : readerSlots)
+    {
+        uint64_t slotEpoch = slot.epoch;
+        if(slotEpoch != 0)
+        {
+            oldestReading = std::min(oldestReading, slotEpoch);
+        }
+    }
+    // Free outside the lock, since freeing can retire more
+    std::vector<std::function<void()>> toFree;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.emplace_back(epoch, std::move(free));
+        auto firstKept = std::partition(retired.begin(), retired.end(),
+                                        [oldestReading](const std::pair<uint64_t, std::function<void()>> &epochAndFree)
+                                        {
+                                            return epochAndFree.first < oldestReading;
+                                        });
+        for(auto it = retired.begin(); it != firstKept; it++)
+        {
+            toFree.push_back(std::move(it->second));
+        }
+        retired.erase(retired.begin(), firstKept);
+    }
+    for(std::function<void()> &f : toFree)
+    {
+        f();
+    }
+}
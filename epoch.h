@@ -0,0 +1,28 @@
+#ifndef RANDOM_TERRAIN_EPOCH_H
+#define RANDOM_TERRAIN_EPOCH_H
+
+// Epoch-based reclamation, so threads can read shared data without locks
+// while a writer replaces it. A reader holds an EpochGuard while it reads,
+// which announces the global epoch. A writer swaps in the new data and then
+// retires the old data, which is freed once every reader that could have seen
+// it is done. Readers never wait, and a writer never waits for a reader.
+
+#include <functional>
+
+class EpochGuard
+{
+public:
+    // Guards can nest on one thread. Only the outermost one announces an epoch.
+    EpochGuard();
+    ~EpochGuard();
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// Call free once no thread could still be reading what it frees. The data must
+// already be unreachable for new readers. free may run on any thread, or
+// right away if nothing is being read.
+void retireAfterReaders(std::function<void()> free);
+
+#endif //RANDOM_TERRAIN_EPOCH_H
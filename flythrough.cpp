@@ -0,0 +1,220 @@
+#include "flythrough.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+Flythrough::Flythrough()
+{
+    segments = {
+            {60, 0, 0, false, false, false},   // let the chunks around spawn finish
+            {300, 0, 0, true, true, false},    // straight across about six chunks
+            {600, 4, 0.5, true, true, false},  // spiral outward
+            {150, 0, 0, true, false, false},   // walk
+            {150, 0, 0, true, false, true},    // jump along
+            {200, 0, 0, true, true, true},     // jump at hyper speed
+            {360, -1, -1, true, true, false},  // a wide circle the other way
+            {300, 0, 0, true, true, false}};   // and straight out again
+    segmentIndex = 0;
+    segmentTick = 0;
+    xzAngle = 0;
+    started = false;
+}
+
+bool Flythrough::loadScript(const std::string &path)
+{
+    std::ifstream in(path);
+    if(!in)
+    {
+        return false;
+    }
+    std::vector<FlythroughSegment> loaded;
+    std::string line;
+    while(std::getline(in, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        FlythroughSegment s = {0, 0, 0, true, false, false};
+        if(!(words >> s.ticks))
+        {
+            if(line.find_first_not_of(" \t\r") != std::string::npos)
+            {
+                return false;
+            }
+            continue; // blank line
+        }
+        if(!(words >> s.turnStart >> s.turnEnd) || s.ticks <= 0)
+        {
+            return false;
+        }
+        std::string flag;
+        while(words >> flag)
+        {
+            if(flag == "still")
+            {
+                s.moving = false;
+            }
+            else if(flag == "hyper")
+            {
+                s.hyperSpeed = true;
+            }
+            else if(flag == "jump")
+            {
+                s.jumping = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        loaded.push_back(s);
+    }
+    if(loaded.empty())
+    {
+        return false;
+    }
+    segments = loaded;
+    return true;
+}
+
+int Flythrough::getTotalTicks() const
+{
+    int total = 0;
+    for(const FlythroughSegment &s : segments)
+    {
+        total += s.ticks;
+    }
+    return total;
+}
+
+bool Flythrough::steer(GameManager &manager)
+{
+    if(!started)
+    {
+        xzAngle = manager.getPlayer().getXZAngle();
+        started = true;
+    }
+    if(segmentIndex >= (int)segments.size())
+    {
+        manager.setWKey(false);
+        manager.setHyperSpeed(false);
+        manager.setSpacebar(false);
+        return false;
+    }
+    const FlythroughSegment &s = segments[segmentIndex];
+    if(segmentTick == 0)
+    {
+        manager.setWKey(s.moving);
+        manager.setHyperSpeed(s.hyperSpeed);
+        manager.setSpacebar(s.jumping);
+    }
+
+    double progress = s.ticks > 1 ? segmentTick / (double)(s.ticks - 1) : 0;
+    double degrees = s.turnStart + (s.turnEnd - s.turnStart)*progress;
+    xzAngle = fmod(xzAngle + degrees*PI/180 + 2*PI, 2*PI);
+    manager.setPlayerAngles(xzAngle, 0);
+
+    segmentTick++;
+    if(segmentTick >= s.ticks)
+    {
+        segmentIndex++;
+        segmentTick = 0;
+    }
+    return true;
+}
+
+void FrameStats::record(const FrameTimes &times)
+{
+    frames.push_back(times);
+}
+
+int FrameStats::getNumFrames() const
+{
+    return frames.size();
+}
+
+// The nearest-rank percentile of sorted values
+static double percentile(const std::vector<double> &sorted, double percent)
+{
+    if(sorted.empty())
+    {
+        return 0;
+    }
+    int rank = (int)ceil(percent/100*sorted.size());
+    return sorted[std::max(0, std::min((int)sorted.size() - 1, rank - 1))];
+}
+
+static void printRow(const char *name, std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    printf("%-8s %9.2f %9.2f %9.2f %9.2f\n", name, percentile(values, 50), percentile(values, 95),
+           percentile(values, 99), values.empty() ? 0 : values.back());
+}
+
+void FrameStats::printReport(double hitchMilliseconds) const
+{
+    std::vector<double> frameMs, tickMs, chunkMs, drawMs;
+    double totalMs = 0;
+    int hitches = 0, hitchesEnteringChunks = 0, chunksEntered = 0;
+    for(const FrameTimes &t : frames)
+    {
+        frameMs.push_back(t.frame);
+        tickMs.push_back(t.tick);
+        chunkMs.push_back(t.chunks);
+        drawMs.push_back(t.draw);
+        totalMs += t.frame;
+        if(t.enteredNewChunk)
+        {
+            chunksEntered++;
+        }
+        if(t.frame > hitchMilliseconds)
+        {
+            hitches++;
+            if(t.enteredNewChunk)
+            {
+                hitchesEnteringChunks++;
+            }
+        }
+    }
+
+    printf("%d frames in %.2f s, %d new chunks entered\n", (int)frames.size(), totalMs/1000, chunksEntered);
+    printf("%-8s %9s %9s %9s %9s\n", "ms", "p50", "p95", "p99", "max");
+    printRow("frame", frameMs);
+    printRow("tick", tickMs);
+    printRow("chunks", chunkMs);
+    printRow("draw", drawMs);
+    printf("%d hitches over %.1f ms, %d of them entering a new chunk\n", hitches, hitchMilliseconds,
+           hitchesEnteringChunks);
+    long peakKB = getPeakMemoryKB();
+    if(peakKB >= 0)
+    {
+        printf("Peak memory: %.1f MB\n", peakKB/1024.0);
+    }
+    else
+    {
+        printf("Peak memory: unknown\n");
+    }
+    fflush(stdout);
+}
+
+long getPeakMemoryKB()
+{
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
@@ -0,0 +1,72 @@
+#ifndef RANDOM_TERRAIN_FLYTHROUGH_H
+#define RANDOM_TERRAIN_FLYTHROUGH_H
+
+// Flies the player along a scripted path with no mouse or keyboard, so the
+// frame times of the same trip can be compared between builds. The script is
+// a list of segments, each held for some number of ticks.
+//
+// A script file has one segment per line, and # starts a comment:
+//   ticks turnStart turnEnd [still] [hyper] [jump]
+// The player turns turnStart degrees per tick at the start of the segment,
+// changing evenly to turnEnd by the end of it. The player walks forward
+// unless the segment is still.
+
+#include "gameManager.h"
+#include <string>
+#include <vector>
+
+struct FlythroughSegment
+{
+    int ticks;
+    double turnStart, turnEnd; // degrees per tick
+    bool moving;
+    bool hyperSpeed;
+    bool jumping;
+};
+
+class Flythrough
+{
+private:
+    std::vector<FlythroughSegment> segments;
+    int segmentIndex;
+    int segmentTick; // ticks into the current segment
+    double xzAngle;
+    bool started;
+public:
+    // Straight hyper speed runs, a spiral, and jumps
+    Flythrough();
+
+    // Returns false if the file can't be read or a line doesn't make sense
+    bool loadScript(const std::string &path);
+
+    int getTotalTicks() const;
+
+    // Set the player's controls for the next tick. Returns false once the script is done.
+    bool steer(GameManager &manager);
+};
+
+// The times of one frame, in milliseconds
+struct FrameTimes
+{
+    double frame;  // everything below
+    double tick;   // the game's ticks, including the player's own chunk if it had to be made right away
+    double chunks; // the chunk scheduler's time on the game's thread
+    double draw;   // uploading, drawing and swapping
+    bool enteredNewChunk;
+};
+
+class FrameStats
+{
+private:
+    std::vector<FrameTimes> frames;
+public:
+    void record(const FrameTimes &times);
+    int getNumFrames() const;
+    // Percentiles of each time, hitches over hitchMilliseconds, and peak memory
+    void printReport(double hitchMilliseconds) const;
+};
+
+// The most memory the process has used, in KB, or -1 if it isn't known
+long getPeakMemoryKB();
+
+#endif //RANDOM_TERRAIN_FLYTHROUGH_H
@@ -0,0 +1,67 @@
+#include "framePacer.h"
+#include "trace.h"
+#include <algorithm>
+
+FramePacer::FramePacer() : FramePacer(2)
+{
+}
+FramePacer::FramePacer(int inputMaxFramesInFlight)
+{
+    maxFramesInFlight = 0;
+    nextFence = 0;
+    setMaxFramesInFlight(inputMaxFramesInFlight);
+}
+
+void FramePacer::setMaxFramesInFlight(int input)
+{
+    for(GLsync &fence : fences)
+    {
+        if(fence != nullptr)
+        {
+            glFuncs.deleteSync(fence);
+        }
+    }
+    maxFramesInFlight = input;
+    fences = std::vector<GLsync>(std::max(input, 0), nullptr);
+    nextFence = 0;
+}
+int FramePacer::getMaxFramesInFlight() const
+{
+    return maxFramesInFlight;
+}
+
+void FramePacer::beginFrame()
+{
+    TRACE_SCOPE("wait for GPU");
+    if(fences.empty() || fences[nextFence] == nullptr)
+    {
+        return;
+    }
+    // This fence went in maxFramesInFlight frames ago
+    GLenum result;
+    do
+    {
+        result = glFuncs.clientWaitSync(fences[nextFence], GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_NANOSECONDS);
+    } while(result == GL_TIMEOUT_EXPIRED);
+    glFuncs.deleteSync(fences[nextFence]);
+    fences[nextFence] = nullptr;
+}
+
+void FramePacer::endFrame()
+{
+    if(fences.empty())
+    {
+        return;
+    }
+    if(!glFuncs.hasSync)
+    {
+        // Without fences the only way to limit it is to wait for everything
+        if(maxFramesInFlight == 1)
+        {
+            glFinish();
+        }
+        return;
+    }
+    fences[nextFence] = glFuncs.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextFence = (nextFence + 1) % maxFramesInFlight;
+}
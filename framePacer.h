@@ -0,0 +1,40 @@
+#ifndef RANDOM_TERRAIN_FRAMEPACER_H
+#define RANDOM_TERRAIN_FRAMEPACER_H
+
+// Lets the CPU get ahead of the graphics card by a limited number of frames.
+// A fence goes in after each frame, and before starting a new frame we wait
+// for the fence from maxFramesInFlight frames ago. So the CPU can record the
+// next frame while the last one is still being drawn, without piling up
+// frames and adding input lag.
+
+#include "glFunctions.h"
+#include <vector>
+
+class FramePacer
+{
+private:
+    int maxFramesInFlight;
+    std::vector<GLsync> fences; // one per frame in flight, nullptr if unused
+    int nextFence;
+
+    // How long to wait for a fence at once, in nanoseconds
+    const static GLuint64 WAIT_NANOSECONDS = 100000000;
+public:
+    FramePacer();
+    explicit FramePacer(int inputMaxFramesInFlight);
+
+    // Only one pacer owns the fences
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Needs the window's context if there are fences to delete
+    void setMaxFramesInFlight(int input);
+    int getMaxFramesInFlight() const;
+
+    // Call before drawing. Waits until fewer than maxFramesInFlight frames are being drawn.
+    void beginFrame();
+    // Call after the frame has been swapped or flushed
+    void endFrame();
+};
+
+#endif //RANDOM_TERRAIN_FRAMEPACER_H
@@ -1,30 +1,22 @@
 #include "gameManager.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
 
 GameManager::GameManager()
 {
     screenWidth = 1024;
     screenHeight = 512;
-    renderRadius = 5;
-    chunkSeeds = PerlinNoiseGenerator(PERLIN_SEED_SIZE, PERLIN_SEED_SIZE, 0.2);
-    curColorScheme = Plain;
-
-    updateColorScheme(Plain);
-    initializePlayer();
-    updateCurrentChunks();
     initializeButtons();
     makeInstructions();
 }
-GameManager::GameManager(int inputScreenWidth, int inputScreenHeight, int inputRenderRadius)
+GameManager::GameManager(int inputScreenWidth, int inputScreenHeight, int inputRenderRadius, int inputPointsPerChunk,
+                         int inputWorldSeed) : World(inputRenderRadius, inputPointsPerChunk, inputWorldSeed)
 {
     screenWidth = inputScreenWidth;
     screenHeight = inputScreenHeight;
-    renderRadius = inputRenderRadius;
-    chunkSeeds = PerlinNoiseGenerator(PERLIN_SEED_SIZE, PERLIN_SEED_SIZE, 0.2);
-    curColorScheme = Plain;
-
-    updateColorScheme(Plain);
-    initializePlayer();
-    updateCurrentChunks();
     initializeButtons();
     makeInstructions();
 }
@@ -35,16 +27,6 @@ GameManager::GameManager(int inputScreenWidth, int inputScreenHeight, int inputR
 //
 // =================================
 
-void GameManager::initializePlayer()
-{
-    Point playerStartLoc = {0, PLAYER_HEIGHT/2, 0};
-    Point playerStartLook = {0, PLAYER_HEIGHT/2, -10};
-    Point playerStartUp = {0, PLAYER_HEIGHT, 0};
-    player = Player(playerStartLoc, playerStartLook, playerStartUp, PLAYER_SPEED, MOUSE_SENSITIVITY,
-                    PLAYER_HEIGHT, PLAYER_RADIUS, MAX_DISTANCE_FROM_SPAWN, GRAVITY, PLAYER_JUMP_AMOUNT);
-    currentPlayerChunkID = getChunkIDContainingPoint(player.getLocation(), CHUNK_SIZE);
-}
-
 void GameManager::initializeButtons()
 {
     playButton = Button(screenWidth/2, screenHeight/2, BUTTON_WIDTH, BUTTON_HEIGHT,
@@ -63,6 +45,7 @@ void GameManager::makeInstructions()
 {
     instructions.emplace_back("Use w,a,s,d to move and spacebar to jump. Press p to pause.");
     instructions.emplace_back("Hold e in addition to w,a,s, or d to go fast.");
+    instructions.emplace_back("Press r to raise the ground in front of you, f to dig it, or g to flatten it.");
     instructions.emplace_back("When paused, click the green button to cycle through the different color schemes.");
 }
 
@@ -72,34 +55,6 @@ void GameManager::makeInstructions()
 //
 // ===========================
 
-Player GameManager::getPlayer() const
-{
-    return player;
-}
-bool GameManager::getWKey() const
-{
-    return wKey;
-}
-bool GameManager::getAKey() const
-{
-    return aKey;
-}
-bool GameManager::getSKey() const
-{
-    return sKey;
-}
-bool GameManager::getDKey() const
-{
-    return dKey;
-}
-bool GameManager::getSpacebar() const
-{
-    return spacebar;
-}
-GameStatus GameManager::getCurrentStatus() const
-{
-    return currentStatus;
-}
 bool GameManager::getCloseWindow() const
 {
     return closeWindow;
@@ -109,162 +64,6 @@ bool GameManager::getShowMouse() const
     return showMouse;
 }
 
-// =============================
-//
-//           Setters
-//
-// =============================
-void GameManager::setWKey(bool input)
-{
-    wKey = input;
-    player.setVelocity(wKey, aKey, sKey, dKey);
-}
-void GameManager::setAKey(bool input)
-{
-    aKey = input;
-    player.setVelocity(wKey, aKey, sKey, dKey);
-}
-void GameManager::setSKey(bool input)
-{
-    sKey = input;
-    player.setVelocity(wKey, aKey, sKey, dKey);
-}
-void GameManager::setDKey(bool input)
-{
-    dKey = input;
-    player.setVelocity(wKey, aKey, sKey, dKey);
-}
-void GameManager::setSpacebar(bool input)
-{
-    spacebar = input;
-}
-void GameManager::setHyperSpeed(bool input)
-{
-    hyperSpeed = input;
-}
-void GameManager::setCurrentStatus(GameStatus input)
-{
-    currentStatus = input;
-}
-
-// =============================
-//
-//           Chunks
-//
-// ============================
-void GameManager::updateCurrentChunks()
-{
-    // Update the list of current chunks
-    currentChunks = std::vector<std::shared_ptr<Chunk>>();
-    std::vector<Point2D> chunksInRadius = getChunkTopLeftCornersAroundPoint(currentPlayerChunkID, renderRadius);
-    for(Point2D p : chunksInRadius)
-    {
-        int index = point2DtoChunkID(p);
-        if(allSeenChunks.count(index) == 0) // if the chunk has never been seen before
-        {
-            // Create and add a new Chunk
-            // Get the borders to make sure the terrain is seamless
-            std::vector<double> relativeHeightsAbove = getTerrainHeightsAbove(index, true);
-            std::vector<double> relativeHeightsBelow = getTerrainHeightsBelow(index, true);
-            std::vector<double> relativeHeightsLeft = getTerrainHeightsLeft(index, true);
-            std::vector<double> relativeHeightsRight = getTerrainHeightsRight(index, true);
-            std::vector<double> absoluteHeightsAbove = getTerrainHeightsAbove(index, false);
-            std::vector<double> absoluteHeightsBelow = getTerrainHeightsBelow(index, false);
-            std::vector<double> absoluteHeightsLeft = getTerrainHeightsLeft(index, false);
-            std::vector<double> absoluteHeightsRight = getTerrainHeightsRight(index, false);
-            // Make a generator for this chunk specifically
-            PerlinNoiseGenerator png = PerlinNoiseGenerator(POINTS_PER_CHUNK, POINTS_PER_CHUNK, 1,
-                                                            relativeHeightsAbove, relativeHeightsBelow,
-                                                            relativeHeightsLeft, relativeHeightsRight);
-            // Scale the noise
-            std::vector<std::vector<double>> noise = png.getScaledNoiseApplyBorders(0,1,
-                                                            relativeHeightsAbove, relativeHeightsBelow,
-                                                            relativeHeightsLeft, relativeHeightsRight);
-            RandomNumberGenerator rng;
-            bool hasCity = rng.getRandom() < 0.05;
-            // Create the chunk
-            allSeenChunks[index] = std::make_shared<Chunk>(p, CHUNK_SIZE, POINTS_PER_CHUNK, noise,
-                    TERRAIN_HEIGHT_FACTOR, getPerlinValue(p), absoluteHeightsAbove, absoluteHeightsBelow,
-                                                           absoluteHeightsLeft, absoluteHeightsRight,
-                                                           SNOW_LIMIT, ROCK_LIMIT, GRASS_LIMIT, WATER_LEVEL,
-                                                           snowColor, rockColor, grassColor, sandColor, waterColor,
-                                                           hasCity);
-        }
-        currentChunks.push_back(allSeenChunks[index]);
-    }
-}
-std::vector<double> GameManager::getTerrainHeightsAbove(int chunkID, bool isRelative) const
-{
-    int aboveID = getChunkIDAbove(chunkID);
-    if(allSeenChunks.count(aboveID) > 0)
-    {
-        return allSeenChunks.at(aboveID)->getBottomTerrainHeights(isRelative);
-    }
-    else
-    {
-        return std::vector<double>();
-    }
-}
-std::vector<double> GameManager::getTerrainHeightsBelow(int chunkID, bool isRelative) const
-{
-    int aboveID = getChunkIDBelow(chunkID);
-    if(allSeenChunks.count(aboveID) > 0)
-    {
-        return allSeenChunks.at(aboveID)->getTopTerrainHeights(isRelative);
-    }
-    else
-    {
-        return std::vector<double>();
-    }
-}
-std::vector<double> GameManager::getTerrainHeightsLeft(int chunkID, bool isRelative) const
-{
-    int aboveID = getChunkIDLeft(chunkID);
-    if(allSeenChunks.count(aboveID) > 0)
-    {
-        return allSeenChunks.at(aboveID)->getRightTerrainHeights(isRelative);
-    }
-    else
-    {
-        return std::vector<double>();
-    }
-}
-std::vector<double> GameManager::getTerrainHeightsRight(int chunkID, bool isRelative) const
-{
-    int aboveID = getChunkIDRight(chunkID);
-    if(allSeenChunks.count(aboveID) > 0)
-    {
-        return allSeenChunks.at(aboveID)->getLeftTerrainHeights(isRelative);
-    }
-    else
-    {
-        return std::vector<double>();
-    }
-}
-
-double GameManager::getPerlinValue(Point2D p)
-{
-    return chunkSeeds.getScaledNoise(0.1,1)[mod(p.x, PERLIN_SEED_SIZE)][mod(p.z, PERLIN_SEED_SIZE)];
-}
-
-// ====================================
-//
-//             Camera
-//
-// ===================================
-Point GameManager::getCameraLocation() const
-{
-    return player.getLocation();
-}
-Point GameManager::getCameraLookingAt() const
-{
-    return player.getLookingAt();
-}
-Point GameManager::getCameraUp() const
-{
-    return player.getUp();
-}
-
 // Mouse
 void GameManager::reactToMouseMovement(int mx, int my, double theta, double distance)
 {
@@ -344,56 +143,49 @@ void GameManager::reactToMouseClick(int mx, int my)
     }
 }
 
-void GameManager::draw() const
+void GameManager::makeSnapshot(FrameSnapshot &snapshot) const
 {
+    snapshot.cameraLocation = getCameraLocation();
+    snapshot.cameraLookingAt = getCameraLookingAt();
+    snapshot.cameraUp = getCameraUp();
+    snapshot.status = currentStatus;
+    snapshot.showMouse = showMouse;
+    snapshot.closeWindow = closeWindow;
+    snapshot.visibleChunks.clear();
     if(currentStatus == Playing || currentStatus == Paused)
     {
-        for(std::shared_ptr<Chunk> c : currentChunks)
+        for(const std::shared_ptr<Chunk> &c : currentChunks)
         {
-            c->draw();
+            if(isChunkInView(*c))
+            {
+                snapshot.visibleChunks.push_back(c);
+            }
         }
     }
-}
-
-// Tick helper functions
-void GameManager::tick()
-{
-    if(currentStatus == Playing)
+    snapshot.buttons.clear();
+    if(currentStatus == Intro)
     {
-        playerTick();
+        snapshot.buttons = {playButton, quitButton};
     }
-}
-void GameManager::playerTick()
-{
-    player.tick();
-    if(spacebar)
+    else if(currentStatus == Paused)
     {
-        player.tryToJump();
+        snapshot.buttons = {continueButton, quitButton, cycleColorsButton};
     }
-    if(hyperSpeed)
+    else if(currentStatus == End)
     {
-        for(int i = 0; i < HYPER_SPEED_FACTOR; i++)
-        {
-            player.moveXZ();
-        }
+        snapshot.buttons = {playAgainButton, quitButton};
     }
-
-    // Check if the player has entered a new chunk
-    int newPlayerChunkID = getChunkIDContainingPoint(player.getLocation(), CHUNK_SIZE);
-    if(newPlayerChunkID != currentPlayerChunkID)
+}
+void GameManager::draw(const FrameSnapshot &snapshot) const
+{
+    TRACE_SCOPE("draw");
+    for(const std::shared_ptr<Chunk> &c : snapshot.visibleChunks)
     {
-        currentPlayerChunkID = newPlayerChunkID;
-        updateCurrentChunks();
+        c->draw();
     }
-    player.setCurrentTerrainHeight(allSeenChunks[currentPlayerChunkID]->getHeightAt(player.getLocation()));
 }
 
 // Game Management
-void GameManager::resetGame()
-{
-    initializePlayer();
-    currentStatus = Playing;
-}
 void GameManager::togglePaused()
 {
     if(currentStatus == Paused)
@@ -407,90 +199,22 @@ void GameManager::togglePaused()
         showMouse = true;
     }
 }
-void GameManager::cycleColors()
-{
-    if(curColorScheme == Plain)
-    {
-        curColorScheme = Majestic;
-    }
-    else if(curColorScheme == Majestic)
-    {
-        curColorScheme = Lava;
-    }
-    else if(curColorScheme == Lava)
-    {
-        curColorScheme = Ice;
-    }
-    else if(curColorScheme == Ice)
-    {
-        curColorScheme = Plain;
-    }
-    updateColorScheme(curColorScheme);
-}
-void GameManager::updateColorScheme(ColorScheme inputScheme)
-{
-    if(inputScheme == Plain)
-    {
-        snowColor = SNOW_COLOR_PLAIN;
-        rockColor = ROCK_COLOR_PLAIN;
-        grassColor = GRASS_COLOR_PLAIN;
-        sandColor = SAND_COLOR_PLAIN;
-        waterColor = WATER_COLOR_PLAIN;
-    }
-    else if(inputScheme == Majestic)
-    {
-        snowColor = SNOW_COLOR_MAJESTIC;
-        rockColor = ROCK_COLOR_MAJESTIC;
-        grassColor = GRASS_COLOR_MAJESTIC;
-        sandColor = SAND_COLOR_MAJESTIC;
-        waterColor = WATER_COLOR_MAJESTIC;
-    }
-    else if(inputScheme == Lava)
-    {
-        snowColor = SNOW_COLOR_LAVA;
-        rockColor = ROCK_COLOR_LAVA;
-        grassColor = GRASS_COLOR_LAVA;
-        sandColor = SAND_COLOR_LAVA;
-        waterColor = WATER_COLOR_LAVA;
-    }
-    else if(inputScheme == Ice)
-    {
-        snowColor = SNOW_COLOR_ICE;
-        rockColor = ROCK_COLOR_ICE;
-        grassColor = GRASS_COLOR_ICE;
-        sandColor = SAND_COLOR_ICE;
-        waterColor = WATER_COLOR_ICE;
-    }
-    for (std::pair<int, std::shared_ptr<Chunk>> element : allSeenChunks)
-    {
-        element.second->initializeTerrainColorMap(snowColor, rockColor, grassColor, sandColor, waterColor);
-        element.second->initializeSquareColors();
-    }
-}
 
 // UI
-void GameManager::drawUI() const
+void GameManager::drawUI(const FrameSnapshot &snapshot) const
 {
-    if(currentStatus == Intro)
-    {
-        playButton.draw();
-        quitButton.draw();
-        displayInstructions();
-    }
-    else if(currentStatus == Playing)
+    TRACE_SCOPE("drawUI");
+    for(const Button &b : snapshot.buttons)
     {
-        drawCursor();
+        b.draw();
     }
-    else if(currentStatus == Paused)
+    if(snapshot.status == Intro)
     {
-        continueButton.draw();
-        quitButton.draw();
-        cycleColorsButton.draw();
+        displayInstructions();
     }
-    else if(currentStatus == End)
+    else if(snapshot.status == Playing)
     {
-        playAgainButton.draw();
-        quitButton.draw();
+        drawCursor();
     }
 }
 void GameManager::drawCursor() const
@@ -513,13 +237,9 @@ void GameManager::drawCursor() const
 void GameManager::displayInstructions() const
 {
     setGLColor(BLACK);
-    for(int i = 0; i < instructions.size(); i++)
+    for(int i = 0; i < (int)instructions.size(); i++)
     {
-        std::string s = instructions[i];
         glRasterPos2i(10, screenHeight - 15*i - 15);
-        for(const char &letter : s)
-        {
-            glutBitmapCharacter(GLUT_BITMAP_9_BY_15, letter);
-        }
+        drawText(instructions[i]);
     }
 }
@@ -4,36 +4,25 @@
 #include <vector>
 #include <memory>
 #include <iostream>
-#include <unordered_map>
-#include "player.h"
-#include "structs.h"
-#include "chunk.h"
-#include "mathHelper.h"
+#include "world.h"
 #include "button.h"
-#include "perlinNoiseGenerator.h"
 
-enum GameStatus {Intro, Playing, End, Paused};
-enum ColorScheme {Plain, Majestic, Lava, Ice};
+// Everything needed to draw one frame, copied out of the GameManager by the
+// game's thread so the drawing thread never reads the game while it changes
+struct FrameSnapshot
+{
+    Point cameraLocation, cameraLookingAt, cameraUp;
+    GameStatus status;
+    bool showMouse;
+    bool closeWindow;
+    std::vector<std::shared_ptr<Chunk>> visibleChunks;
+    std::vector<Button> buttons; // the buttons on the current screen
+};
 
-class GameManager
+// The world with its menus, and the drawing of both
+class GameManager : public World
 {
 private:
-    Player player;
-
-    // Controls
-    bool wKey, aKey, sKey, dKey, spacebar, hyperSpeed;
-
-    // Chunks
-    PerlinNoiseGenerator chunkSeeds;
-    int renderRadius;
-    std::unordered_map<int, std::shared_ptr<Chunk>> allSeenChunks;
-    std::vector<std::shared_ptr<Chunk>> currentChunks;
-    int currentPlayerChunkID;
-    ColorScheme curColorScheme;
-    RGBAcolor snowColor, rockColor, grassColor, sandColor, waterColor;
-
-    GameStatus currentStatus;
-
     // UI
     int screenWidth, screenHeight;
 
@@ -47,43 +36,7 @@ private:
     bool closeWindow = false;
     bool showMouse = true;
 
-    // Game parameters
-    int CHUNK_SIZE = 512;
-    int POINTS_PER_CHUNK = 30;
-    int PERLIN_SEED_SIZE = 10;
-    double TERRAIN_HEIGHT_FACTOR = 500;
-    double SNOW_LIMIT = 920;
-    double ROCK_LIMIT = 750;
-    double GRASS_LIMIT = 120;
-    double WATER_LEVEL = 95;
-    RGBAcolor SNOW_COLOR_PLAIN = {1.0, 0.9, 1.0, 1.0};
-    RGBAcolor ROCK_COLOR_PLAIN = {0.6, 0.64, 0.62, 1.0};
-    RGBAcolor GRASS_COLOR_PLAIN = {0.2, 0.75, 0.08, 1.0};
-    RGBAcolor SAND_COLOR_PLAIN = {1.0, 0.84, 0.33, 1.0};
-    RGBAcolor WATER_COLOR_PLAIN = {0.0, 0.24, 1.0, 0.75};
-    RGBAcolor SNOW_COLOR_MAJESTIC = {1.0, 0.9, 0.9, 1.0};
-    RGBAcolor ROCK_COLOR_MAJESTIC = {0.4, 0.1, 0.42, 1.0};
-    RGBAcolor GRASS_COLOR_MAJESTIC = {0.1, 0.48, 0.13, 1.0};
-    RGBAcolor SAND_COLOR_MAJESTIC = {0.92, 0.82, 0.39, 1.0};
-    RGBAcolor WATER_COLOR_MAJESTIC = {0.0, 0.54, 0.44, 0.75};
-    RGBAcolor SNOW_COLOR_LAVA = {0.8, 0.2, 0.2, 0.99};
-    RGBAcolor ROCK_COLOR_LAVA = {0.05, 0.0, 0.05, 1.0};
-    RGBAcolor GRASS_COLOR_LAVA = {0.2, 0.25, 0.25, 1.0};
-    RGBAcolor SAND_COLOR_LAVA = {0.15, 0.02, 0.01, 1.0};
-    RGBAcolor WATER_COLOR_LAVA = {0.9, 0.5, 0.0, 0.87};
-    RGBAcolor SNOW_COLOR_ICE = {0.5, 0.5, 1.0, 0.95};
-    RGBAcolor ROCK_COLOR_ICE = {0.85, 0.85, 1.0, 0.95};
-    RGBAcolor GRASS_COLOR_ICE = {0.65, 0.65, 0.65, 1.0};
-    RGBAcolor SAND_COLOR_ICE =  {0.92, 0.82, 0.39, 1.0};
-    RGBAcolor WATER_COLOR_ICE = {0.75, 0.75, 1.0, 0.87};
-    double PLAYER_HEIGHT = 10;
-    double PLAYER_RADIUS = 3;
-    double PLAYER_SPEED = 1.5;
-    double MOUSE_SENSITIVITY = 0.005;
-    int MAX_DISTANCE_FROM_SPAWN = 20480; // 20 chunks
-    double GRAVITY = -0.5;
-    double PLAYER_JUMP_AMOUNT = 6;
-    int HYPER_SPEED_FACTOR = 6;
+    // UI parameters
     int BUTTON_WIDTH = 128;
     int BUTTON_HEIGHT = 64;
     int BUTTON_RADIUS = 16;
@@ -98,71 +51,31 @@ private:
     RGBAcolor BLACK = {0.0, 0.0, 0.0, 1.0};
 public:
     GameManager();
-    GameManager(int inputScreenWidth, int inputScreenHeight, int inputRenderRadius);
+    // A negative seed picks one at random
+    GameManager(int inputScreenWidth, int inputScreenHeight, int inputRenderRadius, int inputPointsPerChunk = 30,
+                int inputWorldSeed = -1);
 
     // Helper functions for the constructors
-    void initializePlayer();
     void initializeButtons();
     void makeInstructions();
 
     // Getters
-    Player getPlayer() const;
-    bool getWKey() const;
-    bool getAKey() const;
-    bool getSKey() const;
-    bool getDKey() const;
-    bool getSpacebar() const;
-    GameStatus getCurrentStatus() const;
     bool getCloseWindow() const;
     bool getShowMouse() const;
 
-    // Setters
-    void setWKey(bool input);
-    void setAKey(bool input);
-    void setSKey(bool input);
-    void setDKey(bool input);
-    void setSpacebar(bool input);
-    void setHyperSpeed(bool input);
-    void setCurrentStatus(GameStatus input);
-
-    // Chunks
-    void updateCurrentChunks();
-    // If the specified adjacent chunk has been created already, then
-    // this returns the relevant border of terrain points.
-    // Otherwise, returns empty vector
-    std::vector<double> getTerrainHeightsAbove(int chunkID, bool isRelative) const;
-    std::vector<double> getTerrainHeightsBelow(int chunkID, bool isRelative) const;
-    std::vector<double> getTerrainHeightsLeft(int chunkID, bool isRelative) const;
-    std::vector<double> getTerrainHeightsRight(int chunkID, bool isRelative) const;
-
-    // Given the topLeft chunkCoords of a chunk, this returns the perlin seed
-    // (between 0 and 1) for it given by the chunkSeeds P.N.G.
-    double getPerlinValue(Point2D p);
-
-    // Camera
-    Point getCameraLocation() const;
-    Point getCameraLookingAt() const;
-    Point getCameraUp() const;
-
     // Mouse
     void reactToMouseMovement(int mx, int my, double theta, double distance);
     void reactToMouseClick(int mx, int my);
 
-    void draw() const;
-
-    // Tick helper functions
-    void tick();
-    void playerTick();
+    // Copy what the current frame needs to draw
+    void makeSnapshot(FrameSnapshot &snapshot) const;
+    void draw(const FrameSnapshot &snapshot) const;
 
     // Game Management
-    void checkForGameEnd();
-    void resetGame();
     void togglePaused();
-    void cycleColors();
-    void updateColorScheme(ColorScheme inputScheme);
 
     // UI
-    void drawUI() const;
+    void drawUI(const FrameSnapshot &snapshot) const;
     void drawCursor() const;
     void displayInstructions() const;
 };
@@ -0,0 +1,152 @@
+#include "glFunctions.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef __APPLE__
+#include <GL/freeglut_ext.h>
+#endif
+
+GLFunctions glFuncs;
+
+static void *lookUpWithGLUT(const char *name)
+{
+#ifdef __APPLE__
+    return nullptr;
+#else
+    return reinterpret_cast<void*>(glutGetProcAddress(name));
+#endif
+}
+static GLProcLookup procLookup = lookUpWithGLUT;
+
+// Returns nullptr if the function can't be found
+static void *lookUp(const char *name)
+{
+    return procLookup(name);
+}
+
+// Try the core name first, then the ARB extension name
+static void *lookUp(const char *name, const char *arbName)
+{
+    void *f = lookUp(name);
+    return f ? f : lookUp(arbName);
+}
+
+// Some platforms hand back a pointer even for functions the driver doesn't
+// support, so the version and extensions have to be checked as well
+static bool hasVersion(int major, int minor)
+{
+    const char *version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int actualMajor = 0, actualMinor = 0;
+    if(version == nullptr || sscanf(version, "%d.%d", &actualMajor, &actualMinor) != 2)
+    {
+        return false;
+    }
+    return actualMajor > major || (actualMajor == major && actualMinor >= minor);
+}
+static bool hasExtension(const char *name)
+{
+    const char *extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    return extensions != nullptr && strstr(extensions, name) != nullptr;
+}
+
+void loadGLFunctions()
+{
+    loadGLFunctions(lookUpWithGLUT);
+    glFuncs.hasBitmapText = true;
+}
+void loadGLFunctions(GLProcLookup lookUpFunction)
+{
+    glFuncs = GLFunctions();
+    procLookup = lookUpFunction;
+
+    glFuncs.genBuffers = reinterpret_cast<PFNGLGENBUFFERSPROC>(lookUp("glGenBuffers", "glGenBuffersARB"));
+    glFuncs.deleteBuffers = reinterpret_cast<PFNGLDELETEBUFFERSPROC>(lookUp("glDeleteBuffers", "glDeleteBuffersARB"));
+    glFuncs.bindBuffer = reinterpret_cast<PFNGLBINDBUFFERPROC>(lookUp("glBindBuffer", "glBindBufferARB"));
+    glFuncs.bufferData = reinterpret_cast<PFNGLBUFFERDATAPROC>(lookUp("glBufferData", "glBufferDataARB"));
+    glFuncs.bufferSubData = reinterpret_cast<PFNGLBUFFERSUBDATAPROC>(lookUp("glBufferSubData", "glBufferSubDataARB"));
+    glFuncs.getBufferSubData = reinterpret_cast<PFNGLGETBUFFERSUBDATAPROC>(lookUp("glGetBufferSubData", "glGetBufferSubDataARB"));
+    glFuncs.hasBuffers = (hasVersion(1, 5) || hasExtension("GL_ARB_vertex_buffer_object")) &&
+                         glFuncs.genBuffers && glFuncs.deleteBuffers && glFuncs.bindBuffer && glFuncs.bufferData &&
+                         glFuncs.bufferSubData;
+
+    glFuncs.createShader = reinterpret_cast<PFNGLCREATESHADERPROC>(lookUp("glCreateShader"));
+    glFuncs.deleteShader = reinterpret_cast<PFNGLDELETESHADERPROC>(lookUp("glDeleteShader"));
+    glFuncs.shaderSource = reinterpret_cast<PFNGLSHADERSOURCEPROC>(lookUp("glShaderSource"));
+    glFuncs.compileShader = reinterpret_cast<PFNGLCOMPILESHADERPROC>(lookUp("glCompileShader"));
+    glFuncs.getShaderiv = reinterpret_cast<PFNGLGETSHADERIVPROC>(lookUp("glGetShaderiv"));
+    glFuncs.getShaderInfoLog = reinterpret_cast<PFNGLGETSHADERINFOLOGPROC>(lookUp("glGetShaderInfoLog"));
+    glFuncs.createProgram = reinterpret_cast<PFNGLCREATEPROGRAMPROC>(lookUp("glCreateProgram"));
+    glFuncs.deleteProgram = reinterpret_cast<PFNGLDELETEPROGRAMPROC>(lookUp("glDeleteProgram"));
+    glFuncs.attachShader = reinterpret_cast<PFNGLATTACHSHADERPROC>(lookUp("glAttachShader"));
+    glFuncs.bindAttribLocation = reinterpret_cast<PFNGLBINDATTRIBLOCATIONPROC>(lookUp("glBindAttribLocation"));
+    glFuncs.linkProgram = reinterpret_cast<PFNGLLINKPROGRAMPROC>(lookUp("glLinkProgram"));
+    glFuncs.getProgramiv = reinterpret_cast<PFNGLGETPROGRAMIVPROC>(lookUp("glGetProgramiv"));
+    glFuncs.getProgramInfoLog = reinterpret_cast<PFNGLGETPROGRAMINFOLOGPROC>(lookUp("glGetProgramInfoLog"));
+    glFuncs.useProgram = reinterpret_cast<PFNGLUSEPROGRAMPROC>(lookUp("glUseProgram"));
+    glFuncs.enableVertexAttribArray = reinterpret_cast<PFNGLENABLEVERTEXATTRIBARRAYPROC>(lookUp("glEnableVertexAttribArray"));
+    glFuncs.disableVertexAttribArray = reinterpret_cast<PFNGLDISABLEVERTEXATTRIBARRAYPROC>(lookUp("glDisableVertexAttribArray"));
+    glFuncs.vertexAttribPointer = reinterpret_cast<PFNGLVERTEXATTRIBPOINTERPROC>(lookUp("glVertexAttribPointer"));
+    glFuncs.hasShaders = hasVersion(2, 0) && glFuncs.createShader && glFuncs.deleteShader && glFuncs.shaderSource &&
+                         glFuncs.compileShader && glFuncs.getShaderiv && glFuncs.getShaderInfoLog &&
+                         glFuncs.createProgram && glFuncs.deleteProgram && glFuncs.attachShader && glFuncs.bindAttribLocation &&
+                         glFuncs.linkProgram && glFuncs.getProgramiv && glFuncs.getProgramInfoLog &&
+                         glFuncs.useProgram && glFuncs.enableVertexAttribArray &&
+                         glFuncs.disableVertexAttribArray && glFuncs.vertexAttribPointer;
+
+    glFuncs.vertexAttribDivisor = reinterpret_cast<PFNGLVERTEXATTRIBDIVISORPROC>(
+            lookUp("glVertexAttribDivisor", "glVertexAttribDivisorARB"));
+    glFuncs.drawArraysInstanced = reinterpret_cast<PFNGLDRAWARRAYSINSTANCEDPROC>(
+            lookUp("glDrawArraysInstanced", "glDrawArraysInstancedARB"));
+    glFuncs.hasInstancing = (hasVersion(3, 3) ||
+                             (hasExtension("GL_ARB_instanced_arrays") && hasExtension("GL_ARB_draw_instanced"))) &&
+                            glFuncs.hasBuffers && glFuncs.hasShaders &&
+                            glFuncs.vertexAttribDivisor && glFuncs.drawArraysInstanced;
+
+    glFuncs.fenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(lookUp("glFenceSync"));
+    glFuncs.clientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(lookUp("glClientWaitSync"));
+    glFuncs.deleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(lookUp("glDeleteSync"));
+    glFuncs.hasSync = (hasVersion(3, 2) || hasExtension("GL_ARB_sync")) &&
+                      glFuncs.fenceSync && glFuncs.clientWaitSync && glFuncs.deleteSync;
+
+    // The swap interval belongs to the window system, not OpenGL, so there is no version to check
+    typedef int (APIENTRY *SwapIntervalProc)(int);
+#ifdef _WIN32
+    glFuncs.swapInterval = reinterpret_cast<SwapIntervalProc>(lookUp("wglSwapIntervalEXT"));
+#else
+    glFuncs.swapInterval = reinterpret_cast<SwapIntervalProc>(lookUp("glXSwapIntervalMESA", "glXSwapIntervalSGI"));
+#endif
+    glFuncs.hasSwapControl = procLookup == lookUpWithGLUT && glFuncs.swapInterval != nullptr;
+}
+
+void drawPoint(Point p)
+{
+    glVertex3f(p.x, p.y, p.z);
+}
+void drawPoint2D(Point p)
+{
+    glVertex2f(p.x, p.y);
+}
+void setGLColor(RGBAcolor color)
+{
+    glColor4f(color.r, color.g, color.b, color.a);
+}
+void cull()
+{
+    glEnable(GL_CULL_FACE);
+}
+void unCull()
+{
+    glDisable(GL_CULL_FACE);
+}
+void drawText(const std::string &text)
+{
+    if(!glFuncs.hasBitmapText)
+    {
+        return;
+    }
+    for(const char &letter : text)
+    {
+        glutBitmapCharacter(GLUT_BITMAP_9_BY_15, letter);
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef RANDOM_TERRAIN_GLFUNCTIONS_H
+#define RANDOM_TERRAIN_GLFUNCTIONS_H
+
+// GLUT only gives us OpenGL 1.1 functions on some platforms, so anything newer
+// (buffers, shaders, instancing) is looked up at runtime. If a feature isn't
+// available, the has___ flag is false and the caller uses immediate mode instead.
+
+#include "graphics.h"
+#include <string>
+
+#ifdef __APPLE__
+#include <OpenGL/glext.h>
+#else
+#include <GL/glext.h>
+#endif
+
+struct GLFunctions
+{
+    // Vertex buffer objects (OpenGL 1.5)
+    bool hasBuffers = false;
+    PFNGLGENBUFFERSPROC genBuffers = nullptr;
+    PFNGLDELETEBUFFERSPROC deleteBuffers = nullptr;
+    PFNGLBINDBUFFERPROC bindBuffer = nullptr;
+    PFNGLBUFFERDATAPROC bufferData = nullptr;
+    PFNGLBUFFERSUBDATAPROC bufferSubData = nullptr;
+    PFNGLGETBUFFERSUBDATAPROC getBufferSubData = nullptr; // only for checking uploads
+
+    // Shaders (OpenGL 2.0)
+    bool hasShaders = false;
+    PFNGLCREATESHADERPROC createShader = nullptr;
+    PFNGLDELETESHADERPROC deleteShader = nullptr;
+    PFNGLSHADERSOURCEPROC shaderSource = nullptr;
+    PFNGLCOMPILESHADERPROC compileShader = nullptr;
+    PFNGLGETSHADERIVPROC getShaderiv = nullptr;
+    PFNGLGETSHADERINFOLOGPROC getShaderInfoLog = nullptr;
+    PFNGLCREATEPROGRAMPROC createProgram = nullptr;
+    PFNGLDELETEPROGRAMPROC deleteProgram = nullptr;
+    PFNGLATTACHSHADERPROC attachShader = nullptr;
+    PFNGLBINDATTRIBLOCATIONPROC bindAttribLocation = nullptr;
+    PFNGLLINKPROGRAMPROC linkProgram = nullptr;
+    PFNGLGETPROGRAMIVPROC getProgramiv = nullptr;
+    PFNGLGETPROGRAMINFOLOGPROC getProgramInfoLog = nullptr;
+    PFNGLUSEPROGRAMPROC useProgram = nullptr;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC enableVertexAttribArray = nullptr;
+    PFNGLDISABLEVERTEXATTRIBARRAYPROC disableVertexAttribArray = nullptr;
+    PFNGLVERTEXATTRIBPOINTERPROC vertexAttribPointer = nullptr;
+
+    // Instanced drawing (OpenGL 3.3 or ARB_instanced_arrays)
+    bool hasInstancing = false;
+    PFNGLVERTEXATTRIBDIVISORPROC vertexAttribDivisor = nullptr;
+    PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced = nullptr;
+
+    // Fences, for knowing when the graphics card has finished a frame (OpenGL 3.2 or ARB_sync)
+    bool hasSync = false;
+    PFNGLFENCESYNCPROC fenceSync = nullptr;
+    PFNGLCLIENTWAITSYNCPROC clientWaitSync = nullptr;
+    PFNGLDELETESYNCPROC deleteSync = nullptr;
+
+    // Vsync (GLX_MESA_swap_control, GLX_SGI_swap_control, or WGL_EXT_swap_control)
+    bool hasSwapControl = false;
+    int (APIENTRY *swapInterval)(int interval) = nullptr;
+
+    // GLUT's bitmap fonts, which only work in a GLUT window
+    bool hasBitmapText = false;
+};
+
+extern GLFunctions glFuncs;
+
+// Look up all of the functions. Must be called after the window is created.
+void loadGLFunctions();
+// The same, for a context that GLUT didn't make (see offscreenContext.h).
+// There is no vsync or text in that case.
+typedef void *(*GLProcLookup)(const char *name);
+void loadGLFunctions(GLProcLookup lookUpFunction);
+
+// Shortcut functions
+void drawPoint(Point p);            // Calls glVertex3f
+void drawPoint2D(Point p);          // Calls glVertex2f on x and y
+void setGLColor(RGBAcolor color);   // Calls glColor4f
+void cull();                        // glEnable(GL_CULL_FACE)
+void unCull();                      // glDisable(GL_CULL_FACE)
+void drawText(const std::string &text); // Draws at the raster position, if there is bitmap text
+
+#endif //RANDOM_TERRAIN_GLFUNCTIONS_H
@@ -6,14 +6,60 @@
 
 
 #include "graphics.h"
+#include "glFunctions.h"
 #include "gameManager.h"
+#include "simulation.h"
+#include "framePacer.h"
+#include "chunkUploader.h"
+#include "flythrough.h"
+#include "inputLog.h"
+#include "offscreenContext.h"
+#include "screenshot.h"
+#include "trace.h"
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <memory>
+#include <algorithm>
 
 GLdouble width, height;
 int wd;
-GameManager manager;
+// A recording to play back instead of taking input
+InputLog replayLog;
+bool replayMode = false;
+std::chrono::steady_clock::time_point replayStart;
+// Made once the command line has been read, since the world seed can come from it
+std::unique_ptr<GameManager> manager;
+// Runs the manager on its own thread once the window is open
+std::unique_ptr<Simulation> simulation;
 // Mouse variables
 int prevMouseX, prevMouseY;
 bool justClicked;
+bool cursorShown;
+// Presentation options, set from the command line
+bool doubleBuffered = true;
+bool vsync = true;
+int maxFramesInFlight = 2;
+// Leave a core each for drawing and for the game
+int chunkThreads = std::max(1, (int)std::thread::hardware_concurrency() - 2);
+FramePacer framePacer;
+ChunkUploader chunkUploader;
+// The scripted flythrough, if it was asked for on the command line
+bool flythroughMode = false;
+Flythrough flythrough;
+FrameStats flythroughStats;
+FrameSnapshot flythroughSnapshot;
+double hitchMilliseconds = 1000.0/30;
+// Drawing into a buffer with no window, for machines without a display
+bool headless = false;
+OffscreenContext offscreen;
+// Saved and compared when a headless run ends
+const char *screenshotPath = nullptr;
+const char *referencePath = nullptr;
+int screenshotTolerance = 0;
+// Where the trace goes, if tracing was asked for
+const char *tracePath = nullptr;
 
 void init()
 {
@@ -22,11 +68,25 @@ void init()
     prevMouseX = width/2;
     prevMouseY = height/2;
     justClicked = false;
+    cursorShown = true;
 }
 
 /* Initialize OpenGL Graphics */
 void initGL()
 {
+    // Find the functions that aren't part of OpenGL 1.1. The offscreen
+    // context already did this when it was made.
+    if(!headless)
+    {
+        loadGLFunctions();
+    }
+
+    if(doubleBuffered && glFuncs.hasSwapControl)
+    {
+        glFuncs.swapInterval(vsync ? 1 : 0);
+    }
+    framePacer.setMaxFramesInFlight(maxFramesInFlight);
+
     // Enable alpha transparency
     // Code from https://www.opengl.org/archives/resources/faq/technical/transparency.htm
     glEnable (GL_BLEND);
@@ -40,9 +100,9 @@ void initGL()
     // Initialize the camera where the player is, because during the intro screen,
     // if the camera gets put in a different place, it would be messed up when the
     // game starts if you initialize it to the intro location.
-    Point camLoc = manager.getPlayer().getLocation();
-    Point camLook = manager.getPlayer().getLookingAt();
-    Point camUp = manager.getPlayer().getUp();
+    Point camLoc = manager->getPlayer().getLocation();
+    Point camLook = manager->getPlayer().getLookingAt();
+    Point camUp = manager->getPlayer().getUp();
     gluLookAt(camLoc.x, camLoc.y, camLoc.z,  // eye position
               camLook.x, camLook.y, camLook.z,  // center position (not gaze direction)
               camUp.x, camUp.y, camUp.z); // up vector
@@ -52,6 +112,34 @@ void initGL()
  whenever the window needs to be re-painted. */
 void display()
 {
+    const FrameSnapshot &snapshot = simulation->getLatestSnapshot();
+    if(snapshot.closeWindow)
+    {
+        quit();
+    }
+    if(replayMode && simulation->isReplayDone())
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+        printf("Replayed %.2f s of play in %.2f s\n", replayLog.getMilliseconds()/1000, seconds);
+        quit();
+    }
+    // Only show the cursor on the menus
+    if(!headless && snapshot.showMouse != cursorShown)
+    {
+        glutSetCursor(snapshot.showMouse ? GLUT_CURSOR_LEFT_ARROW : GLUT_CURSOR_NONE);
+        cursorShown = snapshot.showMouse;
+    }
+
+    // Don't get more than maxFramesInFlight frames ahead of the graphics card
+    framePacer.beginFrame();
+    drawFrame(snapshot);
+    presentFrame();
+    framePacer.endFrame();
+}
+
+void drawFrame(const FrameSnapshot &snapshot)
+{
+    TRACE_SCOPE("drawFrame");
     glLineWidth(3.0);
 
     // tell OpenGL to use the whole window for drawing
@@ -67,15 +155,18 @@ void display()
     glPolygonMode(GL_FRONT, GL_FILL);
 
     // Update where the camera is
-    Point camLoc = manager.getCameraLocation();
-    Point camLook = manager.getCameraLookingAt();
-    Point camUp = manager.getCameraUp();
+    Point camLoc = snapshot.cameraLocation;
+    Point camLook = snapshot.cameraLookingAt;
+    Point camUp = snapshot.cameraUp;
     gluLookAt(camLoc.x, camLoc.y, camLoc.z,  // eye position
               camLook.x, camLook.y, camLook.z,  // center position (not gaze direction)
               camUp.x, camUp.y, camUp.z); // up vector
 
+    // Send a few of the new chunks to the graphics card, closest first
+    chunkUploader.uploadChunks(snapshot.visibleChunks, camLoc);
+
     // Draw in 3d
-    manager.draw();
+    manager->draw(snapshot);
 
     // Switch to 2d mode
     // Code from https://www.youtube.com/watch?v=i1mp4zflkYo
@@ -88,14 +179,59 @@ void display()
     glLoadIdentity();
 
     // Draw UI things
-    manager.drawUI();
+    manager->drawUI(snapshot);
 
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
     glPopMatrix();
+}
+
+void presentFrame()
+{
+    TRACE_SCOPE("presentFrame");
+    if(headless)
+    {
+        offscreen.swapBuffers();
+    }
+    else if(doubleBuffered)
+    {
+        glutSwapBuffers(); // Show the frame we just drew
+    }
+    else
+    {
+        glFlush();  // Render now
+    }
+}
 
-    glFlush();  // Render now
+void displayFlythrough()
+{
+    auto frameStart = std::chrono::steady_clock::now();
+    if(!flythrough.steer(*manager))
+    {
+        flythroughStats.printReport(hitchMilliseconds);
+        quit();
+    }
+
+    // Exactly one tick per frame, so every run takes the same path
+    int chunkBefore = manager->getCurrentPlayerChunkID();
+    manager->update(manager->getTickMilliseconds());
+    manager->makeSnapshot(flythroughSnapshot);
+    auto updated = std::chrono::steady_clock::now();
+
+    framePacer.beginFrame();
+    drawFrame(flythroughSnapshot);
+    presentFrame();
+    framePacer.endFrame();
+    auto drawn = std::chrono::steady_clock::now();
+
+    FrameTimes times;
+    times.frame = std::chrono::duration<double, std::milli>(drawn - frameStart).count();
+    times.chunks = manager->getLastChunkMilliseconds();
+    times.tick = std::chrono::duration<double, std::milli>(updated - frameStart).count() - times.chunks;
+    times.draw = std::chrono::duration<double, std::milli>(drawn - updated).count();
+    times.enteredNewChunk = manager->getCurrentPlayerChunkID() != chunkBefore;
+    flythroughStats.record(times);
 }
 
 // http://www.theasciicode.com.ar/ascii-control-characters/escape-ascii-code-27.html
@@ -104,23 +240,30 @@ void kbd(unsigned char key, int x, int y)
     // escape
     if(key == 27)
     {
-        glutDestroyWindow(wd);
-        exit(0);
+        quit();
     }
 
     switch(key)
     {
-        case 'w': manager.setWKey(true);
+        case 'w': simulation->queueInput(GameInput::keyChange(WKey, true));
+            break;
+        case 'a': simulation->queueInput(GameInput::keyChange(AKey, true));
             break;
-        case 'a': manager.setAKey(true);
+        case 's': simulation->queueInput(GameInput::keyChange(SKey, true));
             break;
-        case 's': manager.setSKey(true);
+        case 'd': simulation->queueInput(GameInput::keyChange(DKey, true));
             break;
-        case 'd': manager.setDKey(true);
+        case 32: simulation->queueInput(GameInput::keyChange(SpacebarKey, true));
             break;
-        case 32: manager.setSpacebar(true);
+        case 'e':  simulation->queueInput(GameInput::keyChange(HyperSpeedKey, true));
             break;
-        case 'e':  manager.setHyperSpeed(true);
+        case 't': saveTrace();
+            break;
+        case 'r': simulation->queueInput(GameInput::deform(Raise));
+            break;
+        case 'f': simulation->queueInput(GameInput::deform(Dig));
+            break;
+        case 'g': simulation->queueInput(GameInput::deform(Flatten));
             break;
     }
 
@@ -134,22 +277,19 @@ void kbu(unsigned char key, int x, int y)
 {
     switch(key)
     {
-        case 'w': manager.setWKey(false);
+        case 'w': simulation->queueInput(GameInput::keyChange(WKey, false));
             break;
-        case 'a': manager.setAKey(false);
+        case 'a': simulation->queueInput(GameInput::keyChange(AKey, false));
             break;
-        case 's': manager.setSKey(false);
+        case 's': simulation->queueInput(GameInput::keyChange(SKey, false));
             break;
-        case 'd': manager.setDKey(false);
+        case 'd': simulation->queueInput(GameInput::keyChange(DKey, false));
             break;
-        case 'p' : if(manager.getCurrentStatus() != Paused)
-            {
-                manager.togglePaused();
-            }
+        case 'p' : simulation->queueInput(GameInput::pause());
             break;
-        case 32 : manager.setSpacebar(false);
+        case 32 : simulation->queueInput(GameInput::keyChange(SpacebarKey, false));
             break;
-        case 'e':  manager.setHyperSpeed(false);
+        case 'e':  simulation->queueInput(GameInput::keyChange(HyperSpeedKey, false));
             break;
     }
 
@@ -170,12 +310,12 @@ void cursor(int x, int y)
     }
     double theta = atan2(y - prevMouseY, x - prevMouseX);
     double distance = distanceFormula(x, y, prevMouseX, prevMouseY);
-    manager.reactToMouseMovement(x, y, theta, distance);
+    simulation->queueInput(GameInput::mouseMove(x, y, theta, distance));
     prevMouseX = x;
     prevMouseY = y;
 
     // If the cursor gets close to the edge during the game, put it back in the middle.
-    if(manager.getCurrentStatus() == Playing && (x < 120 || x > width - 120 || y < 120 || y > height - 120))
+    if(simulation->getLatestSnapshot().status == Playing && (x < 120 || x > width - 120 || y < 120 || y > height - 120))
     {
         glutWarpPointer(width/2,height/2);
     }
@@ -186,50 +326,313 @@ void cursor(int x, int y)
 // state will be GLUT_UP or GLUT_DOWN
 void mouse(int button, int state, int x, int y)
 {
+    // The cursor and the quit button are handled in display(),
+    // once the game's thread has reacted to the click
     if(state == GLUT_UP)
     {
-        manager.reactToMouseClick(x, y);
-        if(manager.getCurrentStatus() == Playing)
+        simulation->queueInput(GameInput::mouseClick(x, y));
+    }
+    justClicked = true;
+    glutPostRedisplay();
+}
+
+void idle()
+{
+    // The game updates on its own thread, so just draw its newest snapshot
+    glutPostRedisplay();
+}
+
+void quit()
+{
+    simulation->stop();
+    saveTrace();
+    int status = headless ? finishScreenshot() : 0;
+    // Everything on the graphics card has to go while the context is still current
+    chunkUploader.destroy(*manager);
+    if(headless)
+    {
+        offscreen.destroy();
+    }
+    else
+    {
+        glutDestroyWindow(wd);
+    }
+    exit(status);
+}
+
+void saveTrace()
+{
+    if(tracePath == nullptr)
+    {
+        return;
+    }
+    if(writeTrace(tracePath))
+    {
+        printf("Saved the trace to %s\n", tracePath);
+    }
+    else
+    {
+        fprintf(stderr, "Can't write %s\n", tracePath);
+    }
+}
+
+int finishScreenshot()
+{
+    if(screenshotPath == nullptr && referencePath == nullptr)
+    {
+        return 0;
+    }
+    Screenshot image = captureScreenshot(offscreen.getWidth(), offscreen.getHeight());
+    if(screenshotPath != nullptr && !writePPM(screenshotPath, image))
+    {
+        fprintf(stderr, "Can't write %s\n", screenshotPath);
+        return 2;
+    }
+    if(referencePath != nullptr)
+    {
+        Screenshot reference;
+        if(!readPPM(referencePath, reference))
         {
-            // Make the cursor invisible
-            glutSetCursor(GLUT_CURSOR_NONE);
+            fprintf(stderr, "Can't read %s\n", referencePath);
+            return 2;
         }
-        else // Keep arrow when not playing
+        int different = countDifferentPixels(image, reference, screenshotTolerance);
+        if(different < 0)
         {
-            // Make the arrow visible
-            glutSetCursor(GLUT_CURSOR_LEFT_ARROW);
-            // Check for if the quit button was hit
-            if(manager.getCloseWindow())
-            {
-                glutDestroyWindow(wd);
-                exit(0);
-            }
+            printf("The screenshot is %dx%d but %s is %dx%d\n", image.width, image.height, referencePath,
+                   reference.width, reference.height);
+            return 1;
         }
+        printf("%d pixels differ from %s by more than %d\n", different, referencePath, screenshotTolerance);
+        return different > 0 ? 1 : 0;
     }
-    justClicked = true;
-    glutPostRedisplay();
+    return 0;
 }
 
-void timer(int dummy)
+void startGame()
 {
-    glutPostRedisplay();
-    glutTimerFunc(30, timer, dummy);
-    manager.tick();
-    if(manager.getShowMouse()) // If the user hasn't clicked, the cursor won't show
+    manager->setNumChunkThreads(chunkThreads);
+    if(flythroughMode)
     {
-        glutSetCursor(GLUT_CURSOR_LEFT_ARROW);
+        printf("Flying %d ticks in world %d\n", flythrough.getTotalTicks(), manager->getWorldSeed());
+        manager->setCurrentStatus(Playing);
+    }
+    else
+    {
+        simulation->start();
+        replayStart = std::chrono::steady_clock::now();
     }
 }
 
+int runHeadless()
+{
+    if(!offscreen.create((int)width, (int)height))
+    {
+        fprintf(stderr, "Can't make an offscreen OpenGL context (this needs EGL)\n");
+        return 2;
+    }
+    initGL();
+
+    if(flythroughMode || replayMode)
+    {
+        startGame();
+        // Both of these quit when they're done
+        while(true)
+        {
+            if(flythroughMode)
+            {
+                displayFlythrough();
+            }
+            else
+            {
+                display();
+            }
+        }
+    }
+
+    // Otherwise draw the view from the spawn point once every chunk around it
+    // is made and uploaded, which is the same every time for the same seed
+    manager->setNumChunkThreads(chunkThreads);
+    manager->finishChunkJobs();
+    manager->setCurrentStatus(Playing);
+    // The player finds the ground in their second tick, and the camera is
+    // drawn where the player was before the latest one
+    for(int i = 0; i < 3; i++)
+    {
+        manager->update(manager->getTickMilliseconds());
+    }
+    FrameSnapshot snapshot;
+    manager->makeSnapshot(snapshot);
+    chunkUploader.setMaxChunksPerFrame(snapshot.visibleChunks.size() + 1);
+    chunkUploader.setMaxBytesPerFrame(1L << 40);
+    framePacer.beginFrame();
+    drawFrame(snapshot);
+    presentFrame();
+    framePacer.endFrame();
+    quit();
+    return 0;
+}
+
 /* Main function: GLUT runs as a console application starting at main()  */
 int main(int argc, char** argv)
 {
+    // graphics [--single-buffer] [--no-vsync] [--frames-in-flight n]
+    //          [--upload-budget-kb n] [--upload-chunks n] [--chunk-budget-ms n] [--chunk-threads n]
+    //          [--benchmark-flythrough [script]] [--hitch-ms n]
+    //          [--seed n] [--record file] [--replay file [--real-time]]
+    //          [--headless [--screenshot file.ppm] [--compare-screenshot reference.ppm] [--tolerance n]]
+    //          [--trace file.json]
+    int worldSeed = -1;
+    double chunkBudgetMilliseconds = -1;
+    bool chunkThreadsGiven = false;
+    const char *recordPath = nullptr;
+    bool replayRealTime = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            worldSeed = std::max(0, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            if(!replayLog.read(argv[++i]))
+            {
+                fprintf(stderr, "Can't read recording %s\n", argv[i]);
+                return 2;
+            }
+            replayMode = true;
+        }
+        else if(strcmp(argv[i], "--real-time") == 0)
+        {
+            replayRealTime = true;
+        }
+        else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            tracePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+        else if(strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc)
+        {
+            screenshotPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--compare-screenshot") == 0 && i + 1 < argc)
+        {
+            referencePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            screenshotTolerance = std::max(0, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--benchmark-flythrough") == 0)
+        {
+            flythroughMode = true;
+            if(i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+            {
+                if(!flythrough.loadScript(argv[++i]))
+                {
+                    fprintf(stderr, "Can't read flythrough script %s\n", argv[i]);
+                    return 2;
+                }
+            }
+        }
+        else if(strcmp(argv[i], "--hitch-ms") == 0 && i + 1 < argc)
+        {
+            hitchMilliseconds = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--single-buffer") == 0)
+        {
+            doubleBuffered = false;
+        }
+        else if(strcmp(argv[i], "--no-vsync") == 0)
+        {
+            vsync = false;
+        }
+        else if(strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+        {
+            maxFramesInFlight = std::max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--upload-budget-kb") == 0 && i + 1 < argc)
+        {
+            chunkUploader.setMaxBytesPerFrame(1024L * std::max(1, atoi(argv[++i])));
+        }
+        else if(strcmp(argv[i], "--upload-chunks") == 0 && i + 1 < argc)
+        {
+            chunkUploader.setMaxChunksPerFrame(std::max(1, atoi(argv[++i])));
+        }
+        else if(strcmp(argv[i], "--chunk-budget-ms") == 0 && i + 1 < argc)
+        {
+            chunkBudgetMilliseconds = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--chunk-threads") == 0 && i + 1 < argc)
+        {
+            chunkThreads = std::max(0, atoi(argv[++i]));
+            chunkThreadsGiven = true;
+        }
+    }
+
+    if(flythroughMode)
+    {
+        // Draw as fast as possible, so the frame times are the game's own
+        vsync = false;
+        // The chunk times only count the game's thread, so make the chunks there
+        // unless asked not to. Otherwise the workers' time is in no column.
+        if(!chunkThreadsGiven)
+        {
+            chunkThreads = 0;
+        }
+    }
+    if(replayMode || recordPath != nullptr)
+    {
+        // The simulation makes the chunks itself, a fixed number of steps per
+        // update, so don't let workers start on any before it does
+        chunkThreads = 0;
+    }
 
     init();
 
+    if(tracePath != nullptr)
+    {
+        // Start before the manager, so the first chunks are in the trace too
+        setTraceThreadName("main");
+        startTracing();
+    }
+
+    // A replay has to be in the world it was recorded in
+    if(replayMode)
+    {
+        worldSeed = replayLog.getWorldSeed();
+    }
+    manager.reset(new GameManager((int)width, (int)height, 5, 30, worldSeed));
+    if(chunkBudgetMilliseconds >= 0)
+    {
+        manager->setChunkMillisecondsPerUpdate(chunkBudgetMilliseconds);
+    }
+    simulation.reset(new Simulation(*manager));
+    if(replayMode)
+    {
+        simulation->setReplay(replayLog, replayRealTime);
+    }
+    else if(recordPath != nullptr && !simulation->startRecording(recordPath))
+    {
+        fprintf(stderr, "Can't write recording %s\n", recordPath);
+        return 2;
+    }
+
+    if(headless)
+    {
+        return runHeadless();
+    }
+
     glutInit(&argc, argv);          // Initialize GLUT
 
-    glutInitDisplayMode(GLUT_RGBA);
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DEPTH | (doubleBuffered ? GLUT_DOUBLE : GLUT_SINGLE));
 
     glutInitWindowSize((int)width, (int)height);
     glutInitWindowPosition(100, 100); // Position the window's initial top-left corner
@@ -237,7 +640,7 @@ int main(int argc, char** argv)
     wd = glutCreateWindow("Random Terrain" /* title */ );
 
     // Register callback handler for window re-paint event
-    glutDisplayFunc(display);
+    glutDisplayFunc(flythroughMode ? displayFlythrough : display);
 
     // Our own OpenGL initialization
     initGL();
@@ -259,31 +662,13 @@ int main(int argc, char** argv)
     // handles mouse click
     glutMouseFunc(mouse);
 
-    // handles timer
-    glutTimerFunc(0, timer, 0);
+    // handles drawing when there are no other events
+    glutIdleFunc(idle);
+
+    // Start making chunks and running the game on their own threads
+    startGame();
 
     // Enter the event-processing loop
     glutMainLoop();
     return 0;
 }
-
-void drawPoint(Point p)
-{
-    glVertex3f(p.x, p.y, p.z);
-}
-void drawPoint2D(Point p)
-{
-    glVertex2f(p.x, p.y);
-}
-void setGLColor(RGBAcolor color)
-{
-    glColor4f(color.r, color.g, color.b, color.a);
-}
-void cull()
-{
-    glEnable(GL_CULL_FACE);
-}
-void unCull()
-{
-    glDisable(GL_CULL_FACE);
-}
@@ -6,6 +6,8 @@
 
 #include "structs.h"
 
+struct FrameSnapshot;
+
 #include <stdlib.h>
 #ifdef _WIN32
 #include <windows.h>
@@ -31,6 +33,15 @@ void InitGL();
 // Draw the window - this is where all the GL actions are
 void display();
 
+// Draw one frame of the game, without showing it
+void drawFrame(const FrameSnapshot &snapshot);
+
+// Show the frame that was just drawn
+void presentFrame();
+
+// Run one tick of the scripted flythrough and draw it, timing both
+void displayFlythrough();
+
 // Trap and process alphanumeric keyboard events
 void kbd(unsigned char key, int x, int y);
 
@@ -40,17 +51,27 @@ void kbdS(int key, int x, int y);
 // Handle "mouse cursor moved" events
 void cursor(int x, int y);
 
-// Calls itself after a specified time
-void timer(int dummy);
+// Redraws when there are no other events
+void idle();
+
+// Stop the game's thread and close the window
+void quit();
+
+// Write the trace to the file given with --trace, if there is one
+void saveTrace();
+
+// Save or compare the last frame of a headless run, if that was asked for.
+// Returns the exit status.
+int finishScreenshot();
+
+// Start making chunks, and start the game's thread unless the flythrough is running the game
+void startGame();
+
+// Draw into an offscreen buffer instead of a window. Runs the flythrough or the
+// replay if one was asked for, or else draws one frame from the spawn point.
+int runHeadless();
 
 // Handle mouse button pressed and released events
 void mouse(int button, int state, int x, int y);
 
-// Shortcut functions
-void drawPoint(Point p);            // Calls glVertex3f
-void drawPoint2D(Point p);          // Calls glVertex2f on x and y
-void setGLColor(RGBAcolor color);   // Calls glColor4f
-void cull();                        // glEnable(GL_CULL_FACE)
-void unCull();                      // glDisable(GL_CULL_FACE)
-
 #endif /* graphics_h */
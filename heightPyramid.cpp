@@ -0,0 +1,175 @@
+#include "heightPyramid.h"
+#include <cmath>
+
+HeightPyramid::HeightPyramid()
+{
+
+}
+
+void HeightPyramid::build(const SharedRows<Point> &terrainPoints)
+{
+    levels = std::vector<Level>();
+    int squaresPerSide = terrainPoints.size() - 1;
+    if(squaresPerSide < 1)
+    {
+        return;
+    }
+
+    // Each square is bounded by its 4 corners
+    Level base;
+    base.size = squaresPerSide;
+    base.minHeights = SharedRows<double>(squaresPerSide, squaresPerSide);
+    base.maxHeights = SharedRows<double>(squaresPerSide, squaresPerSide);
+    for(int i = 0; i < squaresPerSide; i++)
+    {
+        for(int j = 0; j < squaresPerSide; j++)
+        {
+            double a = terrainPoints[i][j].y, b = terrainPoints[i+1][j].y;
+            double c = terrainPoints[i][j+1].y, d = terrainPoints[i+1][j+1].y;
+            base.minHeights[i][j] = fmin(fmin(a, b), fmin(c, d));
+            base.maxHeights[i][j] = fmax(fmax(a, b), fmax(c, d));
+        }
+    }
+    levels.push_back(base);
+
+    while(levels.back().size > 1)
+    {
+        const Level &below = levels.back();
+        Level above;
+        above.size = (below.size + 1) / 2;
+        above.minHeights = SharedRows<double>(above.size, above.size);
+        above.maxHeights = SharedRows<double>(above.size, above.size);
+        for(int i = 0; i < above.size; i++)
+        {
+            for(int j = 0; j < above.size; j++)
+            {
+                double minHeight = INFINITY, maxHeight = -INFINITY;
+                // The last row and column might only have 1 entry below them
+                for(int bi = 2*i; bi < 2*i + 2 && bi < below.size; bi++)
+                {
+                    for(int bj = 2*j; bj < 2*j + 2 && bj < below.size; bj++)
+                    {
+                        minHeight = fmin(minHeight, below.minHeights[bi][bj]);
+                        maxHeight = fmax(maxHeight, below.maxHeights[bi][bj]);
+                    }
+                }
+                above.minHeights[i][j] = minHeight;
+                above.maxHeights[i][j] = maxHeight;
+            }
+        }
+        levels.push_back(above);
+    }
+}
+void HeightPyramid::update(const SharedRows<Point> &terrainPoints, int iMin, int jMin, int iMax, int jMax)
+{
+    if(levels.empty())
+    {
+        return;
+    }
+    Level &base = levels[0];
+    base.minHeights.ownRows(iMin, iMax);
+    base.maxHeights.ownRows(iMin, iMax);
+    for(int i = iMin; i <= iMax; i++)
+    {
+        for(int j = jMin; j <= jMax; j++)
+        {
+            double a = terrainPoints[i][j].y, b = terrainPoints[i+1][j].y;
+            double c = terrainPoints[i][j+1].y, d = terrainPoints[i+1][j+1].y;
+            base.minHeights[i][j] = fmin(fmin(a, b), fmin(c, d));
+            base.maxHeights[i][j] = fmax(fmax(a, b), fmax(c, d));
+        }
+    }
+    // Each level above only changes over the entries covering the ones that changed
+    for(int level = 1; level < (int)levels.size(); level++)
+    {
+        iMin /= 2;
+        jMin /= 2;
+        iMax /= 2;
+        jMax /= 2;
+        const Level &below = levels[level - 1];
+        Level &above = levels[level];
+        above.minHeights.ownRows(iMin, iMax);
+        above.maxHeights.ownRows(iMin, iMax);
+        for(int i = iMin; i <= iMax; i++)
+        {
+            for(int j = jMin; j <= jMax; j++)
+            {
+                double minHeight = INFINITY, maxHeight = -INFINITY;
+                for(int bi = 2*i; bi < 2*i + 2 && bi < below.size; bi++)
+                {
+                    for(int bj = 2*j; bj < 2*j + 2 && bj < below.size; bj++)
+                    {
+                        minHeight = fmin(minHeight, below.minHeights[bi][bj]);
+                        maxHeight = fmax(maxHeight, below.maxHeights[bi][bj]);
+                    }
+                }
+                above.minHeights[i][j] = minHeight;
+                above.maxHeights[i][j] = maxHeight;
+            }
+        }
+    }
+}
+
+// Getters
+int HeightPyramid::getNumLevels() const
+{
+    return levels.size();
+}
+int HeightPyramid::getLevelSize(int level) const
+{
+    return levels[level].size;
+}
+double HeightPyramid::getMin(int level, int i, int j) const
+{
+    return levels[level].minHeights[i][j];
+}
+double HeightPyramid::getMax(int level, int i, int j) const
+{
+    return levels[level].maxHeights[i][j];
+}
+double HeightPyramid::getMinHeight() const
+{
+    return levels.empty() ? 0 : levels.back().minHeights[0][0];
+}
+double HeightPyramid::getMaxHeight() const
+{
+    return levels.empty() ? 0 : levels.back().maxHeights[0][0];
+}
+
+void HeightPyramid::getRange(int iMin, int jMin, int iMax, int jMax, double &minOut, double &maxOut) const
+{
+    minOut = INFINITY;
+    maxOut = -INFINITY;
+    if(levels.empty())
+    {
+        return;
+    }
+    addRange(levels.size() - 1, 0, 0, iMin, jMin, iMax, jMax, minOut, maxOut);
+}
+
+void HeightPyramid::addRange(int level, int i, int j, int iMin, int jMin, int iMax, int jMax,
+                             double &minOut, double &maxOut) const
+{
+    // The squares covered by this node
+    int span = 1 << level;
+    int nodeIMin = i*span, nodeJMin = j*span;
+    int nodeIMax = nodeIMin + span - 1, nodeJMax = nodeJMin + span - 1;
+    if(nodeIMin > iMax || nodeIMax < iMin || nodeJMin > jMax || nodeJMax < jMin)
+    {
+        return;
+    }
+    if(level == 0 || (nodeIMin >= iMin && nodeIMax <= iMax && nodeJMin >= jMin && nodeJMax <= jMax))
+    {
+        minOut = fmin(minOut, getMin(level, i, j));
+        maxOut = fmax(maxOut, getMax(level, i, j));
+        return;
+    }
+    const Level &below = levels[level - 1];
+    for(int bi = 2*i; bi < 2*i + 2 && bi < below.size; bi++)
+    {
+        for(int bj = 2*j; bj < 2*j + 2 && bj < below.size; bj++)
+        {
+            addRange(level - 1, bi, bj, iMin, jMin, iMax, jMax, minOut, maxOut);
+        }
+    }
+}
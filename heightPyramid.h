@@ -0,0 +1,51 @@
+#ifndef RANDOM_TERRAIN_HEIGHTPYRAMID_H
+#define RANDOM_TERRAIN_HEIGHTPYRAMID_H
+
+// The min and max heights of a chunk's terrain at several resolutions.
+// Level 0 has one entry per terrain square, and each level above it combines
+// 2x2 entries of the level below, up to a single entry for the whole chunk.
+// Queries can then skip whole regions without looking at individual squares.
+
+#include "structs.h"
+#include "sharedRows.h"
+#include <vector>
+
+class HeightPyramid
+{
+private:
+    struct Level
+    {
+        int size; // entries per side
+        // Indexed [i][j]. Copies of the pyramid share the rows an update didn't touch.
+        SharedRows<double> minHeights;
+        SharedRows<double> maxHeights;
+    };
+    std::vector<Level> levels;
+
+    // Combine the node (level, i, j) into minOut and maxOut if it overlaps the square range
+    void addRange(int level, int i, int j, int iMin, int jMin, int iMax, int jMax,
+                  double &minOut, double &maxOut) const;
+public:
+    HeightPyramid();
+
+    // terrainPoints is indexed [i][j] like in Chunk
+    void build(const SharedRows<Point> &terrainPoints);
+    // Redo only the entries over terrain squares iMin to iMax and jMin to jMax
+    // (inclusive), after their heights changed
+    void update(const SharedRows<Point> &terrainPoints, int iMin, int jMin, int iMax, int jMax);
+
+    // Getters
+    int getNumLevels() const;
+    int getLevelSize(int level) const;
+    double getMin(int level, int i, int j) const;
+    double getMax(int level, int i, int j) const;
+    // For the whole chunk
+    double getMinHeight() const;
+    double getMaxHeight() const;
+
+    // The min and max over terrain squares iMin to iMax and jMin to jMax (inclusive),
+    // using the coarsest levels possible
+    void getRange(int iMin, int jMin, int iMax, int jMax, double &minOut, double &maxOut) const;
+};
+
+#endif //RANDOM_TERRAIN_HEIGHTPYRAMID_H
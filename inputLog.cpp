@@ -0,0 +1,255 @@
+#include "inputLog.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const static char MAGIC[4] = {'R', 'T', 'I', 'L'};
+const static uint32_t VERSION = 2; // 1 had no terrain edits, and still reads
+
+GameInput GameInput::update(double milliseconds)
+{
+    GameInput input = {UpdateInput, WKey, false, 0, 0, 0, 0, 0, Raise};
+    input.microseconds = (uint32_t)std::max(0.0, round(milliseconds*1000));
+    return input;
+}
+GameInput GameInput::keyChange(GameInputKey key, bool pressed)
+{
+    GameInput input = {KeyInput, key, pressed, 0, 0, 0, 0, 0, Raise};
+    return input;
+}
+GameInput GameInput::mouseMove(int x, int y, double theta, double distance)
+{
+    GameInput input = {MouseMoveInput, WKey, false, (int16_t)x, (int16_t)y, (float)theta, (float)distance, 0, Raise};
+    return input;
+}
+GameInput GameInput::mouseClick(int x, int y)
+{
+    GameInput input = {MouseClickInput, WKey, false, (int16_t)x, (int16_t)y, 0, 0, 0, Raise};
+    return input;
+}
+GameInput GameInput::pause()
+{
+    GameInput input = {PauseInput, WKey, false, 0, 0, 0, 0, 0, Raise};
+    return input;
+}
+GameInput GameInput::deform(BrushMode mode)
+{
+    GameInput input = {DeformInput, WKey, false, 0, 0, 0, 0, 0, mode};
+    return input;
+}
+
+double GameInput::getMilliseconds() const
+{
+    return microseconds / 1000.0;
+}
+
+void GameInput::apply(GameManager &manager) const
+{
+    switch(type)
+    {
+        case UpdateInput:
+            break;
+        case KeyInput:
+            switch(key)
+            {
+                case WKey: manager.setWKey(pressed);
+                    break;
+                case AKey: manager.setAKey(pressed);
+                    break;
+                case SKey: manager.setSKey(pressed);
+                    break;
+                case DKey: manager.setDKey(pressed);
+                    break;
+                case SpacebarKey: manager.setSpacebar(pressed);
+                    break;
+                case HyperSpeedKey: manager.setHyperSpeed(pressed);
+                    break;
+            }
+            break;
+        case MouseMoveInput:
+            manager.reactToMouseMovement(x, y, theta, distance);
+            break;
+        case MouseClickInput:
+            manager.reactToMouseClick(x, y);
+            break;
+        case PauseInput:
+            if(manager.getCurrentStatus() != Paused)
+            {
+                manager.togglePaused();
+            }
+            break;
+        case DeformInput:
+            manager.deformTerrainAhead(brushMode);
+            break;
+    }
+}
+
+// Little-endian, whatever the machine is
+static void writeBytes(std::ofstream &out, uint32_t value, int numBytes)
+{
+    char bytes[4];
+    for(int i = 0; i < numBytes; i++)
+    {
+        bytes[i] = (char)((value >> (8*i)) & 0xff);
+    }
+    out.write(bytes, numBytes);
+}
+static bool readBytes(std::ifstream &in, uint32_t &value, int numBytes)
+{
+    unsigned char bytes[4];
+    if(!in.read((char*)bytes, numBytes))
+    {
+        return false;
+    }
+    value = 0;
+    for(int i = 0; i < numBytes; i++)
+    {
+        value |= (uint32_t)bytes[i] << (8*i);
+    }
+    return true;
+}
+static uint32_t floatBits(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+static float bitsFloat(uint32_t bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+bool InputRecorder::open(const std::string &path, int worldSeed)
+{
+    out.open(path, std::ios::binary | std::ios::trunc);
+    out.write(MAGIC, 4);
+    writeBytes(out, VERSION, 4);
+    writeBytes(out, (uint32_t)worldSeed, 4);
+    return (bool)out;
+}
+bool InputRecorder::isOpen() const
+{
+    return out.is_open();
+}
+void InputRecorder::record(const GameInput &input)
+{
+    out.put((char)input.type);
+    switch(input.type)
+    {
+        case UpdateInput:
+            writeBytes(out, input.microseconds, 4);
+            break;
+        case KeyInput:
+            out.put((char)input.key);
+            out.put(input.pressed ? 1 : 0);
+            break;
+        case MouseMoveInput:
+            writeBytes(out, (uint16_t)input.x, 2);
+            writeBytes(out, (uint16_t)input.y, 2);
+            writeBytes(out, floatBits(input.theta), 4);
+            writeBytes(out, floatBits(input.distance), 4);
+            break;
+        case MouseClickInput:
+            writeBytes(out, (uint16_t)input.x, 2);
+            writeBytes(out, (uint16_t)input.y, 2);
+            break;
+        case PauseInput:
+            break;
+        case DeformInput:
+            out.put((char)input.brushMode);
+            break;
+    }
+}
+void InputRecorder::close()
+{
+    if(out.is_open())
+    {
+        out.close();
+    }
+}
+
+InputLog::InputLog()
+{
+    worldSeed = 0;
+}
+
+bool InputLog::read(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t version, seed;
+    if(!in.read(magic, 4) || memcmp(magic, MAGIC, 4) != 0 || !readBytes(in, version, 4) || version < 1 || version > VERSION ||
+       !readBytes(in, seed, 4))
+    {
+        return false;
+    }
+    worldSeed = (int)seed;
+    inputs.clear();
+    int type;
+    while((type = in.get()) != EOF)
+    {
+        GameInput input = GameInput::pause();
+        uint32_t a = 0, b = 0, c = 0, d = 0;
+        bool ok = true;
+        switch(type)
+        {
+            case UpdateInput:
+                ok = readBytes(in, a, 4);
+                input = GameInput::update(0);
+                input.microseconds = a;
+                break;
+            case KeyInput:
+                ok = readBytes(in, a, 1) && readBytes(in, b, 1) && a <= HyperSpeedKey;
+                input = GameInput::keyChange((GameInputKey)a, b != 0);
+                break;
+            case MouseMoveInput:
+                ok = readBytes(in, a, 2) && readBytes(in, b, 2) && readBytes(in, c, 4) && readBytes(in, d, 4);
+                input = GameInput::mouseMove((int16_t)a, (int16_t)b, 0, 0);
+                input.theta = bitsFloat(c);
+                input.distance = bitsFloat(d);
+                break;
+            case MouseClickInput:
+                ok = readBytes(in, a, 2) && readBytes(in, b, 2);
+                input = GameInput::mouseClick((int16_t)a, (int16_t)b);
+                break;
+            case PauseInput:
+                break;
+            case DeformInput:
+                ok = readBytes(in, a, 1) && a <= Flatten;
+                input = GameInput::deform((BrushMode)a);
+                break;
+            default:
+                ok = false;
+        }
+        if(!ok)
+        {
+            // A session that was killed can end partway through a record
+            return in.eof();
+        }
+        inputs.push_back(input);
+    }
+    return true;
+}
+
+int InputLog::getWorldSeed() const
+{
+    return worldSeed;
+}
+const std::vector<GameInput> &InputLog::getInputs() const
+{
+    return inputs;
+}
+double InputLog::getMilliseconds() const
+{
+    double total = 0;
+    for(const GameInput &input : inputs)
+    {
+        if(input.type == UpdateInput)
+        {
+            total += input.getMilliseconds();
+        }
+    }
+    return total;
+}
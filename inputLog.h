@@ -0,0 +1,81 @@
+#ifndef RANDOM_TERRAIN_INPUTLOG_H
+#define RANDOM_TERRAIN_INPUTLOG_H
+
+// Records a session so it can be played back exactly. A log holds the world
+// seed and everything the game's thread did to the GameManager, in order: the
+// inputs it applied and the time passed to each update.
+//
+// The file is a header ("RTIL", the version and the world seed) followed by
+// one record per input, each a type byte and a few little-endian fields:
+//   update       uint32 microseconds since the last update
+//   key          uint8 key, uint8 pressed
+//   mouse move   int16 x, int16 y, float32 theta, float32 distance
+//   mouse click  int16 x, int16 y
+//   pause        nothing
+//   deform       uint8 brush mode (version 2 and up)
+// Values are rounded to what the file can hold before they reach the game,
+// so a replay gets exactly what the recorded session got.
+
+#include "gameManager.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum GameInputType : uint8_t {UpdateInput, KeyInput, MouseMoveInput, MouseClickInput, PauseInput, DeformInput};
+enum GameInputKey : uint8_t {WKey, AKey, SKey, DKey, SpacebarKey, HyperSpeedKey};
+
+struct GameInput
+{
+    GameInputType type;
+    GameInputKey key;
+    bool pressed;
+    int x, y;
+    float theta, distance;
+    uint32_t microseconds; // only for updates
+    BrushMode brushMode;   // only for terrain edits
+
+    static GameInput update(double milliseconds);
+    static GameInput keyChange(GameInputKey key, bool pressed);
+    static GameInput mouseMove(int x, int y, double theta, double distance);
+    static GameInput mouseClick(int x, int y);
+    static GameInput pause();
+    // Edit the terrain in front of the player
+    static GameInput deform(BrushMode mode);
+
+    double getMilliseconds() const;
+    // Updates are run by whoever is driving the game, not applied here
+    void apply(GameManager &manager) const;
+};
+
+class InputRecorder
+{
+private:
+    std::ofstream out;
+public:
+    // Returns false if the file can't be written
+    bool open(const std::string &path, int worldSeed);
+    bool isOpen() const;
+    void record(const GameInput &input);
+    void close();
+};
+
+class InputLog
+{
+private:
+    int worldSeed;
+    std::vector<GameInput> inputs;
+public:
+    InputLog();
+
+    // Returns false if the file can't be read or isn't a log. A record cut
+    // off at the end is left out.
+    bool read(const std::string &path);
+
+    int getWorldSeed() const;
+    const std::vector<GameInput> &getInputs() const;
+    // The time the recorded session took, from its updates
+    double getMilliseconds() const;
+};
+
+#endif //RANDOM_TERRAIN_INPUTLOG_H
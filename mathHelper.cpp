@@ -1,5 +1,9 @@
 #include "mathHelper.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 int nearestPerfectSquare(int n)
 {
     int squareJumpAmount = 3;
@@ -236,3 +240,98 @@ Point getRotatedPointAroundPoint(const Point &p, const Point &pBase, double thet
     rotatePointAroundPoint(result, pBase, thetaX, thetaY, thetaZ);
     return result;
 }
+
+RotationMatrix makeRotationMatrix(double thetaX, double thetaY, double thetaZ)
+{
+    // Same rotations as rotatePointAroundPoint(), in the same order
+    double cx = cos(thetaX), sx = sin(thetaX);
+    double cy = cos(thetaY), sy = sin(thetaY);
+    double cz = cos(thetaZ), sz = sin(thetaZ);
+    const double rx[3][3] = {{1, 0, 0}, {0, cx, -sx}, {0, sx, cx}};
+    const double ry[3][3] = {{cy, 0, -sy}, {0, 1, 0}, {sy, 0, cy}};
+    const double rz[3][3] = {{cz, -sz, 0}, {sz, cz, 0}, {0, 0, 1}};
+
+    // result = rz * ry * rx
+    double ryx[3][3];
+    RotationMatrix result;
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            ryx[i][j] = ry[i][0]*rx[0][j] + ry[i][1]*rx[1][j] + ry[i][2]*rx[2][j];
+        }
+    }
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            result.m[i][j] = rz[i][0]*ryx[0][j] + rz[i][1]*ryx[1][j] + rz[i][2]*ryx[2][j];
+        }
+    }
+    return result;
+}
+
+void rotatePointAroundPoint(Point &p, const Point &pBase, const RotationMatrix &rotation)
+{
+    const double (&m)[3][3] = rotation.m;
+    double x = p.x - pBase.x;
+    double y = p.y - pBase.y;
+    double z = p.z - pBase.z;
+    p.x = m[0][0]*x + m[0][1]*y + m[0][2]*z + pBase.x;
+    p.y = m[1][0]*x + m[1][1]*y + m[1][2]*z + pBase.y;
+    p.z = m[2][0]*x + m[2][1]*y + m[2][2]*z + pBase.z;
+}
+
+void movePoints(double *xs, double *ys, double *zs, int count, double deltaX, double deltaY, double deltaZ)
+{
+    int i = 0;
+#ifdef __SSE2__
+    __m128d dx = _mm_set1_pd(deltaX), dy = _mm_set1_pd(deltaY), dz = _mm_set1_pd(deltaZ);
+    for(; i + 2 <= count; i += 2)
+    {
+        _mm_storeu_pd(xs + i, _mm_add_pd(_mm_loadu_pd(xs + i), dx));
+        _mm_storeu_pd(ys + i, _mm_add_pd(_mm_loadu_pd(ys + i), dy));
+        _mm_storeu_pd(zs + i, _mm_add_pd(_mm_loadu_pd(zs + i), dz));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        xs[i] += deltaX;
+        ys[i] += deltaY;
+        zs[i] += deltaZ;
+    }
+}
+
+void rotatePointsAroundPoint(double *xs, double *ys, double *zs, int count,
+                             const Point &pBase, const RotationMatrix &rotation)
+{
+    const double (&m)[3][3] = rotation.m;
+    int i = 0;
+#ifdef __SSE2__
+    __m128d bx = _mm_set1_pd(pBase.x), by = _mm_set1_pd(pBase.y), bz = _mm_set1_pd(pBase.z);
+    __m128d m00 = _mm_set1_pd(m[0][0]), m01 = _mm_set1_pd(m[0][1]), m02 = _mm_set1_pd(m[0][2]);
+    __m128d m10 = _mm_set1_pd(m[1][0]), m11 = _mm_set1_pd(m[1][1]), m12 = _mm_set1_pd(m[1][2]);
+    __m128d m20 = _mm_set1_pd(m[2][0]), m21 = _mm_set1_pd(m[2][1]), m22 = _mm_set1_pd(m[2][2]);
+    for(; i + 2 <= count; i += 2)
+    {
+        __m128d x = _mm_sub_pd(_mm_loadu_pd(xs + i), bx);
+        __m128d y = _mm_sub_pd(_mm_loadu_pd(ys + i), by);
+        __m128d z = _mm_sub_pd(_mm_loadu_pd(zs + i), bz);
+        __m128d newX = _mm_add_pd(_mm_add_pd(_mm_mul_pd(m00, x), _mm_mul_pd(m01, y)), _mm_mul_pd(m02, z));
+        __m128d newY = _mm_add_pd(_mm_add_pd(_mm_mul_pd(m10, x), _mm_mul_pd(m11, y)), _mm_mul_pd(m12, z));
+        __m128d newZ = _mm_add_pd(_mm_add_pd(_mm_mul_pd(m20, x), _mm_mul_pd(m21, y)), _mm_mul_pd(m22, z));
+        _mm_storeu_pd(xs + i, _mm_add_pd(newX, bx));
+        _mm_storeu_pd(ys + i, _mm_add_pd(newY, by));
+        _mm_storeu_pd(zs + i, _mm_add_pd(newZ, bz));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        double x = xs[i] - pBase.x;
+        double y = ys[i] - pBase.y;
+        double z = zs[i] - pBase.z;
+        xs[i] = m[0][0]*x + m[0][1]*y + m[0][2]*z + pBase.x;
+        ys[i] = m[1][0]*x + m[1][1]*y + m[1][2]*z + pBase.y;
+        zs[i] = m[2][0]*x + m[2][1]*y + m[2][2]*z + pBase.z;
+    }
+}
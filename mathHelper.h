@@ -51,9 +51,24 @@ int getChunkIDContainingPoint(Point p, int chunkSize);
 double dotProduct(Point p1, Point p2);
 Point crossProduct(Point p1, Point p2);
 
+// Rotating around the x-axis, then the y-axis, then the z-axis, as one matrix.
+// Making it once lets many points be rotated without recomputing cos and sin.
+struct RotationMatrix
+{
+    double m[3][3];
+};
+RotationMatrix makeRotationMatrix(double thetaX, double thetaY, double thetaZ);
+
 // Point operations
 void movePoint(Point &p, double deltaX, double deltaY, double deltaZ);
 void rotatePointAroundPoint(Point &p, const Point &pBase, double thetaX, double thetaY, double thetaZ);
+void rotatePointAroundPoint(Point &p, const Point &pBase, const RotationMatrix &rotation);
 Point getRotatedPointAroundPoint(const Point &p, const Point &pBase, double thetaX, double thetaY, double thetaZ);
 
+// The same operations on count points stored as separate x, y, and z arrays.
+// These use SIMD when it's available.
+void movePoints(double *xs, double *ys, double *zs, int count, double deltaX, double deltaY, double deltaZ);
+void rotatePointsAroundPoint(double *xs, double *ys, double *zs, int count,
+                             const Point &pBase, const RotationMatrix &rotation);
+
 #endif //RANDOM_TERRAIN_MATHHELPER_H
@@ -0,0 +1,148 @@
+#include "offscreenContext.h"
+#include "glFunctions.h"
+#include <cstring>
+
+#ifdef RANDOM_TERRAIN_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static void *lookUpWithEGL(const char *name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+// Mesa's surfaceless platform needs no display server. Other EGLs get the default display.
+static EGLDisplay getOffscreenDisplay()
+{
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if(extensions != nullptr && strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr)
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if(getPlatformDisplay != nullptr)
+        {
+            EGLDisplay d = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if(d != EGL_NO_DISPLAY)
+            {
+                return d;
+            }
+        }
+    }
+#endif
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif
+
+OffscreenContext::OffscreenContext()
+{
+    display = nullptr;
+    surface = nullptr;
+    context = nullptr;
+    width = 0;
+    height = 0;
+}
+OffscreenContext::~OffscreenContext()
+{
+    destroy();
+}
+
+bool OffscreenContext::create(int inputWidth, int inputHeight)
+{
+#ifdef RANDOM_TERRAIN_HAS_EGL
+    destroy();
+    EGLDisplay d = getOffscreenDisplay();
+    if(d == EGL_NO_DISPLAY || !eglInitialize(d, nullptr, nullptr))
+    {
+        return false;
+    }
+    display = d;
+
+    const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                       EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                       EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+                                       EGL_DEPTH_SIZE, 24,
+                                       EGL_NONE};
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if(!eglChooseConfig(d, configAttributes, &config, 1, &numConfigs) || numConfigs == 0 ||
+       !eglBindAPI(EGL_OPENGL_API))
+    {
+        destroy();
+        return false;
+    }
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, inputWidth, EGL_HEIGHT, inputHeight, EGL_NONE};
+    EGLSurface s = eglCreatePbufferSurface(d, config, surfaceAttributes);
+    if(s == EGL_NO_SURFACE)
+    {
+        destroy();
+        return false;
+    }
+    surface = s;
+    EGLContext c = eglCreateContext(d, config, EGL_NO_CONTEXT, nullptr);
+    if(c == EGL_NO_CONTEXT)
+    {
+        destroy();
+        return false;
+    }
+    context = c;
+    if(!eglMakeCurrent(d, s, s, c))
+    {
+        destroy();
+        return false;
+    }
+    width = inputWidth;
+    height = inputHeight;
+    loadGLFunctions(lookUpWithEGL);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OffscreenContext::destroy()
+{
+#ifdef RANDOM_TERRAIN_HAS_EGL
+    if(display == nullptr)
+    {
+        return;
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(context != nullptr)
+    {
+        eglDestroyContext(display, context);
+    }
+    if(surface != nullptr)
+    {
+        eglDestroySurface(display, surface);
+    }
+    eglTerminate(display);
+    display = nullptr;
+    surface = nullptr;
+    context = nullptr;
+#endif
+}
+
+bool OffscreenContext::isCreated() const
+{
+    return context != nullptr;
+}
+
+void OffscreenContext::swapBuffers()
+{
+#ifdef RANDOM_TERRAIN_HAS_EGL
+    if(display != nullptr)
+    {
+        eglSwapBuffers(display, surface);
+    }
+#endif
+}
+
+int OffscreenContext::getWidth() const
+{
+    return width;
+}
+int OffscreenContext::getHeight() const
+{
+    return height;
+}
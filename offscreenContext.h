@@ -0,0 +1,40 @@
+#ifndef RANDOM_TERRAIN_OFFSCREENCONTEXT_H
+#define RANDOM_TERRAIN_OFFSCREENCONTEXT_H
+
+// An OpenGL context that draws into a buffer instead of a window, for machines
+// with no display or graphics card. It uses EGL, which Mesa provides with its
+// software rasterizer when there is no GPU. Without EGL at build time, create()
+// always fails.
+
+#include <string>
+
+class OffscreenContext
+{
+private:
+    // The EGL handles, kept as void* so this header doesn't need EGL
+    void *display;
+    void *surface;
+    void *context;
+    int width, height;
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    // The context belongs to one object
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Make the context and its buffer, make it current on this thread, and load
+    // the GL functions. Returns false if that can't be done here.
+    bool create(int inputWidth, int inputHeight);
+    void destroy();
+    bool isCreated() const;
+
+    // Finish the frame. The buffer keeps what was drawn until the next one.
+    void swapBuffers();
+
+    int getWidth() const;
+    int getHeight() const;
+};
+
+#endif //RANDOM_TERRAIN_OFFSCREENCONTEXT_H
@@ -0,0 +1,475 @@
+#include "pathfinder.h"
+#include <queue>
+#include <map>
+#include <functional>
+#include <algorithm>
+
+Pathfinder::Pathfinder()
+{
+    chunkSize = 512;
+}
+Pathfinder::Pathfinder(int inputChunkSize)
+{
+    chunkSize = inputChunkSize;
+}
+
+int Pathfinder::getNeighborID(int chunkID, Side side)
+{
+    switch(side)
+    {
+        case Left: return getChunkIDLeft(chunkID);
+        case Right: return getChunkIDRight(chunkID);
+        case Above: return getChunkIDAbove(chunkID);
+        default: return getChunkIDBelow(chunkID);
+    }
+}
+Pathfinder::Side Pathfinder::getOppositeSide(Side side)
+{
+    switch(side)
+    {
+        case Left: return Right;
+        case Right: return Left;
+        case Above: return Below;
+        default: return Above;
+    }
+}
+int Pathfinder::getBorderCell(int cellsPerSide, Side side, int along)
+{
+    // i goes with x and j goes with z
+    switch(side)
+    {
+        case Left: return along;
+        case Right: return (cellsPerSide - 1)*cellsPerSide + along;
+        case Above: return along*cellsPerSide;
+        default: return along*cellsPerSide + cellsPerSide - 1;
+    }
+}
+
+// =================================
+//
+//          Cached Levels
+//
+// =================================
+
+const Pathfinder::CostGrid &Pathfinder::getCostGrid(const std::shared_ptr<Chunk> &c)
+{
+    int chunkID = c->getChunkID();
+    auto it = costGrids.find(chunkID);
+    if(it != costGrids.end() && it->second.version == c->getVersion())
+    {
+        return it->second;
+    }
+
+    // The normals and water are made lazily
+    c->ensureRenderReady();
+    std::shared_ptr<const ChunkVersion> v = c->getCurrentVersion();
+    const SharedRows<Point> &upperNormals = v->physics->upperNormals;
+    const SharedRows<Point> &lowerNormals = v->physics->lowerNormals;
+    const SharedRows<bool> &drawWaterAt = v->surface->drawWaterAt;
+
+    CostGrid &grid = costGrids[chunkID];
+    grid.version = v->version;
+    grid.cellsPerSide = c->getPointsPerSide() - 1;
+    grid.squareSize = c->getSideLength() / (double)grid.cellsPerSide;
+    grid.originX = v->heights->terrainPoints[0][0].x;
+    grid.originZ = v->heights->terrainPoints[0][0].z;
+    grid.cost = std::vector<double>(grid.cellsPerSide*grid.cellsPerSide);
+    for(int i = 0; i < grid.cellsPerSide; i++)
+    {
+        for(int j = 0; j < grid.cellsPerSide; j++)
+        {
+            Point upper = upperNormals[i][j], lower = lowerNormals[i][j];
+            // The flatter of the two triangles doesn't matter if the other is a cliff
+            double normalY = std::min(fabs(upper.y) / sqrt(dotProduct(upper, upper)),
+                                      fabs(lower.y) / sqrt(dotProduct(lower, lower)));
+            if(drawWaterAt[i][j] || !(normalY >= MIN_NORMAL_Y))
+            {
+                grid.cost[i*grid.cellsPerSide + j] = -1;
+            }
+            else
+            {
+                double steepness = (1 - normalY) / (1 - MIN_NORMAL_Y);
+                grid.cost[i*grid.cellsPerSide + j] = 1 + SLOPE_PENALTY*steepness;
+            }
+        }
+    }
+    return grid;
+}
+
+const Pathfinder::ChunkGraph &Pathfinder::getChunkGraph(const ChunkCache &chunks, int chunkID)
+{
+    std::shared_ptr<Chunk> c = chunks.find(chunkID);
+    int neighborVersions[NUM_SIDES];
+    for(int s = 0; s < NUM_SIDES; s++)
+    {
+        std::shared_ptr<Chunk> neighbor = chunks.find(getNeighborID(chunkID, (Side)s));
+        neighborVersions[s] = neighbor ? neighbor->getVersion() : -1;
+    }
+    auto it = chunkGraphs.find(chunkID);
+    if(it != chunkGraphs.end() && it->second.version == c->getVersion() &&
+       std::equal(neighborVersions, neighborVersions + NUM_SIDES, it->second.neighborVersions))
+    {
+        return it->second;
+    }
+
+    const CostGrid &grid = getCostGrid(c);
+    int n = grid.cellsPerSide;
+    ChunkGraph graph;
+    graph.version = c->getVersion();
+    std::copy(neighborVersions, neighborVersions + NUM_SIDES, graph.neighborVersions);
+
+    // Each stretch of border squares that can be walked on from both sides gets
+    // one portal in its middle. The neighbor makes the same stretches from its
+    // side, so the portals line up.
+    for(int s = 0; s < NUM_SIDES; s++)
+    {
+        if(neighborVersions[s] == -1)
+        {
+            continue;
+        }
+        Side side = (Side)s;
+        const CostGrid &neighborGrid = getCostGrid(chunks.find(getNeighborID(chunkID, side)));
+        int runStart = -1;
+        for(int along = 0; along <= n; along++)
+        {
+            bool open = along < n && grid.cost[getBorderCell(n, side, along)] >= 0 &&
+                        neighborGrid.cost[getBorderCell(n, getOppositeSide(side), along)] >= 0;
+            if(open && runStart == -1)
+            {
+                runStart = along;
+            }
+            else if(!open && runStart != -1)
+            {
+                graph.portals.push_back({side, getBorderCell(n, side, (runStart + along - 1) / 2)});
+                runStart = -1;
+            }
+        }
+    }
+
+    int numPortals = graph.portals.size();
+    graph.distances = std::vector<double>(numPortals*numPortals, INFINITY);
+    std::vector<double> distances;
+    std::vector<int> parents;
+    for(int p = 0; p < numPortals; p++)
+    {
+        searchGrid(grid, graph.portals[p].cell, -1, distances, parents);
+        for(int q = 0; q < numPortals; q++)
+        {
+            graph.distances[p*numPortals + q] = distances[graph.portals[q].cell];
+        }
+    }
+    return chunkGraphs[chunkID] = graph;
+}
+
+int Pathfinder::findPortal(const ChunkGraph &graph, Side side, int cell, int cellsPerSide)
+{
+    // The cell right across the border from the given one
+    int i = cell / cellsPerSide, j = cell % cellsPerSide;
+    int along = (side == Left || side == Right) ? j : i;
+    int acrossCell = getBorderCell(cellsPerSide, getOppositeSide(side), along);
+    for(int p = 0; p < (int)graph.portals.size(); p++)
+    {
+        if(graph.portals[p].side == getOppositeSide(side) && graph.portals[p].cell == acrossCell)
+        {
+            return p;
+        }
+    }
+    return -1;
+}
+
+void Pathfinder::invalidateChunk(int chunkID)
+{
+    costGrids.erase(chunkID);
+    chunkGraphs.erase(chunkID);
+    for(int s = 0; s < NUM_SIDES; s++)
+    {
+        chunkGraphs.erase(getNeighborID(chunkID, (Side)s));
+    }
+}
+
+// =================================
+//
+//         Searching a Chunk
+//
+// =================================
+
+void Pathfinder::searchGrid(const CostGrid &grid, int startCell, int targetCell,
+                            std::vector<double> &distances, std::vector<int> &parents)
+{
+    int n = grid.cellsPerSide;
+    distances.assign(n*n, INFINITY);
+    parents.assign(n*n, -1);
+    if(grid.cost[startCell] < 0)
+    {
+        return;
+    }
+    int targetI = targetCell / n, targetJ = targetCell % n;
+    auto heuristic = [&](int cell)
+    {
+        if(targetCell == -1)
+        {
+            return 0.0;
+        }
+        // Every square costs at least 1 per unit of distance
+        return distanceFormula(cell / n, cell % n, targetI, targetJ) * grid.squareSize;
+    };
+
+    typedef std::pair<double, int> Entry; // (distance + heuristic, cell)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    distances[startCell] = 0;
+    open.push({heuristic(startCell), startCell});
+    while(!open.empty())
+    {
+        Entry e = open.top();
+        open.pop();
+        int cell = e.second;
+        if(e.first > distances[cell] + heuristic(cell))
+        {
+            continue; // already found a better way here
+        }
+        if(cell == targetCell)
+        {
+            return;
+        }
+        int i = cell / n, j = cell % n;
+        for(int di = -1; di <= 1; di++)
+        {
+            for(int dj = -1; dj <= 1; dj++)
+            {
+                int ni = i + di, nj = j + dj;
+                if((di == 0 && dj == 0) || ni < 0 || nj < 0 || ni >= n || nj >= n)
+                {
+                    continue;
+                }
+                int next = ni*n + nj;
+                // Don't cut the corner of a square that can't be walked on
+                if(grid.cost[next] < 0 || grid.cost[i*n + nj] < 0 || grid.cost[ni*n + j] < 0)
+                {
+                    continue;
+                }
+                double stepLength = (di != 0 && dj != 0) ? sqrt(2) * grid.squareSize : grid.squareSize;
+                double newDistance = distances[cell] + stepLength * (grid.cost[cell] + grid.cost[next]) / 2;
+                if(newDistance < distances[next])
+                {
+                    distances[next] = newDistance;
+                    parents[next] = cell;
+                    open.push({newDistance + heuristic(next), next});
+                }
+            }
+        }
+    }
+}
+
+std::vector<int> Pathfinder::findCellPath(const CostGrid &grid, int startCell, int targetCell)
+{
+    std::vector<double> distances;
+    std::vector<int> parents;
+    searchGrid(grid, startCell, targetCell, distances, parents);
+    std::vector<int> cells;
+    if(distances[targetCell] == INFINITY)
+    {
+        return cells;
+    }
+    for(int cell = targetCell; cell != -1; cell = parents[cell])
+    {
+        cells.push_back(cell);
+    }
+    std::reverse(cells.begin(), cells.end());
+    return cells;
+}
+
+int Pathfinder::getCellContaining(const CostGrid &grid, Point p) const
+{
+    int n = grid.cellsPerSide;
+    int i = std::max(0, std::min(n - 1, (int)floor((p.x - grid.originX) / grid.squareSize)));
+    int j = std::max(0, std::min(n - 1, (int)floor((p.z - grid.originZ) / grid.squareSize)));
+    return i*n + j;
+}
+int Pathfinder::getNearestOpenCell(const CostGrid &grid, int cell)
+{
+    int n = grid.cellsPerSide;
+    int i = cell / n, j = cell % n;
+    int nearest = -1;
+    double nearestDistance = INFINITY;
+    for(int other = 0; other < n*n; other++)
+    {
+        double distance = distanceFormula(i, j, other / n, other % n);
+        if(grid.cost[other] >= 0 && distance < nearestDistance)
+        {
+            nearest = other;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+Point Pathfinder::getCellCenter(const CostGrid &grid, int cell)
+{
+    int i = cell / grid.cellsPerSide, j = cell % grid.cellsPerSide;
+    return {grid.originX + (i + 0.5)*grid.squareSize, 0, grid.originZ + (j + 0.5)*grid.squareSize};
+}
+
+// =================================
+//
+//          Finding Paths
+//
+// =================================
+
+std::vector<Point> Pathfinder::findPath(const ChunkCache &chunks, Point start, Point goal)
+{
+    std::vector<Point> path;
+    int startChunkID = getChunkIDContainingPoint(start, chunkSize);
+    int goalChunkID = getChunkIDContainingPoint(goal, chunkSize);
+    if(!chunks.contains(startChunkID) || !chunks.contains(goalChunkID))
+    {
+        return path;
+    }
+    const CostGrid &startGrid = getCostGrid(chunks.find(startChunkID));
+    const CostGrid &goalGrid = getCostGrid(chunks.find(goalChunkID));
+    // Someone standing on a steep square can still walk off of it
+    int startCell = getNearestOpenCell(startGrid, getCellContaining(startGrid, start));
+    int goalCell = getNearestOpenCell(goalGrid, getCellContaining(goalGrid, goal));
+    if(startCell == -1 || goalCell == -1)
+    {
+        return path;
+    }
+
+    // Each step of the path is a (chunkID, cell) pair
+    std::vector<std::pair<int, int>> steps;
+    std::vector<int> cells;
+    if(startChunkID == goalChunkID)
+    {
+        cells = findCellPath(startGrid, startCell, goalCell);
+    }
+    if(!cells.empty())
+    {
+        for(int cell : cells)
+        {
+            steps.push_back({startChunkID, cell});
+        }
+    }
+    else
+    {
+        // Search the portal graph. The start connects to the portals of its chunk,
+        // and the portals of the goal's chunk connect to the goal.
+        std::vector<double> fromStart, toGoal;
+        std::vector<int> parents;
+        searchGrid(startGrid, startCell, -1, fromStart, parents);
+        searchGrid(goalGrid, goalCell, -1, toGoal, parents);
+
+        typedef std::pair<int, int> Node; // (chunkID, portal index)
+        const Node GOAL = {goalChunkID, -1};
+        std::map<Node, double> distances;
+        std::map<Node, Node> nodeParents;
+        auto heuristic = [&](const Node &node)
+        {
+            if(node == GOAL)
+            {
+                return 0.0;
+            }
+            const ChunkGraph &graph = chunkGraphs.at(node.first);
+            Point p = getCellCenter(costGrids.at(node.first), graph.portals[node.second].cell);
+            return distance2d(p, goal);
+        };
+        typedef std::pair<double, Node> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        auto relax = [&](const Node &from, const Node &to, double distance)
+        {
+            auto it = distances.find(to);
+            if(distance == INFINITY || (it != distances.end() && it->second <= distance))
+            {
+                return;
+            }
+            distances[to] = distance;
+            nodeParents[to] = from;
+            open.push({distance + heuristic(to), to});
+        };
+
+        const ChunkGraph &startGraph = getChunkGraph(chunks, startChunkID);
+        for(int p = 0; p < (int)startGraph.portals.size(); p++)
+        {
+            relax({startChunkID, -2}, {startChunkID, p}, fromStart[startGraph.portals[p].cell]);
+        }
+        while(!open.empty())
+        {
+            Entry e = open.top();
+            open.pop();
+            Node node = e.second;
+            if(e.first > distances[node] + heuristic(node))
+            {
+                continue;
+            }
+            if(node == GOAL)
+            {
+                break;
+            }
+            int chunkID = node.first;
+            const ChunkGraph &graph = getChunkGraph(chunks, chunkID);
+            int numPortals = graph.portals.size();
+            double distance = distances[node];
+            for(int q = 0; q < numPortals; q++)
+            {
+                relax(node, {chunkID, q}, distance + graph.distances[node.second*numPortals + q]);
+            }
+            if(chunkID == goalChunkID)
+            {
+                relax(node, GOAL, distance + toGoal[graph.portals[node.second].cell]);
+            }
+            // Cross the border
+            Portal portal = graph.portals[node.second];
+            int neighborID = getNeighborID(chunkID, portal.side);
+            const CostGrid &grid = costGrids.at(chunkID);
+            const ChunkGraph &neighborGraph = getChunkGraph(chunks, neighborID);
+            int across = findPortal(neighborGraph, portal.side, portal.cell, grid.cellsPerSide);
+            if(across != -1)
+            {
+                const CostGrid &neighborGrid = costGrids.at(neighborID);
+                double crossing = grid.squareSize * (grid.cost[portal.cell] + neighborGrid.cost[neighborGraph.portals[across].cell]) / 2;
+                relax(node, {neighborID, across}, distance + crossing);
+            }
+        }
+        if(distances.count(GOAL) == 0)
+        {
+            return path;
+        }
+
+        // Walk back through the portals, then fill in the squares between them
+        std::vector<Node> nodes;
+        for(Node node = GOAL; node.second != -2; node = nodeParents.at(node))
+        {
+            nodes.push_back(node);
+        }
+        std::reverse(nodes.begin(), nodes.end());
+        int previousChunkID = startChunkID, previousCell = startCell;
+        steps.push_back({startChunkID, startCell});
+        for(const Node &node : nodes)
+        {
+            int cell = node == GOAL ? goalCell : chunkGraphs.at(node.first).portals[node.second].cell;
+            if(node.first == previousChunkID)
+            {
+                cells = findCellPath(costGrids.at(node.first), previousCell, cell);
+                for(int k = 1; k < (int)cells.size(); k++)
+                {
+                    steps.push_back({node.first, cells[k]});
+                }
+            }
+            else
+            {
+                steps.push_back({node.first, cell});
+            }
+            previousChunkID = node.first;
+            previousCell = cell;
+        }
+    }
+
+    for(const std::pair<int, int> &step : steps)
+    {
+        path.push_back(getCellCenter(costGrids.at(step.first), step.second));
+    }
+    path.front() = start;
+    path.back() = goal;
+    for(Point &p : path)
+    {
+        p.y = chunks.find(getChunkIDContainingPoint(p, chunkSize))->getHeightAt(p);
+    }
+    return path;
+}
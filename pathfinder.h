@@ -0,0 +1,100 @@
+#ifndef RANDOM_TERRAIN_PATHFINDER_H
+#define RANDOM_TERRAIN_PATHFINDER_H
+
+// Finds walking paths across chunks in two levels. Each chunk gets a grid of
+// costs for its terrain squares (steep squares cost more, water and cliffs
+// can't be walked on), and a small graph of portals: the places on its
+// borders where a path can cross into a neighbor, with the cheapest distance
+// between every pair of portals inside the chunk. A long path is found on the
+// portal graph first, and only then filled in square by square, one chunk at
+// a time. Both levels are cached and only rebuilt when a chunk's version changes.
+
+#include "structs.h"
+#include "mathHelper.h"
+#include "chunk.h"
+#include "chunkCache.h"
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+class Pathfinder
+{
+private:
+    // Which border of a chunk, and the neighbor on the other side of it
+    enum Side {Left, Right, Above, Below};
+    const static int NUM_SIDES = 4;
+
+    // The cost to walk one unit of distance in each terrain square, indexed
+    // by i*cellsPerSide + j. Negative means the square can't be walked on.
+    struct CostGrid
+    {
+        int version;
+        int cellsPerSide;
+        double squareSize;
+        double originX, originZ; // the top left corner of the chunk
+        std::vector<double> cost;
+    };
+
+    // A terrain square on the border of a chunk where a path crosses into the neighbor.
+    // The neighbor has a portal in the square right across from it.
+    struct Portal
+    {
+        Side side;
+        int cell;
+    };
+
+    // The portals of a chunk and the cheapest distance between every pair of them,
+    // staying inside the chunk. Portals depend on the neighbors too, so the
+    // graph remembers which versions of them it was made with.
+    struct ChunkGraph
+    {
+        int version;
+        int neighborVersions[NUM_SIDES]; // -1 if the neighbor didn't exist
+        std::vector<Portal> portals;
+        std::vector<double> distances; // indexed by p*portals.size() + q, INFINITY if unreachable
+    };
+
+    int chunkSize;
+    std::unordered_map<int, CostGrid> costGrids;
+    std::unordered_map<int, ChunkGraph> chunkGraphs;
+
+    static int getNeighborID(int chunkID, Side side);
+    static Side getOppositeSide(Side side);
+    // The cell on the border, numbered along the side
+    static int getBorderCell(int cellsPerSide, Side side, int along);
+
+    const CostGrid &getCostGrid(const std::shared_ptr<Chunk> &c);
+    const ChunkGraph &getChunkGraph(const ChunkCache &chunks, int chunkID);
+    // The portal of the neighbor's graph right across from the given cell, or -1
+    static int findPortal(const ChunkGraph &graph, Side side, int cell, int cellsPerSide);
+
+    // Cheapest paths inside one chunk from startCell. If targetCell is not -1,
+    // this uses A* and stops once targetCell is reached.
+    static void searchGrid(const CostGrid &grid, int startCell, int targetCell,
+                           std::vector<double> &distances, std::vector<int> &parents);
+    // The cells from startCell to targetCell inside one chunk, or empty if there is no way
+    static std::vector<int> findCellPath(const CostGrid &grid, int startCell, int targetCell);
+
+    int getCellContaining(const CostGrid &grid, Point p) const;
+    // The closest cell to the given one that can be walked on, or -1 if there aren't any
+    static int getNearestOpenCell(const CostGrid &grid, int cell);
+    static Point getCellCenter(const CostGrid &grid, int cell);
+public:
+    // Squares whose triangles are steeper than this (the y component of the unit normal
+    // is smaller) can't be walked on
+    double MIN_NORMAL_Y = 0.4;
+    // How much more it costs to walk on the steepest walkable slope than on flat ground
+    double SLOPE_PENALTY = 4;
+
+    Pathfinder();
+    explicit Pathfinder(int inputChunkSize);
+
+    // The points to walk through from start to goal, only using chunks that have been made.
+    // Returns an empty vector if there is no way there.
+    std::vector<Point> findPath(const ChunkCache &chunks, Point start, Point goal);
+
+    // Forget everything cached about the chunk (and its neighbors' portals)
+    void invalidateChunk(int chunkID);
+};
+
+#endif //RANDOM_TERRAIN_PATHFINDER_H
@@ -25,12 +25,34 @@ PerlinNoiseGenerator::PerlinNoiseGenerator(int inputWidth, int inputHeight, doub
                                          (int)floor(log(width)));
     setBorders(topInput, bottomInput, leftInput, rightInput);
 }
+PerlinNoiseGenerator::PerlinNoiseGenerator(RandomNumberGenerator &rng, int inputWidth, int inputHeight, double inputBias,
+        std::vector<double> topInput, std::vector<double> bottomInput,
+        std::vector<double> leftInput, std::vector<double> rightInput)
+{
+    width = inputWidth;
+    height = inputHeight;
+    bias = inputBias;
+    if(bias < 0)
+    {
+        bias = 0.2;
+    }
+    fillNoiseSeed(rng, topInput, bottomInput, leftInput, rightInput);
+    perlinNoise = calculatePerlinNoise2D(width, height, noiseSeed,
+                                         (int)floor(log(width)));
+    setBorders(topInput, bottomInput, leftInput, rightInput);
+}
 
 void PerlinNoiseGenerator::fillNoiseSeed(std::vector<double> topInput, std::vector<double> bottomInput,
                                          std::vector<double> leftInput, std::vector<double> rightInput)
 {
-    // Fill in the 2d array with random values
     RandomNumberGenerator rng;
+    fillNoiseSeed(rng, topInput, bottomInput, leftInput, rightInput);
+}
+void PerlinNoiseGenerator::fillNoiseSeed(RandomNumberGenerator &rng, std::vector<double> topInput,
+                                         std::vector<double> bottomInput, std::vector<double> leftInput,
+                                         std::vector<double> rightInput)
+{
+    // Fill in the 2d array with random values
     for(int i = 0; i < width; i++)
     {
         noiseSeed.emplace_back(std::vector<double>());
@@ -23,10 +23,17 @@ public:
 
     PerlinNoiseGenerator(int inputWidth, int inputHeight, double inputBias, std::vector<double> topInput={},
                          std::vector<double> bottomInput={}, std::vector<double> leftInput={}, std::vector<double> rightInput={});
+    // Takes its random values from rng instead of the shared generator, so the
+    // same seed always gives the same noise
+    PerlinNoiseGenerator(RandomNumberGenerator &rng, int inputWidth, int inputHeight, double inputBias,
+                         std::vector<double> topInput={}, std::vector<double> bottomInput={},
+                         std::vector<double> leftInput={}, std::vector<double> rightInput={});
 
     // This takes in preset values for the 4 sides, and fills the 2d array
     void fillNoiseSeed(std::vector<double> topInput={}, std::vector<double> bottomInput={},
             std::vector<double> leftInput={}, std::vector<double> rightInput={});
+    void fillNoiseSeed(RandomNumberGenerator &rng, std::vector<double> topInput={}, std::vector<double> bottomInput={},
+            std::vector<double> leftInput={}, std::vector<double> rightInput={});
 
     // This overwrites the 4 borders (if values are specified)
     void setBorders(std::vector<double> topInput={}, std::vector<double> bottomInput={},
@@ -14,6 +14,7 @@ Player::Player()
     initializeSphericalDirection();
     maxDistanceFromSpawn = 5120;
     isGrounded = true;
+    currentTerrainHeight = location.y - height/2; // until the game finds the ground
     gravity = -0.1;
     jumpAmount = 10;
 }
@@ -33,6 +34,7 @@ Player::Player(Point inputLocation, Point inputLookingAt, Point inputUp,
     initializeSphericalDirection();
     maxDistanceFromSpawn = inputMaxDistanceFromSpawn;
     isGrounded = true;
+    currentTerrainHeight = location.y - height/2; // until the game finds the ground
     gravity = inputGravity;
     jumpAmount = inputJumpAmount;
 }
@@ -153,6 +155,11 @@ void Player::moveXZ()
     location.z += velocity.z;
     lookingAt.z += velocity.z;
 }
+void Player::shiftLocation(double deltaX, double deltaY, double deltaZ)
+{
+    movePoint(location, deltaX, deltaY, deltaZ);
+    movePoint(lookingAt, deltaX, deltaY, deltaZ);
+}
 
 void Player::correctGround()
 {
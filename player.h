@@ -69,6 +69,8 @@ public:
     // Movement
     void move();
     void moveXZ(); // only use the x and z velocity components
+    // Move the player and where they are looking by the same amount
+    void shiftLocation(double deltaX, double deltaY, double deltaZ);
 
     // Keep the Player from going through the ground
     void correctGround();
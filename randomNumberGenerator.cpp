@@ -1,15 +1,34 @@
 #include "randomNumberGenerator.h"
 
-int RandomNumberGenerator::currentValue = time(NULL);
+std::atomic<int> RandomNumberGenerator::currentValue(time(NULL));
 RandomNumberGenerator::RandomNumberGenerator()
 {
-
+    hasOwnSequence = false;
+    ownValue = 0;
+}
+RandomNumberGenerator::RandomNumberGenerator(int seed)
+{
+    hasOwnSequence = true;
+    ownValue = seed % modulus;
+    if(ownValue < 0)
+    {
+        ownValue += modulus;
+    }
 }
 
 // Returns a random number between 0 and 1 and updates current value
 double RandomNumberGenerator::getRandom()
 {
-    double result = static_cast<double>(currentValue) / modulus;
-    currentValue = (RandomNumberGenerator::currentValue * multiplier + additive) % modulus;
-    return result;
-}
\ No newline at end of file
+    if(hasOwnSequence)
+    {
+        double result = static_cast<double>(ownValue) / modulus;
+        ownValue = (ownValue * multiplier + additive) % modulus;
+        return result;
+    }
+    // Chunks are made on several threads, so two of them can't take the same value
+    int value = currentValue;
+    while(!currentValue.compare_exchange_weak(value, (value * multiplier + additive) % modulus))
+    {
+    }
+    return static_cast<double>(value) / modulus;
+}
@@ -2,16 +2,25 @@
 #define RANDOM_TERRAIN_RANDOMNUMBERGENERATOR_H
 
 #include <time.h>
+#include <atomic>
 
 class RandomNumberGenerator
 {
+private:
+    // Generators made with a seed use their own value instead of the shared one
+    bool hasOwnSequence;
+    int ownValue;
 public:
-    static int currentValue;
+    // Shared by every generator made without a seed, on any thread
+    static std::atomic<int> currentValue;
     int modulus = 65536;
     int additive = 6561;
     int multiplier = 17;
 
     RandomNumberGenerator();
+    // The same seed always gives the same sequence, no matter what
+    // else has been using the shared generator
+    explicit RandomNumberGenerator(int seed);
 
     // Returns a random number between 0 and 1 and updates current value
     double getRandom();
@@ -1,5 +1,8 @@
 #include "recPrism.h"
 
+const int RecPrism::EDGES[12][2] = {{1,0}, {1,3}, {3,2}, {2,0}, {4,5}, {5,7}, {7,6}, {6,4}, {0,4}, {2,6}, {3,7}, {1,5}};
+const int RecPrism::FACES[6][4] = {{0,1,3,2}, {5,4,6,7}, {6,4,0,2}, {4,5,1,0}, {6,2,3,7}, {3,1,5,7}};
+
 RecPrism::RecPrism() : Solid()
 {
     initializeCorners();
@@ -234,150 +237,65 @@ void RecPrism::initializeZLinePoints()
     }
 }
 
-void RecPrism::draw() const
+std::vector<Point> RecPrism::getXLinePoints() const
 {
-    glDisable(GL_CULL_FACE);
-    drawLines();
-    drawFaces();
-    glEnable(GL_CULL_FACE);
+    return xLinePoints;
 }
-
-void RecPrism::drawLines() const
+std::vector<Point> RecPrism::getYLinePoints() const
 {
-    if(linesDrawn == NoLines)
-    {
-        return;
-    }
-
-    setGLColor(lineColor);
-    glBegin(GL_LINES);
-    drawPoint(corners[1]);
-    drawPoint(corners[0]);
-
-    drawPoint(corners[1]);
-    drawPoint(corners[3]);
-
-    drawPoint(corners[3]);
-    drawPoint(corners[2]);
-
-    drawPoint(corners[2]);
-    drawPoint(corners[0]);
-
-    drawPoint(corners[4]);
-    drawPoint(corners[5]);
-
-    drawPoint(corners[5]);
-    drawPoint(corners[7]);
-
-    drawPoint(corners[7]);
-    drawPoint(corners[6]);
-
-    drawPoint(corners[6]);
-    drawPoint(corners[4]);
-
-    drawPoint(corners[0]);
-    drawPoint(corners[4]);
-
-    drawPoint(corners[2]);
-    drawPoint(corners[6]);
-
-    drawPoint(corners[3]);
-    drawPoint(corners[7]);
-
-    drawPoint(corners[1]);
-    drawPoint(corners[5]);
-
-    glEnd();
-
-    if(linesDrawn != Normal)
-    {
-        drawGridLines();
-    }
+    return yLinePoints;
 }
-
-void RecPrism::drawFaces() const
+std::vector<Point> RecPrism::getZLinePoints() const
 {
-    glBegin(GL_QUADS);
-    setGLColor(color);
-
-    drawPoint(corners[0]);
-    drawPoint(corners[1]);
-    drawPoint(corners[3]);
-    drawPoint(corners[2]);
-
-    drawPoint(corners[5]);
-    drawPoint(corners[4]);
-    drawPoint(corners[6]);
-    drawPoint(corners[7]);
-
-    drawPoint(corners[6]);
-    drawPoint(corners[4]);
-    drawPoint(corners[0]);
-    drawPoint(corners[2]);
-
-    drawPoint(corners[4]);
-    drawPoint(corners[5]);
-    drawPoint(corners[1]);
-    drawPoint(corners[0]);
-
-    drawPoint(corners[6]);
-    drawPoint(corners[2]);
-    drawPoint(corners[3]);
-    drawPoint(corners[7]);
-
-    drawPoint(corners[3]);
-    drawPoint(corners[1]);
-    drawPoint(corners[5]);
-    drawPoint(corners[7]);
-    glEnd();
+    return zLinePoints;
 }
 
-void RecPrism::drawGridLines() const
+std::vector<Point> RecPrism::getFaces() const
 {
-    setGLColor(lineColor);
-    glBegin(GL_LINES);
+    std::vector<Point> faces;
+    for(const int *face : FACES)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            faces.push_back(corners[face[i]]);
+        }
+    }
+    return faces;
+}
 
-    int pointsPerSide;
+std::vector<Point> RecPrism::getLineSegments() const
+{
+    std::vector<Point> segments;
+    if(linesDrawn == NoLines)
+    {
+        return segments;
+    }
 
-    // x lines
-    pointsPerSide = xLinePoints.size()/4;
-    for(int i = 0; i < pointsPerSide; i++)
+    for(const int *edge : EDGES)
     {
-        drawPoint(xLinePoints[i]);
-        drawPoint(xLinePoints[i + pointsPerSide]);
-        drawPoint(xLinePoints[i + pointsPerSide]);
-        drawPoint(xLinePoints[i + 2*pointsPerSide]);
-        drawPoint(xLinePoints[i + 2*pointsPerSide]);
-        drawPoint(xLinePoints[i + 3*pointsPerSide]);
-        drawPoint(xLinePoints[i + 3*pointsPerSide]);
-        drawPoint(xLinePoints[i]);
+        segments.push_back(corners[edge[0]]);
+        segments.push_back(corners[edge[1]]);
     }
 
-    // y lines
-    pointsPerSide = yLinePoints.size()/4;
-    for(int i = 0; i < pointsPerSide; i++)
+    if(linesDrawn != Normal)
     {
-        drawPoint(yLinePoints[i]);
-        drawPoint(yLinePoints[i + pointsPerSide]);
-        drawPoint(yLinePoints[i + pointsPerSide]);
-        drawPoint(yLinePoints[i + 2*pointsPerSide]);
-        drawPoint(yLinePoints[i + 2*pointsPerSide]);
-        drawPoint(yLinePoints[i + 3*pointsPerSide]);
-        drawPoint(yLinePoints[i + 3*pointsPerSide]);
-        drawPoint(yLinePoints[i]);
+        addGridLineSegments(xLinePoints, segments);
+        addGridLineSegments(yLinePoints, segments);
+        addGridLineSegments(zLinePoints, segments);
     }
+    return segments;
+}
 
-    // z lines
-    pointsPerSide = zLinePoints.size()/4;
+void RecPrism::addGridLineSegments(const std::vector<Point> &linePoints, std::vector<Point> &segments)
+{
+    // Each gridline goes around the prism, connecting the same point on each of the 4 sides
+    int pointsPerSide = linePoints.size()/4;
     for(int i = 0; i < pointsPerSide; i++)
     {
-        drawPoint(zLinePoints[i]);
-        drawPoint(zLinePoints[i + pointsPerSide]);
-        drawPoint(zLinePoints[i + pointsPerSide]);
-        drawPoint(zLinePoints[i + 2*pointsPerSide]);
-        drawPoint(zLinePoints[i + 2*pointsPerSide]);
-        drawPoint(zLinePoints[i + 3*pointsPerSide]);
-        drawPoint(zLinePoints[i + 3*pointsPerSide]);
-        drawPoint(zLinePoints[i]);
+        for(int side = 0; side < 4; side++)
+        {
+            segments.push_back(linePoints[i + side*pointsPerSide]);
+            segments.push_back(linePoints[i + ((side + 1) % 4)*pointsPerSide]);
+        }
     }
 }
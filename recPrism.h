@@ -16,6 +16,11 @@ private:
     std::vector<Point> yLinePoints;
     std::vector<Point> zLinePoints;
 public:
+    // Pairs of corner indices for the 12 edges, in the order they are drawn
+    const static int EDGES[12][2];
+    // Corner indices for the 6 faces
+    const static int FACES[6][4];
+
     RecPrism();
     RecPrism(Point inputCenter, RGBAcolor inputColor,
              double inputXWidth, double inputYWidth, double inputZWidth, RGBAcolor inputLineColor,
@@ -30,10 +35,18 @@ public:
     void initializeYLinePoints();
     void initializeZLinePoints();
 
-    void draw() const;
-    void drawLines() const;
-    void drawFaces() const;
-    void drawGridLines() const;
+    // Getters
+    std::vector<Point> getXLinePoints() const;
+    std::vector<Point> getYLinePoints() const;
+    std::vector<Point> getZLinePoints() const;
+
+    // The corners of the 6 faces, in the order of FACES
+    std::vector<Point> getFaces() const;
+
+    // The edges, plus the gridlines if there are any
+    std::vector<Point> getLineSegments() const;
+    // Add the segments for one set of gridlines (xLinePoints, yLinePoints, or zLinePoints)
+    static void addGridLineSegments(const std::vector<Point> &linePoints, std::vector<Point> &segments);
 };
 
 #endif //RANDOM_TERRAIN_RECPRISM_H
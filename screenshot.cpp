@@ -0,0 +1,67 @@
+#include "screenshot.h"
+#include "graphics.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+Screenshot captureScreenshot(int width, int height)
+{
+    Screenshot image;
+    image.width = width;
+    image.height = height;
+    std::vector<unsigned char> bottomUp(3*width*height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, bottomUp.data());
+    // OpenGL's rows start at the bottom
+    image.rgb.resize(bottomUp.size());
+    for(int row = 0; row < height; row++)
+    {
+        std::copy(bottomUp.begin() + 3*width*(height - 1 - row), bottomUp.begin() + 3*width*(height - row),
+                  image.rgb.begin() + 3*width*row);
+    }
+    return image;
+}
+
+bool writePPM(const std::string &path, const Screenshot &image)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << image.width << " " << image.height << "\n255\n";
+    out.write(reinterpret_cast<const char*>(image.rgb.data()), image.rgb.size());
+    return (bool)out;
+}
+
+bool readPPM(const std::string &path, Screenshot &image)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maxValue;
+    if(!(in >> magic >> image.width >> image.height >> maxValue) || magic != "P6" || maxValue != 255 ||
+       image.width <= 0 || image.height <= 0)
+    {
+        return false;
+    }
+    in.get(); // the one whitespace character before the pixels
+    image.rgb.resize(3*image.width*image.height);
+    return (bool)in.read(reinterpret_cast<char*>(image.rgb.data()), image.rgb.size());
+}
+
+int countDifferentPixels(const Screenshot &a, const Screenshot &b, int tolerance)
+{
+    if(a.width != b.width || a.height != b.height || a.rgb.size() != b.rgb.size())
+    {
+        return -1;
+    }
+    int different = 0;
+    for(size_t i = 0; i < a.rgb.size(); i += 3)
+    {
+        for(int channel = 0; channel < 3; channel++)
+        {
+            if(abs(a.rgb[i + channel] - b.rgb[i + channel]) > tolerance)
+            {
+                different++;
+                break;
+            }
+        }
+    }
+    return different;
+}
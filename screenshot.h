@@ -0,0 +1,28 @@
+#ifndef RANDOM_TERRAIN_SCREENSHOT_H
+#define RANDOM_TERRAIN_SCREENSHOT_H
+
+// Reading back what was drawn, saving it as a binary PPM, and comparing it
+// with a saved image, for checking that the renderer still draws the same thing.
+
+#include <string>
+#include <vector>
+
+struct Screenshot
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> rgb; // top row first
+};
+
+// Read the pixels of the buffer being drawn to
+Screenshot captureScreenshot(int width, int height);
+
+// Return false if the file can't be written or read
+bool writePPM(const std::string &path, const Screenshot &image);
+bool readPPM(const std::string &path, Screenshot &image);
+
+// How many pixels have a channel that is off by more than tolerance,
+// or -1 if the sizes don't match
+int countDifferentPixels(const Screenshot &a, const Screenshot &b, int tolerance);
+
+#endif //RANDOM_TERRAIN_SCREENSHOT_H
@@ -0,0 +1,64 @@
+#ifndef RANDOM_TERRAIN_SHAREDROWS_H
+#define RANDOM_TERRAIN_SHAREDROWS_H
+
+// A grid whose rows can be shared between copies of it. Copying the grid only
+// copies a pointer per row, and changing a copy means giving it its own copy of
+// just the rows that change, so an edit to a few rows of a chunk doesn't copy
+// the whole chunk.
+//
+// Readers use grid[i][j]. Only write to a row the grid made itself, or one
+// from ownRow(), since any other row might be seen through another copy.
+
+#include <memory>
+#include <vector>
+
+template <class T>
+class SharedRows
+{
+private:
+    std::vector<std::shared_ptr<std::vector<T>>> rows;
+public:
+    SharedRows()
+    {
+    }
+    SharedRows(int numRows, int rowLength, const T &value = T())
+    {
+        for(int i = 0; i < numRows; i++)
+        {
+            rows.push_back(std::make_shared<std::vector<T>>(rowLength, value));
+        }
+    }
+
+    int size() const
+    {
+        return rows.size();
+    }
+    const std::vector<T> &operator[](int i) const
+    {
+        return *rows[i];
+    }
+    std::vector<T> &operator[](int i)
+    {
+        return *rows[i];
+    }
+    void addRow(std::vector<T> row)
+    {
+        rows.push_back(std::make_shared<std::vector<T>>(std::move(row)));
+    }
+    // Replace row i with a copy that only this grid has, and return it
+    std::vector<T> &ownRow(int i)
+    {
+        rows[i] = std::make_shared<std::vector<T>>(*rows[i]);
+        return *rows[i];
+    }
+    // ownRow() for rows first to last, inclusive
+    void ownRows(int first, int last)
+    {
+        for(int i = first; i <= last; i++)
+        {
+            ownRow(i);
+        }
+    }
+};
+
+#endif //RANDOM_TERRAIN_SHAREDROWS_H
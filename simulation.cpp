@@ -0,0 +1,151 @@
+#include "simulation.h"
+#include "trace.h"
+#include <chrono>
+
+Simulation::Simulation(GameManager &inputManager) : manager(inputManager), replay(nullptr), replayRealTime(false),
+                                                    replayDone(false), running(false)
+{
+}
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    if(running)
+    {
+        return;
+    }
+    if(replay != nullptr || recorder.isOpen())
+    {
+        manager.setNumChunkThreads(0);
+        manager.setChunkStepsPerUpdate(RECORDED_CHUNK_STEPS_PER_UPDATE);
+        // Workers may have made some of the first chunks already. Finish the
+        // rest, so every run starts from the same chunks.
+        manager.finishChunkJobs();
+    }
+    publishSnapshot();
+    running = true;
+    if(replay != nullptr)
+    {
+        thread = std::thread(&Simulation::runReplay, this);
+    }
+    else
+    {
+        thread = std::thread(&Simulation::run, this);
+    }
+}
+void Simulation::stop()
+{
+    running = false;
+    if(thread.joinable())
+    {
+        thread.join();
+    }
+    recorder.close();
+}
+
+void Simulation::queueInput(const GameInput &input)
+{
+    std::lock_guard<std::mutex> lock(inputMutex);
+    queuedInput.push_back(input);
+}
+
+bool Simulation::startRecording(const std::string &path)
+{
+    return recorder.open(path, manager.getWorldSeed());
+}
+void Simulation::setReplay(const InputLog &log, bool realTime)
+{
+    replay = &log;
+    replayRealTime = realTime;
+}
+bool Simulation::isReplayDone() const
+{
+    return replayDone;
+}
+
+const FrameSnapshot &Simulation::getLatestSnapshot()
+{
+    snapshots.update();
+    return snapshots.getReadBuffer();
+}
+
+void Simulation::publishSnapshot()
+{
+    TRACE_SCOPE("publishSnapshot");
+    manager.makeSnapshot(snapshots.getWriteBuffer());
+    snapshots.publish();
+}
+
+void Simulation::run()
+{
+    setTraceThreadName("game");
+    std::vector<GameInput> input;
+    auto lastUpdate = std::chrono::steady_clock::now();
+    while(running)
+    {
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            input.swap(queuedInput);
+        }
+        for(const GameInput &i : input)
+        {
+            if(recorder.isOpen())
+            {
+                recorder.record(i);
+            }
+            i.apply(manager);
+        }
+        input.clear();
+
+        // The update gets the time rounded the way the log keeps it, and the
+        // rest is left for the next update
+        GameInput update = GameInput::update(
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lastUpdate).count());
+        lastUpdate += std::chrono::microseconds(update.microseconds);
+        if(recorder.isOpen())
+        {
+            recorder.record(update);
+        }
+        {
+            TRACE_SCOPE("update");
+            manager.update(update.getMilliseconds());
+        }
+
+        publishSnapshot();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(UPDATE_MILLISECONDS));
+    }
+}
+
+void Simulation::runReplay()
+{
+    setTraceThreadName("game");
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::microseconds played(0);
+    for(const GameInput &i : replay->getInputs())
+    {
+        if(!running)
+        {
+            return;
+        }
+        if(i.type != UpdateInput)
+        {
+            i.apply(manager);
+            continue;
+        }
+        played += std::chrono::microseconds(i.microseconds);
+        if(replayRealTime)
+        {
+            std::this_thread::sleep_until(start + played);
+        }
+        {
+            TRACE_SCOPE("update");
+            manager.update(i.getMilliseconds());
+        }
+        publishSnapshot();
+    }
+    replayDone = true;
+}
@@ -0,0 +1,74 @@
+#ifndef RANDOM_TERRAIN_SIMULATION_H
+#define RANDOM_TERRAIN_SIMULATION_H
+
+// Runs the game on its own thread, so slow ticks (like making new chunks) don't
+// hold up drawing. After every update the game's thread publishes a snapshot of
+// what to draw, and the drawing thread always draws the newest one. Input from
+// GLUT is queued and applied by the game's thread before its next update.
+//
+// Everything the game's thread does to the manager can be recorded, and a
+// recording can be played back in place of the queued input.
+
+#include "gameManager.h"
+#include "tripleBuffer.h"
+#include "inputLog.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+
+class Simulation
+{
+private:
+    GameManager &manager;
+    TripleBuffer<FrameSnapshot> snapshots;
+
+    std::mutex inputMutex;
+    std::vector<GameInput> queuedInput;
+
+    InputRecorder recorder; // only written by the game's thread
+    const InputLog *replay; // played back instead of the queued input, if set
+    bool replayRealTime;
+    std::atomic<bool> replayDone;
+
+    std::thread thread;
+    std::atomic<bool> running;
+
+    // How long the game's thread waits between updates
+    int UPDATE_MILLISECONDS = 2;
+    // While recording or replaying, chunks are made this many steps per update
+    // on the game's thread. Workers and time budgets finish chunks at different
+    // updates in every run, and a replay has to make them when the recording did.
+    int RECORDED_CHUNK_STEPS_PER_UPDATE = 2;
+
+    void run();
+    void runReplay();
+    void publishSnapshot();
+public:
+    explicit Simulation(GameManager &inputManager);
+    ~Simulation();
+
+    // Publishes the first snapshot, then starts the game's thread. When recording
+    // or replaying, this also moves the chunk making onto the game's thread and
+    // finishes the chunks that were started before it.
+    void start();
+    // Waits for the game's thread to finish
+    void stop();
+
+    // Change the game from the game's thread, before its next update
+    void queueInput(const GameInput &input);
+
+    // Call these before start(). Recording returns false if the file can't be written.
+    bool startRecording(const std::string &path);
+    // The log has to outlive the simulation. In real time, updates happen as far
+    // apart as they were recorded; otherwise as fast as they can.
+    void setReplay(const InputLog &log, bool realTime);
+    // Whether the whole replay has been played
+    bool isReplayDone() const;
+
+    // The newest snapshot. Only the drawing thread calls this.
+    const FrameSnapshot &getLatestSnapshot();
+};
+
+#endif //RANDOM_TERRAIN_SIMULATION_H
@@ -0,0 +1,53 @@
+#ifndef RANDOM_TERRAIN_SNAPSHOTPOINTER_H
+#define RANDOM_TERRAIN_SNAPSHOTPOINTER_H
+
+// Holds the current version of something that is replaced rather than changed.
+// Any thread can load the current version without a lock and keep it as long as
+// it needs, and the writer publishes a new version with one atomic exchange.
+// A version is freed once the last thread holding it lets go.
+//
+// The pointer that is swapped points at a shared_ptr, so a reader can copy the
+// shared_ptr without it being freed out from under it. Replaced ones are
+// retired with epochs.
+
+#include "epoch.h"
+#include <atomic>
+#include <memory>
+
+template <class T>
+class SnapshotPointer
+{
+private:
+    std::atomic<const std::shared_ptr<const T>*> current;
+public:
+    SnapshotPointer() : current(new std::shared_ptr<const T>())
+    {
+    }
+    explicit SnapshotPointer(std::shared_ptr<const T> value) : current(new std::shared_ptr<const T>(std::move(value)))
+    {
+    }
+    ~SnapshotPointer()
+    {
+        delete current.load();
+    }
+
+    SnapshotPointer(const SnapshotPointer&) = delete;
+    SnapshotPointer& operator=(const SnapshotPointer&) = delete;
+
+    std::shared_ptr<const T> load() const
+    {
+        EpochGuard guard;
+        return *current.load();
+    }
+    // Only one thread may store at a time
+    void store(std::shared_ptr<const T> value)
+    {
+        const std::shared_ptr<const T> *old = current.exchange(new std::shared_ptr<const T>(std::move(value)));
+        retireAfterReaders([old]()
+                           {
+                               delete old;
+                           });
+    }
+};
+
+#endif //RANDOM_TERRAIN_SNAPSHOTPOINTER_H
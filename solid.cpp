@@ -64,6 +64,10 @@ double Solid::getXZAngle() const
 {
     return xzAngle;
 }
+linesDrawnEnum Solid::getLinesDrawn() const
+{
+    return linesDrawn;
+}
 
 
 void Solid::setCenter(Point inputCenter)
@@ -124,19 +128,30 @@ void Solid::move(double deltaX, double deltaY, double deltaZ)
 
 void Solid::rotate(double thetaX, double thetaY, double thetaZ)
 {
+    RotationMatrix rotation = makeRotationMatrix(thetaX, thetaY, thetaZ);
     for(Point &p : corners)
     {
-        rotatePointAroundPoint(p, center, thetaX, thetaY, thetaZ);
+        rotatePointAroundPoint(p, center, rotation);
     }
     setXZAngle(xzAngle + thetaY);
 }
 
 void Solid::rotateAroundPoint(const Point &ownerCenter, double thetaX, double thetaY, double thetaZ)
 {
-    rotatePointAroundPoint(center, ownerCenter, thetaX, thetaY, thetaZ);
+    RotationMatrix rotation = makeRotationMatrix(thetaX, thetaY, thetaZ);
+    rotatePointAroundPoint(center, ownerCenter, rotation);
     for(Point &p : corners)
     {
-        rotatePointAroundPoint(p, ownerCenter, thetaX, thetaY, thetaZ);
+        rotatePointAroundPoint(p, ownerCenter, rotation);
     }
     setXZAngle(xzAngle + thetaY);
 }
+
+std::vector<Point> Solid::getFaces() const
+{
+    return std::vector<Point>();
+}
+std::vector<Point> Solid::getLineSegments() const
+{
+    return std::vector<Point>();
+}
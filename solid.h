@@ -3,7 +3,6 @@
 
 #include "structs.h"
 #include "mathHelper.h"
-#include "graphics.h"
 #include <vector>
 #include <experimental/optional>
 #include <cmath>
@@ -45,6 +44,7 @@ public:
     double getZWidth() const;
     double getXZAngle() const;
     RGBAcolor getLineColor() const;
+    linesDrawnEnum getLinesDrawn() const;
 
     // Setter
     void setCenter(Point inputCenter);
@@ -64,7 +64,12 @@ public:
 
     virtual void rotateAroundPoint(const Point &ownerCenter, double thetaX, double thetaY, double thetaZ);
 
-    virtual void draw() const = 0;
+    // The corners of every face, 4 per face, so the renderer can draw any solid
+    virtual std::vector<Point> getFaces() const;
+
+    // Pairs of points for every line drawn on the solid, so lines from many
+    // solids can be drawn together
+    virtual std::vector<Point> getLineSegments() const;
 };
 
 #endif //RANDOM_TERRAIN_SOLID_H
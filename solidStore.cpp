@@ -0,0 +1,236 @@
+#include "solidStore.h"
+
+int SolidStore::Group::size() const
+{
+    return centerX.size();
+}
+
+SolidStore::SolidStore()
+{
+    clear();
+}
+
+void SolidStore::clear()
+{
+    groups = std::vector<Group>(NUM_SHAPES);
+    groups[RectangularPrism].shape = RectangularPrism;
+    for(Group &g : groups)
+    {
+        g.pointStart.push_back(0);
+    }
+}
+
+double SolidStore::wrapAngle(double angle)
+{
+    if(angle > 2*PI)
+    {
+        return angle - 2*PI;
+    }
+    else if(angle < 0)
+    {
+        return angle + 2*PI;
+    }
+    return angle;
+}
+
+SolidHandle SolidStore::addRecPrism(const RecPrism &prism)
+{
+    Group &g = groups[RectangularPrism];
+    Point center = prism.getCenter();
+    g.centerX.push_back(center.x);
+    g.centerY.push_back(center.y);
+    g.centerZ.push_back(center.z);
+    g.xWidth.push_back(prism.getXWidth());
+    g.yWidth.push_back(prism.getYWidth());
+    g.zWidth.push_back(prism.getZWidth());
+    g.xzAngle.push_back(prism.getXZAngle());
+    g.color.push_back(prism.getColor());
+    g.lineColor.push_back(prism.getLineColor());
+    g.linesDrawn.push_back(prism.getLinesDrawn());
+
+    std::vector<Point> points = prism.getCorners();
+    std::vector<Point> xLinePoints = prism.getXLinePoints();
+    std::vector<Point> yLinePoints = prism.getYLinePoints();
+    std::vector<Point> zLinePoints = prism.getZLinePoints();
+    g.numXLinePoints.push_back(xLinePoints.size());
+    g.numYLinePoints.push_back(yLinePoints.size());
+    g.numZLinePoints.push_back(zLinePoints.size());
+    points.insert(points.end(), xLinePoints.begin(), xLinePoints.end());
+    points.insert(points.end(), yLinePoints.begin(), yLinePoints.end());
+    points.insert(points.end(), zLinePoints.begin(), zLinePoints.end());
+    for(const Point &p : points)
+    {
+        g.pointX.push_back(p.x);
+        g.pointY.push_back(p.y);
+        g.pointZ.push_back(p.z);
+    }
+    g.pointStart.push_back(g.pointX.size());
+
+    return {RectangularPrism, g.size() - 1};
+}
+
+// Getters
+int SolidStore::size() const
+{
+    int total = 0;
+    for(const Group &g : groups)
+    {
+        total += g.size();
+    }
+    return total;
+}
+const SolidStore::Group &SolidStore::getGroup(SolidShape shape) const
+{
+    return groups[shape];
+}
+Point SolidStore::getCenter(SolidHandle h) const
+{
+    const Group &g = groups[h.shape];
+    return {g.centerX[h.index], g.centerY[h.index], g.centerZ[h.index]};
+}
+std::vector<Point> SolidStore::getCorners(SolidHandle h) const
+{
+    const Group &g = groups[h.shape];
+    std::vector<Point> corners;
+    int start = g.pointStart[h.index];
+    for(int i = start; i < start + CORNERS_PER_PRISM; i++)
+    {
+        corners.push_back({g.pointX[i], g.pointY[i], g.pointZ[i]});
+    }
+    return corners;
+}
+
+void SolidStore::getLineSegments(SolidShape shape, std::vector<Point> &segments, std::vector<RGBAcolor> &colors) const
+{
+    const Group &g = groups[shape];
+    switch(shape)
+    {
+        case RectangularPrism:
+            for(int s = 0; s < g.size(); s++)
+            {
+                addRecPrismLineSegments(g, s, segments, colors);
+            }
+            break;
+    }
+}
+
+void SolidStore::addRecPrismLineSegments(const Group &g, int index, std::vector<Point> &segments,
+                                         std::vector<RGBAcolor> &colors)
+{
+    int numSegmentsBefore = segments.size();
+    if(g.linesDrawn[index] == NoLines)
+    {
+        return;
+    }
+    int start = g.pointStart[index];
+    for(const int *edge : RecPrism::EDGES)
+    {
+        int a = start + edge[0], b = start + edge[1];
+        segments.push_back({g.pointX[a], g.pointY[a], g.pointZ[a]});
+        segments.push_back({g.pointX[b], g.pointY[b], g.pointZ[b]});
+    }
+    int next = start + CORNERS_PER_PRISM;
+    for(int numPoints : {g.numXLinePoints[index], g.numYLinePoints[index], g.numZLinePoints[index]})
+    {
+        if(g.linesDrawn[index] == Normal)
+        {
+            break;
+        }
+        std::vector<Point> linePoints;
+        for(int i = next; i < next + numPoints; i++)
+        {
+            linePoints.push_back({g.pointX[i], g.pointY[i], g.pointZ[i]});
+        }
+        RecPrism::addGridLineSegments(linePoints, segments);
+        next += numPoints;
+    }
+    colors.insert(colors.end(), segments.size() - numSegmentsBefore, g.lineColor[index]);
+}
+
+// Transformations
+void SolidStore::move(SolidShape shape, int first, int count, double deltaX, double deltaY, double deltaZ)
+{
+    if(count <= 0)
+    {
+        return;
+    }
+    Group &g = groups[shape];
+    movePoints(&g.centerX[first], &g.centerY[first], &g.centerZ[first], count, deltaX, deltaY, deltaZ);
+    // The points of consecutive solids are next to each other, so they can all be moved at once
+    int pointFirst = g.pointStart[first];
+    int pointCount = g.pointStart[first + count] - pointFirst;
+    movePoints(&g.pointX[pointFirst], &g.pointY[pointFirst], &g.pointZ[pointFirst], pointCount,
+               deltaX, deltaY, deltaZ);
+}
+
+void SolidStore::rotate(SolidShape shape, int first, int count, double thetaX, double thetaY, double thetaZ)
+{
+    if(count <= 0)
+    {
+        return;
+    }
+    RotationMatrix rotation = makeRotationMatrix(thetaX, thetaY, thetaZ);
+    Group &g = groups[shape];
+    switch(shape)
+    {
+        case RectangularPrism:
+            rotateGroupAroundCenters(g, first, count, rotation);
+            break;
+    }
+    for(int s = first; s < first + count; s++)
+    {
+        g.xzAngle[s] = wrapAngle(g.xzAngle[s] + thetaY);
+    }
+}
+
+void SolidStore::rotateGroupAroundCenters(Group &g, int first, int count, const RotationMatrix &rotation)
+{
+    for(int s = first; s < first + count; s++)
+    {
+        int start = g.pointStart[s];
+        rotatePointsAroundPoint(&g.pointX[start], &g.pointY[start], &g.pointZ[start], g.pointStart[s+1] - start,
+                                {g.centerX[s], g.centerY[s], g.centerZ[s]}, rotation);
+    }
+}
+
+void SolidStore::rotateAroundPoint(SolidShape shape, int first, int count, const Point &ownerCenter,
+                                   double thetaX, double thetaY, double thetaZ)
+{
+    if(count <= 0)
+    {
+        return;
+    }
+    RotationMatrix rotation = makeRotationMatrix(thetaX, thetaY, thetaZ);
+    Group &g = groups[shape];
+    rotatePointsAroundPoint(&g.centerX[first], &g.centerY[first], &g.centerZ[first], count, ownerCenter, rotation);
+    int pointFirst = g.pointStart[first];
+    int pointCount = g.pointStart[first + count] - pointFirst;
+    rotatePointsAroundPoint(&g.pointX[pointFirst], &g.pointY[pointFirst], &g.pointZ[pointFirst], pointCount,
+                            ownerCenter, rotation);
+    for(int s = first; s < first + count; s++)
+    {
+        g.xzAngle[s] = wrapAngle(g.xzAngle[s] + thetaY);
+    }
+}
+
+void SolidStore::moveAll(double deltaX, double deltaY, double deltaZ)
+{
+    for(Group &g : groups)
+    {
+        move(g.shape, 0, g.size(), deltaX, deltaY, deltaZ);
+    }
+}
+void SolidStore::rotateAll(double thetaX, double thetaY, double thetaZ)
+{
+    for(Group &g : groups)
+    {
+        rotate(g.shape, 0, g.size(), thetaX, thetaY, thetaZ);
+    }
+}
+void SolidStore::rotateAllAroundPoint(const Point &ownerCenter, double thetaX, double thetaY, double thetaZ)
+{
+    for(Group &g : groups)
+    {
+        rotateAroundPoint(g.shape, 0, g.size(), ownerCenter, thetaX, thetaY, thetaZ);
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef RANDOM_TERRAIN_SOLIDSTORE_H
+#define RANDOM_TERRAIN_SOLIDSTORE_H
+
+// Stores many solids as parallel arrays (one array per field) instead of one
+// object per solid. Solids are grouped by shape, so an operation on the store
+// picks what to do for a shape once and then runs over the whole group,
+// with the rotation matrix computed once for all of them.
+
+#include "structs.h"
+#include "mathHelper.h"
+#include "recPrism.h"
+#include <vector>
+
+enum SolidShape {RectangularPrism};
+
+// Which solid in the store, for looking one up again
+struct SolidHandle
+{
+    SolidShape shape;
+    int index;
+};
+
+class SolidStore
+{
+public:
+    // Every solid of one shape
+    struct Group
+    {
+        SolidShape shape;
+        std::vector<double> centerX, centerY, centerZ;
+        std::vector<double> xWidth, yWidth, zWidth;
+        std::vector<double> xzAngle;
+        std::vector<RGBAcolor> color;
+        std::vector<RGBAcolor> lineColor;
+        std::vector<linesDrawnEnum> linesDrawn;
+
+        // The corners and gridline points of every solid. The points for solid s
+        // go from pointStart[s] up to pointStart[s+1], corners first, then the
+        // x, y, and z gridline points.
+        std::vector<int> pointStart;
+        std::vector<int> numXLinePoints, numYLinePoints, numZLinePoints;
+        std::vector<double> pointX, pointY, pointZ;
+
+        int size() const;
+    };
+
+private:
+    std::vector<Group> groups; // indexed by SolidShape
+
+    const static int NUM_SHAPES = 1;
+    const static int CORNERS_PER_PRISM = 8;
+
+    // Make sure the angle stays between 0 and 2PI, like Solid::setXZAngle()
+    static double wrapAngle(double angle);
+
+    // Rotate the points of solids first to first+count-1 around their own centers
+    static void rotateGroupAroundCenters(Group &g, int first, int count, const RotationMatrix &rotation);
+    static void addRecPrismLineSegments(const Group &g, int index, std::vector<Point> &segments,
+                                        std::vector<RGBAcolor> &colors);
+public:
+    SolidStore();
+
+    void clear();
+
+    // Copy a solid into the store
+    SolidHandle addRecPrism(const RecPrism &prism);
+
+    // Getters
+    int size() const;
+    const Group &getGroup(SolidShape shape) const;
+    Point getCenter(SolidHandle h) const;
+    std::vector<Point> getCorners(SolidHandle h) const;
+
+    // Pairs of points for the edges and gridlines of every solid with this shape,
+    // and the line color for each point
+    void getLineSegments(SolidShape shape, std::vector<Point> &segments, std::vector<RGBAcolor> &colors) const;
+
+    // Transform count solids of one shape, starting at first
+    void move(SolidShape shape, int first, int count, double deltaX, double deltaY, double deltaZ);
+    void rotate(SolidShape shape, int first, int count, double thetaX, double thetaY, double thetaZ);
+    void rotateAroundPoint(SolidShape shape, int first, int count, const Point &ownerCenter,
+                           double thetaX, double thetaY, double thetaZ);
+
+    // Transform every solid in the store
+    void moveAll(double deltaX, double deltaY, double deltaZ);
+    void rotateAll(double thetaX, double thetaY, double thetaZ);
+    void rotateAllAroundPoint(const Point &ownerCenter, double thetaX, double thetaY, double thetaZ);
+};
+
+#endif //RANDOM_TERRAIN_SOLIDSTORE_H
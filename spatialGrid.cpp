@@ -0,0 +1,77 @@
+#include "spatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid()
+{
+    minX = 0;
+    minZ = 0;
+    cellSize = 1;
+    cellsX = 0;
+    cellsZ = 0;
+}
+SpatialGrid::SpatialGrid(double inputMinX, double inputMinZ, double inputCellSize, int inputCellsX, int inputCellsZ)
+{
+    minX = inputMinX;
+    minZ = inputMinZ;
+    cellSize = inputCellSize;
+    cellsX = inputCellsX;
+    cellsZ = inputCellsZ;
+    cells = std::vector<std::vector<int>>(cellsX*cellsZ);
+}
+
+void SpatialGrid::clear()
+{
+    for(std::vector<int> &cell : cells)
+    {
+        cell.clear();
+    }
+}
+
+bool SpatialGrid::getCellRange(double xMin, double zMin, double xMax, double zMax,
+                               int &iMin, int &jMin, int &iMax, int &jMax) const
+{
+    iMin = std::max(0, (int)floor((xMin - minX) / cellSize));
+    jMin = std::max(0, (int)floor((zMin - minZ) / cellSize));
+    iMax = std::min(cellsX - 1, (int)floor((xMax - minX) / cellSize));
+    jMax = std::min(cellsZ - 1, (int)floor((zMax - minZ) / cellSize));
+    return iMin <= iMax && jMin <= jMax;
+}
+
+void SpatialGrid::insert(int item, double xMin, double zMin, double xMax, double zMax)
+{
+    int iMin, jMin, iMax, jMax;
+    if(!getCellRange(xMin, zMin, xMax, zMax, iMin, jMin, iMax, jMax))
+    {
+        return;
+    }
+    for(int i = iMin; i <= iMax; i++)
+    {
+        for(int j = jMin; j <= jMax; j++)
+        {
+            cells[i*cellsZ + j].push_back(item);
+        }
+    }
+}
+
+std::vector<int> SpatialGrid::query(double xMin, double zMin, double xMax, double zMax) const
+{
+    std::vector<int> result;
+    int iMin, jMin, iMax, jMax;
+    if(!getCellRange(xMin, zMin, xMax, zMax, iMin, jMin, iMax, jMax))
+    {
+        return result;
+    }
+    for(int i = iMin; i <= iMax; i++)
+    {
+        for(int j = jMin; j <= jMax; j++)
+        {
+            const std::vector<int> &cell = cells[i*cellsZ + j];
+            result.insert(result.end(), cell.begin(), cell.end());
+        }
+    }
+    // An item that covers several cells would show up more than once
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
@@ -0,0 +1,36 @@
+#ifndef RANDOM_TERRAIN_SPATIALGRID_H
+#define RANDOM_TERRAIN_SPATIALGRID_H
+
+// A uniform grid over a rectangle in the xz plane. Each cell keeps the
+// indices of the items whose footprints overlap it, so finding what is near
+// a point only means looking at a few cells.
+
+#include <vector>
+
+class SpatialGrid
+{
+private:
+    double minX, minZ;  // the top left corner of the grid
+    double cellSize;
+    int cellsX, cellsZ;
+    std::vector<std::vector<int>> cells;
+
+    // The range of cells overlapping the rectangle, clamped to the grid.
+    // Returns false if the rectangle is completely outside the grid.
+    bool getCellRange(double xMin, double zMin, double xMax, double zMax,
+                      int &iMin, int &jMin, int &iMax, int &jMax) const;
+public:
+    SpatialGrid();
+    SpatialGrid(double inputMinX, double inputMinZ, double inputCellSize, int inputCellsX, int inputCellsZ);
+
+    // Remove all items but keep the layout
+    void clear();
+
+    // Add item to every cell overlapping the rectangle
+    void insert(int item, double xMin, double zMin, double xMax, double zMax);
+
+    // Every item in a cell overlapping the rectangle, each listed once
+    std::vector<int> query(double xMin, double zMin, double xMax, double zMax) const;
+};
+
+#endif //RANDOM_TERRAIN_SPATIALGRID_H
@@ -0,0 +1,287 @@
+#include "terrainRaycaster.h"
+#include <algorithm>
+
+// Walk the square cells of a grid along the ray (x and z only), in order, from
+// distance tStart to tEnd. Cell (0,0) has its top left corner at (gridX, gridZ).
+// visit(i, j, tEnter, tExit) is called for each cell and returns true to stop.
+// Returns true if visit stopped the walk.
+template<typename Visitor>
+static bool walkGrid(const Point &origin, const Point &direction, double gridX, double gridZ, double cellSize,
+                     double tStart, double tEnd, Visitor visit)
+{
+    double startX = origin.x + direction.x*tStart;
+    double startZ = origin.z + direction.z*tStart;
+    int i = floor((startX - gridX) / cellSize);
+    int j = floor((startZ - gridZ) / cellSize);
+
+    int stepI = direction.x > 0 ? 1 : -1;
+    int stepJ = direction.z > 0 ? 1 : -1;
+    double tMaxX = INFINITY, tMaxZ = INFINITY, tDeltaX = INFINITY, tDeltaZ = INFINITY;
+    if(direction.x != 0)
+    {
+        double nextX = gridX + (i + (stepI > 0 ? 1 : 0))*cellSize;
+        tMaxX = (nextX - origin.x) / direction.x;
+        tDeltaX = cellSize / fabs(direction.x);
+    }
+    if(direction.z != 0)
+    {
+        double nextZ = gridZ + (j + (stepJ > 0 ? 1 : 0))*cellSize;
+        tMaxZ = (nextZ - origin.z) / direction.z;
+        tDeltaZ = cellSize / fabs(direction.z);
+    }
+
+    double tEnter = tStart;
+    while(tEnter < tEnd)
+    {
+        double tExit = fmin(fmin(tMaxX, tMaxZ), tEnd);
+        if(visit(i, j, tEnter, tExit))
+        {
+            return true;
+        }
+        if(tMaxX < tMaxZ)
+        {
+            i += stepI;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            j += stepJ;
+            tMaxZ += tDeltaZ;
+        }
+        tEnter = tExit;
+    }
+    return false;
+}
+
+TerrainRaycaster::TerrainRaycaster(const ChunkCache &inputChunks, int inputChunkSize) : chunks(inputChunks)
+{
+    chunkSize = inputChunkSize;
+}
+
+std::experimental::optional<RayHit> TerrainRaycaster::castRay(const Ray &ray) const
+{
+    int lastID = -1;
+    const Chunk *lastChunk = nullptr;
+    return castRay(ray, lastID, lastChunk);
+}
+
+std::vector<std::experimental::optional<RayHit>> TerrainRaycaster::castRays(const std::vector<Ray> &rays) const
+{
+    std::vector<std::experimental::optional<RayHit>> hits;
+    hits.reserve(rays.size());
+    int lastID = -1;
+    const Chunk *lastChunk = nullptr;
+    for(const Ray &ray : rays)
+    {
+        hits.push_back(castRay(ray, lastID, lastChunk));
+    }
+    return hits;
+}
+
+const Chunk *TerrainRaycaster::findChunk(int chunkID, int &lastID, const Chunk *&lastChunk) const
+{
+    if(chunkID != lastID)
+    {
+        // The cache keeps every chunk alive, so holding a plain pointer is safe
+        lastID = chunkID;
+        lastChunk = chunks.find(chunkID).get();
+    }
+    return lastChunk;
+}
+
+std::experimental::optional<RayHit> TerrainRaycaster::castRay(const Ray &ray, int &lastID, const Chunk *&lastChunk) const
+{
+    double length = sqrt(dotProduct(ray.direction, ray.direction));
+    if(length == 0 || ray.maxDistance <= 0)
+    {
+        return std::experimental::nullopt;
+    }
+    Point direction = {ray.direction.x/length, ray.direction.y/length, ray.direction.z/length};
+
+    RayHit hit;
+    bool found = walkGrid(ray.origin, direction, 0, 0, chunkSize, 0, ray.maxDistance,
+        [&](int i, int j, double tEnter, double tExit)
+        {
+            int chunkID = point2DtoChunkID({i, j});
+            const Chunk *c = findChunk(chunkID, lastID, lastChunk);
+            if(c == nullptr)
+            {
+                return false;
+            }
+            if(intersectChunk(*c, ray.origin, direction, tEnter, tExit, hit))
+            {
+                hit.chunkID = chunkID;
+                return true;
+            }
+            return false;
+        });
+    if(!found)
+    {
+        return std::experimental::nullopt;
+    }
+    return hit;
+}
+
+bool TerrainRaycaster::intersectChunk(const Chunk &c, const Point &origin, const Point &direction,
+                                      double tStart, double tEnd, RayHit &hit)
+{
+    std::shared_ptr<const ChunkVersion> v = c.getCurrentVersion();
+    // Skip the chunk if the ray is above everything in it the whole time
+    double lowestY = fmin(origin.y + direction.y*tStart, origin.y + direction.y*tEnd);
+    double topHeight = v->heights->heightPyramid.getMaxHeight();
+    if(v->buildings)
+    {
+        topHeight = fmax(topHeight, v->buildings->buildingTop);
+    }
+    if(lowestY > topHeight)
+    {
+        return false;
+    }
+
+    double tTerrain = INFINITY, tBuilding = INFINITY;
+    std::shared_ptr<Building> buildingHit;
+    bool hitTerrain = intersectTerrain(c, *v, origin, direction, tStart, tEnd, tTerrain);
+    bool hitBuilding = intersectBuildings(*v, origin, direction, tStart, tEnd, tBuilding, buildingHit);
+    if(!hitTerrain && !hitBuilding)
+    {
+        return false;
+    }
+    double t = fmin(tTerrain, tBuilding);
+    hit.location = {origin.x + direction.x*t, origin.y + direction.y*t, origin.z + direction.z*t};
+    hit.distance = t;
+    hit.building = tBuilding < tTerrain ? buildingHit : nullptr;
+    return true;
+}
+
+bool TerrainRaycaster::intersectTerrain(const Chunk &c, const ChunkVersion &v, const Point &origin, const Point &direction,
+                                        double tStart, double tEnd, double &tHit)
+{
+    const SharedRows<Point> &points = v.heights->terrainPoints;
+    const HeightPyramid &pyramid = v.heights->heightPyramid;
+    if(fmin(origin.y + direction.y*tStart, origin.y + direction.y*tEnd) > pyramid.getMaxHeight())
+    {
+        return false;
+    }
+    int squaresPerSide = c.getPointsPerSide() - 1;
+    double squareSize = c.getSideLength() / (double)squaresPerSide;
+    Point2D topLeft = c.getTopLeft();
+
+    return walkGrid(origin, direction, topLeft.x*c.getSideLength(), topLeft.z*c.getSideLength(), squareSize,
+                    tStart, tEnd,
+        [&](int i, int j, double tEnter, double tExit)
+        {
+            // Rounding can put the ray just outside the chunk at its edges
+            i = std::max(0, std::min(squaresPerSide - 1, i));
+            j = std::max(0, std::min(squaresPerSide - 1, j));
+            if(fmin(origin.y + direction.y*tEnter, origin.y + direction.y*tExit) > pyramid.getMax(0, i, j))
+            {
+                return false;
+            }
+            // The same two triangles the square is drawn and collided with
+            double t1 = INFINITY, t2 = INFINITY;
+            bool hit1 = intersectTriangle(origin, direction, points[i][j], points[i+1][j], points[i][j+1], t1);
+            bool hit2 = intersectTriangle(origin, direction, points[i+1][j+1], points[i+1][j], points[i][j+1], t2);
+            double t = fmin(hit1 ? t1 : INFINITY, hit2 ? t2 : INFINITY);
+            if(t >= tStart && t <= tEnd)
+            {
+                tHit = t;
+                return true;
+            }
+            return false;
+        });
+}
+
+bool TerrainRaycaster::intersectBuildings(const ChunkVersion &v, const Point &origin, const Point &direction,
+                                          double tStart, double tEnd, double &tHit,
+                                          std::shared_ptr<Building> &buildingHit)
+{
+    bool found = false;
+    if(!v.buildings)
+    {
+        return false;
+    }
+    for(const std::shared_ptr<Building> &b : v.buildings->buildings)
+    {
+        for(const std::shared_ptr<Solid> &s : b->getSolids())
+        {
+            double t;
+            if(intersectBox(origin, direction, s->getCorners(), tStart, fmin(tEnd, tHit), t))
+            {
+                tHit = t;
+                buildingHit = b;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+bool TerrainRaycaster::intersectTriangle(const Point &origin, const Point &direction,
+                                         const Point &a, const Point &b, const Point &c, double &t)
+{
+    const double EPSILON = 1e-9;
+    Point edge1 = {b.x - a.x, b.y - a.y, b.z - a.z};
+    Point edge2 = {c.x - a.x, c.y - a.y, c.z - a.z};
+    Point h = crossProduct(direction, edge2);
+    double det = dotProduct(edge1, h);
+    if(fabs(det) < EPSILON)
+    {
+        return false;   // the ray is parallel to the triangle
+    }
+    double invDet = 1 / det;
+    Point s = {origin.x - a.x, origin.y - a.y, origin.z - a.z};
+    double u = invDet * dotProduct(s, h);
+    if(u < 0 || u > 1)
+    {
+        return false;
+    }
+    Point q = crossProduct(s, edge1);
+    double v = invDet * dotProduct(direction, q);
+    if(v < 0 || u + v > 1)
+    {
+        return false;
+    }
+    t = invDet * dotProduct(edge2, q);
+    return t >= 0;
+}
+
+bool TerrainRaycaster::intersectBox(const Point &origin, const Point &direction, const std::vector<Point> &corners,
+                                    double tStart, double tEnd, double &t)
+{
+    if(corners.empty())
+    {
+        return false;
+    }
+    Point minCorner = corners[0], maxCorner = corners[0];
+    for(const Point &p : corners)
+    {
+        minCorner = {fmin(minCorner.x, p.x), fmin(minCorner.y, p.y), fmin(minCorner.z, p.z)};
+        maxCorner = {fmax(maxCorner.x, p.x), fmax(maxCorner.y, p.y), fmax(maxCorner.z, p.z)};
+    }
+    double tNear = tStart, tFar = tEnd;
+    const double o[3] = {origin.x, origin.y, origin.z};
+    const double d[3] = {direction.x, direction.y, direction.z};
+    const double lo[3] = {minCorner.x, minCorner.y, minCorner.z};
+    const double hi[3] = {maxCorner.x, maxCorner.y, maxCorner.z};
+    for(int axis = 0; axis < 3; axis++)
+    {
+        if(d[axis] == 0)
+        {
+            if(o[axis] < lo[axis] || o[axis] > hi[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        double t1 = (lo[axis] - o[axis]) / d[axis];
+        double t2 = (hi[axis] - o[axis]) / d[axis];
+        tNear = fmax(tNear, fmin(t1, t2));
+        tFar = fmin(tFar, fmax(t1, t2));
+        if(tNear > tFar)
+        {
+            return false;
+        }
+    }
+    t = tNear;
+    return true;
+}
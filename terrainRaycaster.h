@@ -0,0 +1,68 @@
+#ifndef RANDOM_TERRAIN_TERRAINRAYCASTER_H
+#define RANDOM_TERRAIN_TERRAINRAYCASTER_H
+
+// Finds where rays hit the terrain or buildings. The ray walks through the chunks
+// it crosses in order, and through each chunk's squares in order (2D DDA), so the
+// first hit found is the closest. Chunks and squares that the ray passes
+// completely above are skipped using their max heights.
+
+#include <experimental/optional>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include "structs.h"
+#include "chunk.h"
+#include "chunkCache.h"
+
+struct Ray
+{
+    Point origin;
+    Point direction;    // doesn't need to be normalized
+    double maxDistance;
+};
+
+struct RayHit
+{
+    Point location;
+    double distance;
+    int chunkID;
+    std::shared_ptr<Building> building; // nullptr if the terrain was hit
+};
+
+class TerrainRaycaster
+{
+private:
+    const ChunkCache &chunks;
+    int chunkSize;
+
+    // Find the closest hit in one chunk between distances tStart and tEnd along the
+    // ray. direction must be normalized. Returns false if nothing is hit. The
+    // terrain and buildings are both from the chunk's version when this starts.
+    static bool intersectChunk(const Chunk &c, const Point &origin, const Point &direction,
+                               double tStart, double tEnd, RayHit &hit);
+    static bool intersectTerrain(const Chunk &c, const ChunkVersion &v, const Point &origin, const Point &direction,
+                                 double tStart, double tEnd, double &tHit);
+    static bool intersectBuildings(const ChunkVersion &v, const Point &origin, const Point &direction,
+                                   double tStart, double tEnd, double &tHit, std::shared_ptr<Building> &buildingHit);
+
+    // Möller–Trumbore ray/triangle intersection
+    static bool intersectTriangle(const Point &origin, const Point &direction,
+                                  const Point &a, const Point &b, const Point &c, double &t);
+    // Slab test against the axis-aligned box around the corners
+    static bool intersectBox(const Point &origin, const Point &direction, const std::vector<Point> &corners,
+                             double tStart, double tEnd, double &t);
+
+    // Look up a chunk, remembering the last one since rays in a batch tend to share chunks
+    const Chunk *findChunk(int chunkID, int &lastID, const Chunk *&lastChunk) const;
+    std::experimental::optional<RayHit> castRay(const Ray &ray, int &lastID, const Chunk *&lastChunk) const;
+public:
+    TerrainRaycaster(const ChunkCache &inputChunks, int inputChunkSize);
+
+    // The closest hit within ray.maxDistance, or nullopt
+    std::experimental::optional<RayHit> castRay(const Ray &ray) const;
+
+    // The same as calling castRay() on each, in order
+    std::vector<std::experimental::optional<RayHit>> castRays(const std::vector<Ray> &rays) const;
+};
+
+#endif //RANDOM_TERRAIN_TERRAINRAYCASTER_H
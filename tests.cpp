@@ -0,0 +1,631 @@
+// Checks that run without a window: ctest runs this, and it fails if any check
+// does. The checks that need a graphics card use an offscreen context, and are
+// skipped if one can't be made here.
+
+#include "world.h"
+#include "simulation.h"
+#include "offscreenContext.h"
+#include "buildingBatch.h"
+#include "screenshot.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what)
+{
+    if(!ok)
+    {
+        failures++;
+        std::cout << "FAILED: " << what << std::endl;
+    }
+}
+
+// ==========================
+//
+//      Terrain Editing
+//
+// ==========================
+
+// How far above the lowest corner of its square each building's center is
+static std::vector<double> getBuildingHeightsAboveGround(const Chunk &c, const ChunkVersion &v)
+{
+    double squareSize = c.getSideLength() / (c.getPointsPerSide() - 1.0);
+    std::vector<double> heights;
+    for(const std::shared_ptr<Building> &b : v.buildings->buildings)
+    {
+        Point center = b->getCenter();
+        int i = floor((center.x - c.getTopLeft().x*c.getSideLength()) / squareSize);
+        int j = floor((center.z - c.getTopLeft().z*c.getSideLength()) / squareSize);
+        heights.push_back(center.y - Chunk::getMinSquareHeight(*v.heights, i, j));
+    }
+    return heights;
+}
+
+// Digging under a building has to move it down with the ground, along with
+// the solids it's drawn with and the chunk's building top. In this world the
+// chunk at (1, -2) has a city.
+static void checkBuildingsFollowEdit(World &world)
+{
+    std::shared_ptr<Chunk> city = world.getChunk(point2DtoChunkID({1, -2}));
+    check(city != nullptr && city->getHasCity(), "the city chunk was made");
+    if(!city || !city->getHasCity())
+    {
+        return;
+    }
+    city->ensureBuildings();
+    std::shared_ptr<const ChunkVersion> before = city->getCurrentVersion();
+    check(before->buildings && !before->buildings->buildings.empty(), "the city has buildings");
+    if(!before->buildings || before->buildings->buildings.empty())
+    {
+        return;
+    }
+    Point center = before->buildings->buildings[0]->getCenter();
+    TerrainBrush brush = {center.x, center.z, 40, Dig, 30, 0};
+    world.deformTerrain(brush);
+    std::shared_ptr<const ChunkVersion> after = city->getCurrentVersion();
+
+    check(after->buildings->buildings[0]->getCenter().y < center.y, "the building under the edit moved down");
+    std::vector<double> aboveBefore = getBuildingHeightsAboveGround(*city, *before);
+    std::vector<double> aboveAfter = getBuildingHeightsAboveGround(*city, *after);
+    bool onGround = aboveBefore.size() == aboveAfter.size();
+    for(int k = 0; onGround && k < (int)aboveAfter.size(); k++)
+    {
+        onGround = fabs(aboveAfter[k] - aboveBefore[k]) < 1e-9;
+    }
+    check(onGround, "every building is as far above the ground as before the edit");
+    const SolidStore::Group &prisms = after->buildings->buildingSolids.getGroup(RectangularPrism);
+    bool solidsMoved = prisms.size() == (int)after->buildings->buildings.size();
+    double top = -INFINITY;
+    for(int k = 0; solidsMoved && k < prisms.size(); k++)
+    {
+        Point buildingCenter = after->buildings->buildings[k]->getCenter();
+        solidsMoved = prisms.centerY[k] == buildingCenter.y;
+        top = fmax(top, 2*buildingCenter.y - (buildingCenter.y - aboveAfter[k]));
+    }
+    check(solidsMoved, "the buildings' solids moved with them");
+    check(fabs(after->buildings->buildingTop - top) < 1e-9, "the building top is the highest roof after the edit");
+}
+
+// An edit over the corner where four chunks meet has to leave their borders
+// matching, and the uploaded meshes, patched only where the edit reached, have
+// to be the same as meshes made from scratch. In this world the ground around
+// (0, -512) is above the water, so the edit doesn't change the water and the
+// meshes can be patched.
+static void testDeformAcrossSeam()
+{
+    // The context is made first so it's still there when the chunks' GL objects are deleted
+    OffscreenContext context;
+    bool canUpload = context.create(64, 64);
+    if(!canUpload)
+    {
+        std::cout << "No OpenGL context here, so the uploaded meshes aren't checked" << std::endl;
+    }
+    World world(3, 30, 3);
+    world.finishChunkJobs();
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    for(int x = -1; x <= 0; x++)
+    {
+        for(int z = -2; z <= -1; z++)
+        {
+            std::shared_ptr<Chunk> c = world.getChunk(point2DtoChunkID({x, z}));
+            check(c != nullptr, "the chunks around the corner were made");
+            if(!c)
+            {
+                return;
+            }
+            chunks.push_back(c);
+        }
+    }
+    if(canUpload)
+    {
+        for(const std::shared_ptr<Chunk> &c : chunks)
+        {
+            c->uploadMesh();
+        }
+    }
+    std::shared_ptr<Chunk> topLeft = chunks[0], bottomLeft = chunks[1], topRight = chunks[2], bottomRight = chunks[3];
+    double cornerBefore = bottomRight->getCurrentVersion()->heights->terrainPoints[0][0].y;
+
+    TerrainBrush brush = {0, -512, 150, Raise, 25, 0};
+    world.deformTerrain(brush);
+
+    check(bottomRight->getCurrentVersion()->heights->terrainPoints[0][0].y == cornerBefore + 25,
+          "the center of the brush is raised by its amount");
+    check(topLeft->getRightTerrainHeights(false) == topRight->getLeftTerrainHeights(false), "top seam matches");
+    check(bottomLeft->getRightTerrainHeights(false) == bottomRight->getLeftTerrainHeights(false), "bottom seam matches");
+    check(topLeft->getBottomTerrainHeights(false) == bottomLeft->getTopTerrainHeights(false), "left seam matches");
+    check(topRight->getBottomTerrainHeights(false) == bottomRight->getTopTerrainHeights(false), "right seam matches");
+    checkBuildingsFollowEdit(world);
+
+    if(!canUpload)
+    {
+        return;
+    }
+    int patched = 0;
+    for(const std::shared_ptr<Chunk> &c : chunks)
+    {
+        std::shared_ptr<const ChunkVersion> v = c->getCurrentVersion();
+        if(v->meshPatch)
+        {
+            patched++;
+        }
+        std::vector<float> fresh(c->getMeshVertexCount(*v) * Chunk::FLOATS_PER_VERTEX);
+        c->writeMesh(*v, fresh.data());
+        c->uploadMesh();
+        check(c->readUploadedMesh() == fresh, "the patched mesh is the same as a new one");
+        c->releaseGraphics();
+    }
+    check(patched > 0, "the edit was sent as a patch");
+}
+
+// ==========================
+//
+//     Building Batches
+//
+// ==========================
+
+static void setUpBuildingView()
+{
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(-100, 100, -100, 100, -500, 500);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glRotatef(60, 1, 0, 0);
+}
+
+// A turned prism drawn as an instance has to cover the same pixels as its
+// faces drawn one by one
+static void testRotatedBuildingBatch()
+{
+    OffscreenContext context;
+    if(!context.create(200, 200) || !glFuncs.hasInstancing)
+    {
+        std::cout << "No instancing here, so the building batch isn't checked" << std::endl;
+        return;
+    }
+    RecPrism prism({10, 0, -5}, {1, 0, 0, 1}, 80, 40, 30, {1, 1, 1, 1}, NoLines);
+    prism.rotate(0, 0.6, 0);
+
+    setUpBuildingView();
+    setGLColor(prism.getColor());
+    glBegin(GL_QUADS);
+    for(const Point &p : prism.getFaces())
+    {
+        drawPoint(p);
+    }
+    glEnd();
+    Screenshot oneByOne = captureScreenshot(200, 200);
+
+    setUpBuildingView();
+    SolidStore store;
+    store.addRecPrism(prism);
+    BuildingBatch batch;
+    batch.build(store);
+    batch.draw();
+    batch.release();
+    BuildingBatch::releaseShared();
+    Screenshot instanced = captureScreenshot(200, 200);
+
+    check(countDifferentPixels(oneByOne, instanced, 10) == 0, "a turned building is drawn turned");
+}
+
+// ==========================
+//
+//      Height Queries
+//
+// ==========================
+
+// getHeightsAt() does two points at a time with SSE2 and any last one by itself,
+// and has to give the same heights as getHeightAt() one point at a time. Points
+// on the diagonal of a square, between its two triangles, are the easiest to
+// get wrong.
+static void testHeightsAtMatchHeightAt()
+{
+    World world(3, 30, 3);
+    world.finishChunkJobs();
+    std::shared_ptr<Chunk> c = world.getChunk(point2DtoChunkID({0, -1}));
+    check(c != nullptr, "the chunk to get heights from was made");
+    if(!c)
+    {
+        return;
+    }
+    double left = c->getTopLeft().x*c->getSideLength(), top = c->getTopLeft().z*c->getSideLength();
+    int squaresPerSide = c->getPointsPerSide() - 1;
+    double squareSize = c->getSideLength() / (double)squaresPerSide;
+    RandomNumberGenerator rng(5);
+    std::vector<double> xs, zs;
+    for(int k = 0; k < 50; k++)
+    {
+        xs.push_back(left + rng.getRandom()*c->getSideLength());
+        zs.push_back(top + rng.getRandom()*c->getSideLength());
+    }
+    // u + v == squareSize, from one corner of the square to the other
+    for(int k = 0; k < squaresPerSide; k++)
+    {
+        double u = rng.getRandom()*squareSize;
+        xs.push_back(left + k*squareSize + u);
+        zs.push_back(top + (squaresPerSide - 1 - k)*squareSize + (squareSize - u));
+    }
+    check(xs.size() % 2 == 1, "the last point is done by itself");
+
+    std::vector<double> heights(xs.size());
+    c->getHeightsAt(xs.data(), zs.data(), heights.data(), xs.size());
+    bool same = true;
+    for(int k = 0; k < (int)xs.size(); k++)
+    {
+        same = same && fabs(heights[k] - c->getHeightAt({xs[k], 0, zs[k]})) < 1e-9;
+    }
+    check(same, "getHeightsAt gives the same heights as getHeightAt");
+}
+
+// Whether every entry of the height pyramid is between the min and max of the
+// corners of the terrain squares under it
+static bool pyramidContainsHeights(const ChunkHeights &heights)
+{
+    const HeightPyramid &pyramid = heights.heightPyramid;
+    const SharedRows<Point> &terrainPoints = heights.terrainPoints;
+    int squaresPerSide = pyramid.getLevelSize(0);
+    for(int level = 0; level < pyramid.getNumLevels(); level++)
+    {
+        int span = 1 << level;
+        for(int i = 0; i < pyramid.getLevelSize(level); i++)
+        {
+            for(int j = 0; j < pyramid.getLevelSize(level); j++)
+            {
+                double minHeight = pyramid.getMin(level, i, j), maxHeight = pyramid.getMax(level, i, j);
+                for(int si = i*span; si <= std::min((i + 1)*span, squaresPerSide); si++)
+                {
+                    for(int sj = j*span; sj <= std::min((j + 1)*span, squaresPerSide); sj++)
+                    {
+                        double y = terrainPoints[si][sj].y;
+                        if(y < minHeight || y > maxHeight)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// The pyramid has to hold the heights under it when it's built, and after
+// edits that only update part of it, both raising and digging
+static void testHeightPyramidBounds()
+{
+    World world(3, 30, 3);
+    world.finishChunkJobs();
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    for(int x = -1; x <= 0; x++)
+    {
+        for(int z = -2; z <= -1; z++)
+        {
+            std::shared_ptr<Chunk> c = world.getChunk(point2DtoChunkID({x, z}));
+            check(c != nullptr, "the chunks around the corner were made");
+            if(!c)
+            {
+                return;
+            }
+            chunks.push_back(c);
+        }
+    }
+    bool contains = true;
+    for(const std::shared_ptr<Chunk> &c : chunks)
+    {
+        contains = contains && pyramidContainsHeights(*c->getCurrentVersion()->heights);
+    }
+    check(contains, "the height pyramids hold the heights of new chunks");
+
+    world.deformTerrain({0, -512, 150, Raise, 60, 0});
+    world.deformTerrain({-100, -450, 80, Dig, 120, 0});
+    contains = true;
+    for(const std::shared_ptr<Chunk> &c : chunks)
+    {
+        contains = contains && pyramidContainsHeights(*c->getCurrentVersion()->heights);
+    }
+    check(contains, "the height pyramids hold the heights after edits");
+}
+
+// ==========================
+//
+//        Raycasting
+//
+// ==========================
+
+// Rays straight down have to land on the terrain at the height getHeightAt()
+// gives, and a building between two points has to block the line between them.
+// In this world the chunk at (1, -2) has a city and the chunk at (0, -1) doesn't.
+static void testRaycasting()
+{
+    World world(3, 30, 3);
+    world.finishChunkJobs();
+    std::shared_ptr<Chunk> ground = world.getChunk(point2DtoChunkID({0, -1}));
+    std::shared_ptr<Chunk> city = world.getChunk(point2DtoChunkID({1, -2}));
+    check(ground != nullptr && city != nullptr, "the chunks to cast rays at were made");
+    if(!ground || !city)
+    {
+        return;
+    }
+
+    std::vector<Ray> rays;
+    for(Point2D p : {Point2D{100, -300}, Point2D{257, -42}, Point2D{480, -500}, Point2D{3, -509}})
+    {
+        rays.push_back({{(double)p.x, 5000, (double)p.z}, {0, -1, 0}, 10000});
+    }
+    std::vector<std::experimental::optional<RayHit>> hits = world.castRays(rays);
+    check(hits.size() == rays.size(), "castRays gives a hit or nothing for every ray");
+    for(int k = 0; k < (int)rays.size() && k < (int)hits.size(); k++)
+    {
+        std::experimental::optional<RayHit> hit = world.castRay(rays[k]);
+        check(hit && hits[k], "a ray straight down hits the terrain");
+        if(!hit || !hits[k])
+        {
+            continue;
+        }
+        check(hit->location.y == hits[k]->location.y && hit->chunkID == hits[k]->chunkID,
+              "castRays hits where castRay does");
+        check(hit->chunkID == point2DtoChunkID({0, -1}) && !hit->building, "the ray hits the chunk under it");
+        double height = ground->getHeightAt(rays[k].origin);
+        check(fabs(hit->location.y - height) < 1e-6, "a ray straight down hits at the terrain's height");
+        check(fabs(hit->distance - (rays[k].origin.y - height)) < 1e-6, "the hit's distance is along the ray");
+    }
+    check(!world.castRay({{100, 5000, -300}, {0, -1, 0}, 100}), "a ray that ends above the terrain hits nothing");
+
+    city->ensureBuildings();
+    std::shared_ptr<const ChunkVersion> v = city->getCurrentVersion();
+    check(v->buildings && !v->buildings->buildings.empty(), "the city has buildings");
+    if(!v->buildings || v->buildings->buildings.empty())
+    {
+        return;
+    }
+    std::shared_ptr<Building> building = v->buildings->buildings[0];
+    Point center = building->getCenter();
+    Point above = {center.x, 5000, center.z};
+    std::experimental::optional<RayHit> roof = world.castRay({above, {0, -1, 0}, 10000});
+    check(roof && roof->building, "a ray down onto a building hits it");
+    check(!world.hasLineOfSight(above, center), "a building blocks the line of sight through it");
+    check(world.hasLineOfSight(above, {center.x + 100, 4000, center.z}), "nothing blocks a line above the city");
+}
+
+// ==========================
+//
+//        Collisions
+//
+// ==========================
+
+// Lets a check put the player anywhere
+class CollisionWorld : public World
+{
+public:
+    CollisionWorld(int renderRadius, int pointsPerChunk, int seed) : World(renderRadius, pointsPerChunk, seed)
+    {
+    }
+    void movePlayerTo(Point p)
+    {
+        player.setLocation(p);
+    }
+};
+
+// A player put inside a building has to be pushed out of it, and not into
+// another one. In this world the chunk at (1, -2) has a city.
+static void testPlayerPushedOutOfBuilding()
+{
+    CollisionWorld world(3, 30, 3);
+    world.finishChunkJobs();
+    std::shared_ptr<Chunk> city = world.getChunk(point2DtoChunkID({1, -2}));
+    check(city != nullptr, "the city chunk was made");
+    if(!city)
+    {
+        return;
+    }
+    city->ensureBuildings();
+    std::shared_ptr<const ChunkVersion> v = city->getCurrentVersion();
+    check(v->buildings && !v->buildings->buildings.empty(), "the city has buildings");
+    if(!v->buildings || v->buildings->buildings.empty())
+    {
+        return;
+    }
+    Point center = v->buildings->buildings[0]->getCenter();
+    double radius = world.getPlayer().getRadius();
+    check((bool)v->buildings->buildings[0]->correctCollision(center, radius), "the player starts inside the building");
+
+    world.movePlayerTo(center);
+    world.correctPlayerCollisions();
+    Point p = world.getPlayer().getLocation();
+    check(p.x != center.x || p.z != center.z, "the player was moved");
+    bool outside = true;
+    for(const std::shared_ptr<Building> &b : city->getBuildingsNear(p, radius))
+    {
+        // A little less than the player's radius, since they end up right at it
+        outside = outside && !b->correctCollision(p, radius - 1);
+    }
+    check(outside, "the player is pushed outside of the buildings");
+}
+
+// ==========================
+//
+//        Pathfinding
+//
+// ==========================
+
+// Whether the pathfinder can walk on the terrain square under the point:
+// it isn't water, and neither of its triangles is a cliff
+static bool isWalkable(const World &world, Point p)
+{
+    std::shared_ptr<Chunk> c = world.getChunk(getChunkIDContainingPoint(p, CHUNK_SIZE));
+    if(!c)
+    {
+        return false;
+    }
+    c->ensureRenderReady();
+    std::shared_ptr<const ChunkVersion> v = c->getCurrentVersion();
+    double squareSize = c->getSideLength() / (c->getPointsPerSide() - 1.0);
+    int i = floor((p.x - c->getTopLeft().x*c->getSideLength()) / squareSize);
+    int j = floor((p.z - c->getTopLeft().z*c->getSideLength()) / squareSize);
+    Point upper = v->physics->upperNormals[i][j], lower = v->physics->lowerNormals[i][j];
+    double normalY = fmin(fabs(upper.y) / sqrt(dotProduct(upper, upper)), fabs(lower.y) / sqrt(dotProduct(lower, lower)));
+    return !v->surface->drawWaterAt[i][j] && normalY >= Pathfinder().MIN_NORMAL_Y;
+}
+
+// A path between two dry points in different chunks has to step from square
+// to neighboring square without walking on water or cliffs. A point on an
+// island has no path to it. In this world the ground west of (-512, 0) is dry,
+// and there is no island, so one is made by digging a moat.
+static void testFindPath()
+{
+    World world(3, 30, 3);
+    world.finishChunkJobs();
+
+    Point start = {-1080, 0, 300}, goal = {-700, 0, 100};
+    check(isWalkable(world, start) && isWalkable(world, goal), "the ends of the path are dry");
+    double squareSize = CHUNK_SIZE / (world.getChunk(getChunkIDContainingPoint(goal, CHUNK_SIZE))->getPointsPerSide() - 1.0);
+    std::vector<Point> path = world.findPath(start, goal);
+    check(!path.empty(), "there is a path between two dry points");
+    if(!path.empty())
+    {
+        check(path.front().x == start.x && path.front().z == start.z && path.back().x == goal.x &&
+              path.back().z == goal.z, "the path goes from the start to the goal");
+    }
+    bool walkable = true, neighboring = true;
+    for(int k = 0; k < (int)path.size(); k++)
+    {
+        walkable = walkable && isWalkable(world, path[k]);
+        // Points in neighboring squares, or the ends, which can be anywhere in theirs
+        if(k > 0)
+        {
+            double limit = (k == 1 || k + 1 == (int)path.size() ? 2 : 1) * squareSize * sqrt(2) + 1e-9;
+            neighboring = neighboring && distance2d(path[k - 1], path[k]) <= limit;
+        }
+    }
+    check(walkable, "the path doesn't walk on water or cliffs");
+    check(neighboring, "the path only steps to neighboring squares");
+
+    Point island = {-650, 0, 150};
+    check(!world.findPath(start, island).empty(), "there is a path to the island before the moat is dug");
+    for(int k = 0; k < 24; k++)
+    {
+        double angle = 2*PI*k / 24;
+        world.deformTerrain({island.x + 110*cos(angle), island.z + 110*sin(angle), 40, Dig, 200, 0});
+    }
+    check(isWalkable(world, island), "the island is dry");
+    check(!isWalkable(world, {island.x + 110, 0, island.z}), "the moat is water");
+    check(world.findPath(start, island).empty(), "there is no path onto an island");
+}
+
+// ==========================
+//
+//   Recording and Replaying
+//
+// ==========================
+
+// The terrain heights on a grid around the player, NAN where no chunk was made
+static std::vector<double> getHeightsAroundPlayer(const World &world)
+{
+    std::vector<double> xs, zs;
+    Point center = world.getPlayer().getLocation();
+    for(int i = -40; i <= 40; i++)
+    {
+        for(int j = -40; j <= 40; j++)
+        {
+            xs.push_back(center.x + 25*i);
+            zs.push_back(center.z + 25*j);
+        }
+    }
+    std::vector<double> heights(xs.size());
+    world.getTerrainHeightsAt(xs.data(), zs.data(), heights.data(), xs.size());
+    return heights;
+}
+static bool sameHeights(const std::vector<double> &a, const std::vector<double> &b)
+{
+    if(a.size() != b.size())
+    {
+        return false;
+    }
+    for(int i = 0; i < (int)a.size(); i++)
+    {
+        if(a[i] != b[i] && !(std::isnan(a[i]) && std::isnan(b[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run into new chunks at hyper speed and edit the terrain while recording, then
+// play the recording back as fast as it goes. The player has to end up in the
+// same place, with the same terrain made around them.
+static void testReplayMatchesRecording()
+{
+    std::string path = "replayTest.rtil";
+    Point recordedLocation;
+    std::vector<double> recordedHeights;
+    {
+        GameManager manager(1024, 512, 3, 30, 5);
+        manager.setNumChunkThreads(2); // like the game, which the recording has to undo
+        Simulation simulation(manager);
+        check(simulation.startRecording(path), "the recording can be written");
+        simulation.start();
+        simulation.queueInput(GameInput::mouseClick(512, 256)); // the play button
+        simulation.queueInput(GameInput::keyChange(WKey, true));
+        simulation.queueInput(GameInput::keyChange(HyperSpeedKey, true));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        simulation.queueInput(GameInput::deform(Raise));
+        simulation.queueInput(GameInput::keyChange(AKey, true));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        simulation.queueInput(GameInput::deform(Dig));
+        simulation.queueInput(GameInput::keyChange(SpacebarKey, true));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        simulation.stop();
+        check(manager.getCurrentStatus() == Playing, "the recorded game was played");
+        recordedLocation = manager.getPlayer().getLocation();
+        recordedHeights = getHeightsAroundPlayer(manager);
+    }
+
+    InputLog log;
+    check(log.read(path), "the recording can be read");
+    GameManager manager(1024, 512, 3, 30, log.getWorldSeed());
+    manager.setNumChunkThreads(2);
+    Simulation simulation(manager);
+    simulation.setReplay(log, false);
+    simulation.start();
+    while(!simulation.isReplayDone())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    simulation.stop();
+    Point location = manager.getPlayer().getLocation();
+    check(location.x == recordedLocation.x && location.y == recordedLocation.y && location.z == recordedLocation.z,
+          "the replayed player ends where the recorded one did");
+    check(sameHeights(getHeightsAroundPlayer(manager), recordedHeights), "the replay made the same terrain");
+    std::remove(path.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+    testDeformAcrossSeam();
+    testRotatedBuildingBatch();
+    testHeightsAtMatchHeightAt();
+    testHeightPyramidBounds();
+    testRaycasting();
+    testPlayerPushedOutOfBuilding();
+    testFindPath();
+    testReplayMatchesRecording();
+    if(failures == 0)
+    {
+        std::cout << "All checks passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
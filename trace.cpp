@@ -0,0 +1,154 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> tracingEnabled(false);
+
+const static int EVENTS_PER_THREAD = 1 << 16;
+
+// The fields are atomic so writeTrace can read them while the thread writes
+struct TraceEvent
+{
+    std::atomic<const char*> name;
+    std::atomic<int64_t> start;
+    std::atomic<int64_t> duration;
+};
+
+// One thread's newest events. Only that thread writes to it.
+struct TraceBuffer
+{
+    int threadID;
+    std::string threadName; // guarded by registryMutex
+    std::unique_ptr<TraceEvent[]> events;
+    // How many events have ever been recorded. Event i is in events[i % EVENTS_PER_THREAD].
+    std::atomic<uint64_t> count;
+    // How many have been started. It goes up before an event's slot is written
+    // over, so a copy can tell which events it may have read half written.
+    std::atomic<uint64_t> started;
+};
+
+// Buffers are kept after their threads end, so their events can still be written
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+static thread_local TraceBuffer *threadBuffer = nullptr;
+static thread_local std::string threadName;
+static const std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+
+// Made the first time the thread records something, so threads that never
+// record while tracing is on don't get a buffer
+static TraceBuffer *getThreadBuffer()
+{
+    if(threadBuffer == nullptr)
+    {
+        std::unique_ptr<TraceBuffer> b(new TraceBuffer());
+        b->events.reset(new TraceEvent[EVENTS_PER_THREAD]);
+        b->count = 0;
+        b->started = 0;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        b->threadID = buffers.size() + 1;
+        b->threadName = threadName.empty() ? "thread " + std::to_string(b->threadID) : threadName;
+        threadBuffer = b.get();
+        buffers.push_back(std::move(b));
+    }
+    return threadBuffer;
+}
+
+void startTracing()
+{
+    tracingEnabled = true;
+}
+void stopTracing()
+{
+    tracingEnabled = false;
+}
+
+int64_t getTraceTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+void recordTraceEvent(const char *name, int64_t start, int64_t duration)
+{
+    TraceBuffer *b = getThreadBuffer();
+    uint64_t n = b->count.load(std::memory_order_relaxed);
+    TraceEvent &e = b->events[n % EVENTS_PER_THREAD];
+    // The fence keeps the slot's stores from being seen before started is
+    b->started.store(n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.name.store(name, std::memory_order_relaxed);
+    e.start.store(start, std::memory_order_relaxed);
+    e.duration.store(duration, std::memory_order_relaxed);
+    b->count.store(n + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const std::string &name)
+{
+    threadName = name;
+    if(threadBuffer != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        threadBuffer->threadName = name;
+    }
+}
+
+struct CopiedEvent
+{
+    const char *name;
+    int64_t start;
+    int64_t duration;
+};
+
+// The events still in the buffer, oldest first
+static std::vector<CopiedEvent> copyEvents(const TraceBuffer &b)
+{
+    uint64_t end = b.count.load(std::memory_order_acquire);
+    uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+    std::vector<CopiedEvent> copied;
+    copied.reserve(end - begin);
+    for(uint64_t i = begin; i < end; i++)
+    {
+        const TraceEvent &e = b.events[i % EVENTS_PER_THREAD];
+        copied.push_back({e.name.load(std::memory_order_relaxed), e.start.load(std::memory_order_relaxed),
+                          e.duration.load(std::memory_order_relaxed)});
+    }
+    // The thread may have kept recording, writing over the oldest ones while
+    // they were copied. If a copy read anything it wrote, the fence makes
+    // started show that event.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = b.started.load(std::memory_order_relaxed);
+    uint64_t firstIntact = after > EVENTS_PER_THREAD ? after - EVENTS_PER_THREAD : 0;
+    if(firstIntact > begin)
+    {
+        copied.erase(copied.begin(), copied.begin() + std::min<uint64_t>(firstIntact - begin, copied.size()));
+    }
+    return copied;
+}
+
+bool writeTrace(const std::string &path)
+{
+    std::ofstream out(path);
+    out << "{\"traceEvents\": [\n";
+    bool first = true;
+    char line[256];
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(const std::unique_ptr<TraceBuffer> &b : buffers)
+    {
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << b->threadID << ", \"args\": {\"name\": \"" << b->threadName << "\"}}";
+        first = false;
+        for(const CopiedEvent &e : copyEvents(*b))
+        {
+            snprintf(line, sizeof(line),
+                     ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                     e.name, b->threadID, e.start / 1000.0, e.duration / 1000.0);
+            out << line;
+        }
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
@@ -0,0 +1,69 @@
+#ifndef RANDOM_TERRAIN_TRACE_H
+#define RANDOM_TERRAIN_TRACE_H
+
+// Scoped timing markers, written out in the Chrome trace format so a run can be
+// looked at in chrome://tracing or Perfetto. Put TRACE_SCOPE("name") at the top
+// of a block to record how long the block took on the current thread.
+//
+// Each thread records into its own ring buffer of the newest events, so threads
+// never wait on each other and old events are overwritten instead of growing
+// without bound. While tracing is off, a marker only checks a flag. Defining
+// RANDOM_TERRAIN_NO_TRACE takes the markers out entirely.
+//
+// Names have to be string literals (or otherwise live forever), since only
+// the pointer is kept.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+extern std::atomic<bool> tracingEnabled;
+
+inline bool isTracing()
+{
+    return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+void startTracing();
+void stopTracing();
+
+// Nanoseconds since the program started
+int64_t getTraceTime();
+void recordTraceEvent(const char *name, int64_t start, int64_t duration);
+
+// Shown as the thread's name in the trace
+void setTraceThreadName(const std::string &name);
+
+// Write every thread's events that are still in its buffer. Tracing can be on.
+// Returns false if the file can't be written.
+bool writeTrace(const std::string &path);
+
+class TraceScope
+{
+private:
+    const char *name;
+    int64_t start; // negative if tracing was off when the scope began
+public:
+    explicit TraceScope(const char *inputName) : name(inputName), start(isTracing() ? getTraceTime() : -1)
+    {
+    }
+    ~TraceScope()
+    {
+        if(start >= 0)
+        {
+            recordTraceEvent(name, start, getTraceTime() - start);
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#ifdef RANDOM_TERRAIN_NO_TRACE
+#define TRACE_SCOPE(name)
+#else
+#define TRACE_SCOPE_JOIN2(a, b) a##b
+#define TRACE_SCOPE_JOIN(a, b) TRACE_SCOPE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_SCOPE_JOIN(traceScope, __LINE__)(name)
+#endif
+
+#endif //RANDOM_TERRAIN_TRACE_H
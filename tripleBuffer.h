@@ -0,0 +1,57 @@
+#ifndef RANDOM_TERRAIN_TRIPLEBUFFER_H
+#define RANDOM_TERRAIN_TRIPLEBUFFER_H
+
+// Passes the newest value of something from one writing thread to one reading
+// thread without either of them waiting. The writer fills in one buffer while the
+// reader uses another, and the third holds the newest finished value. Publishing
+// and picking up the newest value are each a single atomic exchange.
+
+#include <atomic>
+
+template <class T>
+class TripleBuffer
+{
+private:
+    T buffers[3];
+    // Which buffer holds the newest finished value, with NEW_BIT set
+    // if the reader hasn't picked it up yet
+    std::atomic<int> middleIndex;
+    int writeIndex; // only used by the writer
+    int readIndex;  // only used by the reader
+
+    const static int NEW_BIT = 4;
+public:
+    TripleBuffer() : middleIndex(1), writeIndex(0), readIndex(2)
+    {
+    }
+
+    // The buffer the writer fills in. It is kept between publishes, so the
+    // writer can reuse what it allocated last time.
+    T &getWriteBuffer()
+    {
+        return buffers[writeIndex];
+    }
+    // Make the write buffer the newest value and get a different one to write into
+    void publish()
+    {
+        writeIndex = middleIndex.exchange(writeIndex | NEW_BIT) & ~NEW_BIT;
+    }
+
+    // Pick up the newest value, if there is one since the last call.
+    // Returns false if the read buffer didn't change.
+    bool update()
+    {
+        if(!(middleIndex.load() & NEW_BIT))
+        {
+            return false;
+        }
+        readIndex = middleIndex.exchange(readIndex) & ~NEW_BIT;
+        return true;
+    }
+    const T &getReadBuffer() const
+    {
+        return buffers[readIndex];
+    }
+};
+
+#endif //RANDOM_TERRAIN_TRIPLEBUFFER_H
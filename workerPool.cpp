@@ -0,0 +1,89 @@
+#include "workerPool.h"
+
+WorkerPool::WorkerPool()
+{
+    task = nullptr;
+    numTasks = 0;
+    nextTask = 0;
+    unfinished = 0;
+    running = false;
+}
+WorkerPool::~WorkerPool()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopWorkers(lock);
+}
+
+void WorkerPool::setNumThreads(int numThreads)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopWorkers(lock);
+    running = true;
+    for(int i = 0; i < numThreads; i++)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+int WorkerPool::getNumThreads() const
+{
+    return workers.size();
+}
+void WorkerPool::stopWorkers(std::unique_lock<std::mutex> &lock)
+{
+    running = false;
+    workReady.notify_all();
+    lock.unlock();
+    for(std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    lock.lock();
+    workers.clear();
+}
+
+void WorkerPool::run(int count, const TaskFunction &inputTask)
+{
+    if(count <= 0)
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    task = &inputTask;
+    numTasks = count;
+    nextTask = 0;
+    unfinished = count;
+    workReady.notify_all();
+    runTasks(lock);
+    batchDone.wait(lock, [this] { return unfinished == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::runTasks(std::unique_lock<std::mutex> &lock)
+{
+    while(task != nullptr && nextTask < numTasks)
+    {
+        int index = nextTask++;
+        const TaskFunction &f = *task;
+        lock.unlock();
+        f(index);
+        lock.lock();
+        if(--unfinished == 0)
+        {
+            batchDone.notify_all();
+        }
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(running)
+    {
+        if(task == nullptr || nextTask >= numTasks)
+        {
+            workReady.wait(lock);
+            continue;
+        }
+        runTasks(lock);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef RANDOM_TERRAIN_WORKERPOOL_H
+#define RANDOM_TERRAIN_WORKERPOOL_H
+
+// Threads that stay alive between batches of work, so splitting a short piece
+// of work across threads every tick doesn't pay for making and joining them.
+// The thread that calls run() works on the batch too.
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+    // Does task number index. Called from several threads at once.
+    typedef std::function<void(int index)> TaskFunction;
+private:
+    // Everything below is guarded by mutex
+    std::mutex mutex;
+    std::condition_variable workReady; // a batch started, or the workers are stopping
+    std::condition_variable batchDone;
+    const TaskFunction *task; // the batch being run, or nullptr between batches
+    int numTasks;
+    int nextTask;   // the next one to hand out
+    int unfinished; // handed out or not, but not done yet
+    std::vector<std::thread> workers;
+    bool running;
+
+    // Do tasks from the current batch until none are left to hand out,
+    // with the lock held on entry and exit
+    void runTasks(std::unique_lock<std::mutex> &lock);
+    void workerLoop();
+    void stopWorkers(std::unique_lock<std::mutex> &lock);
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    // The workers and the lock belong to one pool
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Threads besides the one calling run(). 0 runs every task on that thread.
+    void setNumThreads(int numThreads);
+    int getNumThreads() const;
+
+    // Call task(i) for every i from 0 to count-1, and return once they are all done.
+    // Only one thread can call this at a time.
+    void run(int count, const TaskFunction &inputTask);
+};
+
+#endif //RANDOM_TERRAIN_WORKERPOOL_H
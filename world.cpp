@@ -0,0 +1,840 @@
+#include "world.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+World::World()
+{
+    renderRadius = 5;
+    buildingRadius = BUILDING_RADIUS;
+    colorVersion = 0;
+    firstEditNumber = 0;
+    initializeWorldSeed(-1);
+    pathfinder = Pathfinder(CHUNK_SIZE);
+    curColorScheme = Plain;
+    currentStatus = Intro;
+    wKey = false;
+    aKey = false;
+    sKey = false;
+    dKey = false;
+    spacebar = false;
+    hyperSpeed = false;
+
+    updateColorScheme(Plain);
+    initializePlayer();
+    initializeAgents();
+    initializeChunkScheduler();
+    updateCurrentChunks();
+}
+World::World(int inputRenderRadius, int inputPointsPerChunk, int inputWorldSeed)
+{
+    renderRadius = inputRenderRadius;
+    POINTS_PER_CHUNK = inputPointsPerChunk;
+    buildingRadius = BUILDING_RADIUS;
+    colorVersion = 0;
+    firstEditNumber = 0;
+    initializeWorldSeed(inputWorldSeed);
+    pathfinder = Pathfinder(CHUNK_SIZE);
+    curColorScheme = Plain;
+    currentStatus = Intro;
+    wKey = false;
+    aKey = false;
+    sKey = false;
+    dKey = false;
+    spacebar = false;
+    hyperSpeed = false;
+
+    updateColorScheme(Plain);
+    initializePlayer();
+    initializeAgents();
+    initializeChunkScheduler();
+    updateCurrentChunks();
+}
+World::~World()
+{
+    chunkScheduler.setNumThreads(0);
+}
+
+// =================================
+//
+//     Initialization Functions
+//
+// =================================
+
+void World::initializeWorldSeed(int inputWorldSeed)
+{
+    worldSeed = inputWorldSeed;
+    if(worldSeed < 0)
+    {
+        RandomNumberGenerator rng;
+        worldSeed = static_cast<int>(rng.getRandom() * rng.modulus);
+    }
+    RandomNumberGenerator rng(worldSeed);
+    chunkSeeds = PerlinNoiseGenerator(rng, PERLIN_SEED_SIZE, PERLIN_SEED_SIZE, 0.2);
+}
+
+void World::initializePlayer()
+{
+    Point playerStartLoc = {0, PLAYER_HEIGHT/2, 0};
+    Point playerStartLook = {0, PLAYER_HEIGHT/2, -10};
+    Point playerStartUp = {0, PLAYER_HEIGHT, 0};
+    player = Player(playerStartLoc, playerStartLook, playerStartUp, PLAYER_SPEED, MOUSE_SENSITIVITY,
+                    PLAYER_HEIGHT, PLAYER_RADIUS, MAX_DISTANCE_FROM_SPAWN, GRAVITY, PLAYER_JUMP_AMOUNT);
+    currentPlayerChunkID = getChunkIDContainingPoint(player.getLocation(), CHUNK_SIZE);
+    previousPlayerLocation = player.getLocation();
+    tickAccumulator = 0;
+}
+
+void World::initializeAgents()
+{
+    agents = AgentStore(PLAYER_HEIGHT, GRAVITY, PLAYER_JUMP_AMOUNT, MAX_DISTANCE_FROM_SPAWN);
+    agentWorkers.setNumThreads(std::max(1, (int)std::thread::hardware_concurrency()) - 1);
+}
+
+void World::initializeChunkScheduler()
+{
+    chunkScheduler.setFunctions([this](ChunkJob &job) { runChunkJobStep(job); },
+                                [this](ChunkJob &job) { publishChunkJob(job); },
+                                [this](int chunkID) { return allSeenChunks.contains(chunkID); });
+    chunkMillisecondsPerUpdate = CHUNK_MILLISECONDS_PER_UPDATE;
+    chunkStepsPerUpdate = 0;
+    lastChunkMilliseconds = 0;
+}
+
+// ===========================
+//
+//          Getters
+//
+// ===========================
+
+Player World::getPlayer() const
+{
+    return player;
+}
+const AgentStore &World::getAgents() const
+{
+    return agents;
+}
+bool World::getWKey() const
+{
+    return wKey;
+}
+bool World::getAKey() const
+{
+    return aKey;
+}
+bool World::getSKey() const
+{
+    return sKey;
+}
+bool World::getDKey() const
+{
+    return dKey;
+}
+bool World::getSpacebar() const
+{
+    return spacebar;
+}
+GameStatus World::getCurrentStatus() const
+{
+    return currentStatus;
+}
+double World::getTickMilliseconds() const
+{
+    return TICK_MILLISECONDS;
+}
+int World::getCurrentPlayerChunkID() const
+{
+    return currentPlayerChunkID;
+}
+int World::getWorldSeed() const
+{
+    return worldSeed;
+}
+double World::getLastChunkMilliseconds() const
+{
+    return lastChunkMilliseconds;
+}
+
+// =============================
+//
+//           Setters
+//
+// =============================
+void World::setWKey(bool input)
+{
+    wKey = input;
+    player.setVelocity(wKey, aKey, sKey, dKey);
+}
+void World::setAKey(bool input)
+{
+    aKey = input;
+    player.setVelocity(wKey, aKey, sKey, dKey);
+}
+void World::setSKey(bool input)
+{
+    sKey = input;
+    player.setVelocity(wKey, aKey, sKey, dKey);
+}
+void World::setDKey(bool input)
+{
+    dKey = input;
+    player.setVelocity(wKey, aKey, sKey, dKey);
+}
+void World::setSpacebar(bool input)
+{
+    spacebar = input;
+}
+void World::setHyperSpeed(bool input)
+{
+    hyperSpeed = input;
+}
+void World::setCurrentStatus(GameStatus input)
+{
+    currentStatus = input;
+}
+void World::setPlayerAngles(double xzAngle, double yAngle)
+{
+    player.setXZAngle(xzAngle);
+    player.setYAngle(yAngle);
+    player.updateSphericalDirectionBasedOnAngles();
+    player.setVelocity(wKey, aKey, sKey, dKey);
+}
+void World::setBuildingRadius(int input)
+{
+    buildingRadius = input;
+    updateChunkBuildings(currentChunks);
+}
+void World::setNumAgentThreads(int input)
+{
+    agentWorkers.setNumThreads(std::max(1, input) - 1);
+}
+void World::setChunkMillisecondsPerUpdate(double input)
+{
+    chunkMillisecondsPerUpdate = input;
+}
+void World::setChunkStepsPerUpdate(int input)
+{
+    chunkStepsPerUpdate = input;
+}
+void World::setNumChunkThreads(int input)
+{
+    chunkScheduler.setNumThreads(input);
+}
+
+// =============================
+//
+//           Chunks
+//
+// ============================
+void World::updateCurrentChunks()
+{
+    TRACE_SCOPE("updateCurrentChunks");
+    // Update the list of current chunks
+    std::vector<std::shared_ptr<Chunk>> previousChunks = currentChunks;
+    currentChunks = std::vector<std::shared_ptr<Chunk>>();
+    std::vector<Point2D> chunksInRadius = getChunkTopLeftCornersAroundPoint(currentPlayerChunkID, renderRadius);
+    // Drop the jobs for chunks the player has left behind, and put the closest ones first
+    chunkScheduler.setFocus(chunkIDtoPoint2D(currentPlayerChunkID), renderRadius);
+    for(Point2D p : chunksInRadius)
+    {
+        int index = point2DtoChunkID(p);
+        std::shared_ptr<Chunk> c = allSeenChunks.find(index);
+        if(!c) // if the chunk has never been seen before
+        {
+            // It gets added to the current chunks once it's made
+            chunkScheduler.addJob(index, p);
+        }
+        else
+        {
+            currentChunks.push_back(c);
+        }
+    }
+    // The player has to stand on something
+    chunkScheduler.finishJob(currentPlayerChunkID);
+    updateChunkBuildings(previousChunks);
+}
+void World::runChunkJobStep(ChunkJob &job)
+{
+    // Indexed by ChunkJobStep
+    static const char *const stepNames[] = {"chunk stitch", "chunk noise", "chunk create", "chunk physics",
+                                            "chunk classify", "chunk mesh", "chunk buildings", "chunk done"};
+    TRACE_SCOPE(stepNames[job.step]);
+    int index = job.chunkID;
+    switch(job.step)
+    {
+        case Stitch:
+        {
+            // The borders and the edit count have to match, so no edit can
+            // happen in between
+            std::lock_guard<std::mutex> lock(chunkInputsMutex);
+            // Get the borders to make sure the terrain is seamless
+            job.relativeHeightsAbove = getTerrainHeightsAbove(index, true);
+            job.relativeHeightsBelow = getTerrainHeightsBelow(index, true);
+            job.relativeHeightsLeft = getTerrainHeightsLeft(index, true);
+            job.relativeHeightsRight = getTerrainHeightsRight(index, true);
+            job.absoluteHeightsAbove = getTerrainHeightsAbove(index, false);
+            job.absoluteHeightsBelow = getTerrainHeightsBelow(index, false);
+            job.absoluteHeightsLeft = getTerrainHeightsLeft(index, false);
+            job.absoluteHeightsRight = getTerrainHeightsRight(index, false);
+            job.snowColor = snowColor;
+            job.rockColor = rockColor;
+            job.grassColor = grassColor;
+            job.sandColor = sandColor;
+            job.waterColor = waterColor;
+            job.colorVersion = colorVersion;
+            job.editCount = firstEditNumber + terrainEdits.size();
+            break;
+        }
+        case Noise:
+        {
+            // Make a generator for this chunk specifically
+            RandomNumberGenerator rng(getChunkSeed(index));
+            PerlinNoiseGenerator png = PerlinNoiseGenerator(rng, POINTS_PER_CHUNK, POINTS_PER_CHUNK, 1,
+                                                            job.relativeHeightsAbove, job.relativeHeightsBelow,
+                                                            job.relativeHeightsLeft, job.relativeHeightsRight);
+            // Scale the noise
+            job.noise = png.getScaledNoiseApplyBorders(0,1,
+                                                       job.relativeHeightsAbove, job.relativeHeightsBelow,
+                                                       job.relativeHeightsLeft, job.relativeHeightsRight);
+            job.hasCity = rng.getRandom() < 0.05;
+            job.buildingSeed = static_cast<int>(rng.getRandom() * rng.modulus);
+            break;
+        }
+        case Create:
+            job.chunk = std::make_shared<Chunk>(job.topLeft, CHUNK_SIZE, POINTS_PER_CHUNK, job.noise,
+                    TERRAIN_HEIGHT_FACTOR, getPerlinValue(job.topLeft), job.absoluteHeightsAbove, job.absoluteHeightsBelow,
+                                                job.absoluteHeightsLeft, job.absoluteHeightsRight,
+                                                SNOW_LIMIT, ROCK_LIMIT, GRASS_LIMIT, WATER_LEVEL,
+                                                job.snowColor, job.rockColor, job.grassColor, job.sandColor,
+                                                job.waterColor, job.hasCity, job.buildingSeed);
+            job.noise = std::vector<std::vector<double>>();
+            break;
+        case Physics:
+            job.chunk->ensurePhysicsReady();
+            break;
+        case Classify:
+            job.chunk->ensureRenderReady();
+            break;
+        case Mesh:
+            job.chunk->ensureMeshReady();
+            break;
+        case Buildings:
+            if(job.hasCity && job.distance <= buildingRadius)
+            {
+                job.chunk->ensureBuildings();
+            }
+            break;
+        case Done:
+            break;
+    }
+}
+void World::publishChunkJob(ChunkJob &job)
+{
+    TRACE_SCOPE("publishChunkJob");
+    // The job's Physics step did this already. Every published chunk has to be
+    // ready for height queries, so the agent threads never make the normals
+    // lazily, waiting on the chunk's lock.
+    job.chunk->ensurePhysicsReady();
+    allSeenChunks.publish(job.chunkID, job.chunk);
+    if(job.colorVersion != colorVersion)
+    {
+        // The colors were changed while it was being made
+        job.chunk->updateTerrainColors(snowColor, rockColor, grassColor, sandColor, waterColor);
+    }
+    // Its neighbors got the edits made after it stitched, so it needs them too
+    for(int i = job.editCount - firstEditNumber; i < (int)terrainEdits.size(); i++)
+    {
+        job.chunk->deformTerrain(terrainEdits[i]);
+    }
+    // The player may have moved on since the job was added
+    if(isInRenderRadius(job.topLeft))
+    {
+        currentChunks.push_back(job.chunk);
+    }
+}
+void World::finishChunkJobs()
+{
+    chunkScheduler.finishAll();
+}
+int World::getNumChunkJobs() const
+{
+    return chunkScheduler.getNumJobs();
+}
+std::shared_ptr<Chunk> World::getChunk(int chunkID) const
+{
+    return allSeenChunks.find(chunkID);
+}
+void World::forEachChunk(const std::function<void(const std::shared_ptr<Chunk>&)> &f) const
+{
+    allSeenChunks.forEach(f);
+}
+bool World::isInRenderRadius(Point2D p) const
+{
+    Point2D playerChunk = chunkIDtoPoint2D(currentPlayerChunkID);
+    return abs(p.x - playerChunk.x) + abs(p.z - playerChunk.z) <= renderRadius;
+}
+void World::updateChunkBuildings(const std::vector<std::shared_ptr<Chunk>> &previousChunks)
+{
+    TRACE_SCOPE("updateChunkBuildings");
+    Point2D playerChunk = chunkIDtoPoint2D(currentPlayerChunkID);
+    // Chunks that are no longer being rendered don't need buildings
+    for(std::shared_ptr<Chunk> c : previousChunks)
+    {
+        if(!isInRenderRadius(c->getTopLeft()))
+        {
+            c->releaseBuildings();
+        }
+    }
+    for(std::shared_ptr<Chunk> c : currentChunks)
+    {
+        if(!c->getHasCity())
+        {
+            continue;
+        }
+        Point2D p = c->getTopLeft();
+        if(abs(p.x - playerChunk.x) + abs(p.z - playerChunk.z) <= buildingRadius)
+        {
+            c->ensureBuildings();
+        }
+        else
+        {
+            c->releaseBuildings();
+        }
+    }
+}
+std::vector<double> World::getTerrainHeightsAbove(int chunkID, bool isRelative) const
+{
+    int aboveID = getChunkIDAbove(chunkID);
+    std::shared_ptr<Chunk> c = allSeenChunks.find(aboveID);
+    if(c)
+    {
+        return c->getBottomTerrainHeights(isRelative);
+    }
+    else
+    {
+        return std::vector<double>();
+    }
+}
+std::vector<double> World::getTerrainHeightsBelow(int chunkID, bool isRelative) const
+{
+    int aboveID = getChunkIDBelow(chunkID);
+    std::shared_ptr<Chunk> c = allSeenChunks.find(aboveID);
+    if(c)
+    {
+        return c->getTopTerrainHeights(isRelative);
+    }
+    else
+    {
+        return std::vector<double>();
+    }
+}
+std::vector<double> World::getTerrainHeightsLeft(int chunkID, bool isRelative) const
+{
+    int aboveID = getChunkIDLeft(chunkID);
+    std::shared_ptr<Chunk> c = allSeenChunks.find(aboveID);
+    if(c)
+    {
+        return c->getRightTerrainHeights(isRelative);
+    }
+    else
+    {
+        return std::vector<double>();
+    }
+}
+std::vector<double> World::getTerrainHeightsRight(int chunkID, bool isRelative) const
+{
+    int aboveID = getChunkIDRight(chunkID);
+    std::shared_ptr<Chunk> c = allSeenChunks.find(aboveID);
+    if(c)
+    {
+        return c->getLeftTerrainHeights(isRelative);
+    }
+    else
+    {
+        return std::vector<double>();
+    }
+}
+
+int World::getChunkSeed(int chunkID) const
+{
+    // Mix the bits, so chunks next to each other don't start their sequences
+    // right next to each other
+    unsigned int h = static_cast<unsigned int>(chunkID) * 2654435761u ^ static_cast<unsigned int>(worldSeed);
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    return static_cast<int>(h & 0x7fffffff);
+}
+
+double World::getPerlinValue(Point2D p)
+{
+    return chunkSeeds.getScaledNoise(0.1,1)[mod(p.x, PERLIN_SEED_SIZE)][mod(p.z, PERLIN_SEED_SIZE)];
+}
+
+void World::getTerrainHeightsAt(const double *xs, const double *zs, double *heights, int count) const
+{
+    // Bucket the points by chunk so each chunk is looked up once
+    std::unordered_map<int, int> chunkToGroup;
+    std::vector<int> groupChunkIDs;
+    std::vector<int> pointGroups(count);
+    for(int k = 0; k < count; k++)
+    {
+        int chunkID = getChunkIDContainingPoint({xs[k], 0, zs[k]}, CHUNK_SIZE);
+        auto inserted = chunkToGroup.insert({chunkID, (int)groupChunkIDs.size()});
+        if(inserted.second)
+        {
+            groupChunkIDs.push_back(chunkID);
+        }
+        pointGroups[k] = inserted.first->second;
+    }
+    int numGroups = groupChunkIDs.size();
+    std::vector<int> groupStart(numGroups + 1, 0);
+    for(int k = 0; k < count; k++)
+    {
+        groupStart[pointGroups[k] + 1]++;
+    }
+    for(int g = 0; g < numGroups; g++)
+    {
+        groupStart[g + 1] += groupStart[g];
+    }
+
+    // Gather each chunk's points next to each other
+    std::vector<int> order(count);
+    std::vector<double> groupXs(count), groupZs(count), groupHeights(count);
+    std::vector<int> nextSlot(groupStart.begin(), groupStart.end() - 1);
+    for(int k = 0; k < count; k++)
+    {
+        int slot = nextSlot[pointGroups[k]]++;
+        order[slot] = k;
+        groupXs[slot] = xs[k];
+        groupZs[slot] = zs[k];
+    }
+
+    for(int g = 0; g < numGroups; g++)
+    {
+        int start = groupStart[g], end = groupStart[g + 1];
+        std::shared_ptr<Chunk> c = allSeenChunks.find(groupChunkIDs[g]);
+        if(!c)
+        {
+            std::fill(groupHeights.begin() + start, groupHeights.begin() + end, NAN);
+        }
+        else
+        {
+            c->getHeightsAt(groupXs.data() + start, groupZs.data() + start, groupHeights.data() + start, end - start);
+        }
+    }
+    for(int slot = 0; slot < count; slot++)
+    {
+        heights[order[slot]] = groupHeights[slot];
+    }
+}
+
+std::experimental::optional<RayHit> World::castRay(const Ray &ray) const
+{
+    return TerrainRaycaster(allSeenChunks, CHUNK_SIZE).castRay(ray);
+}
+std::vector<std::experimental::optional<RayHit>> World::castRays(const std::vector<Ray> &rays) const
+{
+    return TerrainRaycaster(allSeenChunks, CHUNK_SIZE).castRays(rays);
+}
+bool World::hasLineOfSight(Point p1, Point p2) const
+{
+    Point direction = {p2.x - p1.x, p2.y - p1.y, p2.z - p1.z};
+    return !castRay({p1, direction, sqrt(dotProduct(direction, direction))});
+}
+
+std::vector<Point> World::findPath(Point start, Point goal)
+{
+    return pathfinder.findPath(allSeenChunks, start, goal);
+}
+
+// ====================================
+//
+//             Camera
+//
+// ===================================
+double World::getInterpolationAlpha() const
+{
+    return tickAccumulator / TICK_MILLISECONDS;
+}
+Point World::getCameraLocation() const
+{
+    double alpha = getInterpolationAlpha();
+    Point location = player.getLocation();
+    return {previousPlayerLocation.x + alpha*(location.x - previousPlayerLocation.x),
+            previousPlayerLocation.y + alpha*(location.y - previousPlayerLocation.y),
+            previousPlayerLocation.z + alpha*(location.z - previousPlayerLocation.z)};
+}
+Point World::getCameraLookingAt() const
+{
+    // Only the location is interpolated. The mouse turns the player right away,
+    // so the direction is already up to date.
+    Point location = player.getLocation();
+    Point lookingAt = player.getLookingAt();
+    Point cameraLocation = getCameraLocation();
+    return {cameraLocation.x + lookingAt.x - location.x,
+            cameraLocation.y + lookingAt.y - location.y,
+            cameraLocation.z + lookingAt.z - location.z};
+}
+Point World::getCameraUp() const
+{
+    return player.getUp();
+}
+bool World::isChunkInView(const Chunk &c) const
+{
+    Point camLoc = getCameraLocation();
+    Point camLook = getCameraLookingAt();
+    Point direction = {camLook.x - camLoc.x, camLook.y - camLoc.y, camLook.z - camLoc.z};
+    // The chunk's bounding box, using its min and max heights
+    Point2D topLeft = c.getTopLeft();
+    int side = c.getSideLength();
+    for(double x : {(double)topLeft.x*side, (double)(topLeft.x + 1)*side})
+    {
+        for(double y : {c.getMinHeight(), c.getTopHeight()})
+        {
+            for(double z : {(double)topLeft.z*side, (double)(topLeft.z + 1)*side})
+            {
+                if(dotProduct({x - camLoc.x, y - camLoc.y, z - camLoc.z}, direction) > 0)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void World::update(double elapsedMilliseconds)
+{
+    tickAccumulator = fmin(tickAccumulator + elapsedMilliseconds, MAX_TICKS_PER_UPDATE*TICK_MILLISECONDS);
+    while(tickAccumulator >= TICK_MILLISECONDS)
+    {
+        previousPlayerLocation = player.getLocation();
+        tick();
+        tickAccumulator -= TICK_MILLISECONDS;
+    }
+    if(currentStatus != Playing)
+    {
+        // Nothing is moving, so don't interpolate toward an old location
+        previousPlayerLocation = player.getLocation();
+    }
+    auto chunkStart = std::chrono::steady_clock::now();
+    {
+        TRACE_SCOPE("chunk jobs");
+        if(chunkStepsPerUpdate > 0)
+        {
+            chunkScheduler.runSteps(chunkStepsPerUpdate);
+        }
+        else
+        {
+            chunkScheduler.run(chunkMillisecondsPerUpdate);
+        }
+    }
+    lastChunkMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - chunkStart).count();
+}
+
+// Tick helper functions
+void World::tick()
+{
+    TRACE_SCOPE("tick");
+    if(currentStatus == Playing)
+    {
+        playerTick();
+        agentTick();
+    }
+}
+void World::playerTick()
+{
+    TRACE_SCOPE("playerTick");
+    player.tick();
+    if(spacebar)
+    {
+        player.tryToJump();
+    }
+    updatePlayerChunk();
+    if(hyperSpeed)
+    {
+        // Take the extra steps one at a time, so the boundary, chunks, and
+        // buildings are all checked in between
+        for(int i = 0; i < HYPER_SPEED_FACTOR; i++)
+        {
+            player.moveXZ();
+            player.stayWithinBoundary();
+            updatePlayerChunk();
+            correctPlayerCollisions();
+        }
+    }
+    player.setCurrentTerrainHeight(allSeenChunks.find(currentPlayerChunkID)->getHeightAt(player.getLocation()));
+    correctPlayerCollisions();
+}
+void World::updatePlayerChunk()
+{
+    int newPlayerChunkID = getChunkIDContainingPoint(player.getLocation(), CHUNK_SIZE);
+    if(newPlayerChunkID != currentPlayerChunkID)
+    {
+        currentPlayerChunkID = newPlayerChunkID;
+        updateCurrentChunks();
+    }
+}
+void World::correctPlayerCollisions()
+{
+    Point p = player.getLocation();
+    // The player's cylinder can reach into the chunks next to this one
+    std::vector<int> chunkIDs;
+    for(double dx : {-PLAYER_RADIUS, PLAYER_RADIUS})
+    {
+        for(double dz : {-PLAYER_RADIUS, PLAYER_RADIUS})
+        {
+            int id = getChunkIDContainingPoint({p.x + dx, p.y, p.z + dz}, CHUNK_SIZE);
+            if(std::find(chunkIDs.begin(), chunkIDs.end(), id) == chunkIDs.end())
+            {
+                chunkIDs.push_back(id);
+            }
+        }
+    }
+    for(int id : chunkIDs)
+    {
+        std::shared_ptr<Chunk> c = allSeenChunks.find(id);
+        if(!c)
+        {
+            continue;
+        }
+        for(std::shared_ptr<Building> b : c->getBuildingsNear(p, PLAYER_RADIUS))
+        {
+            std::experimental::optional<Point> corrected = b->correctCollision(p, PLAYER_RADIUS);
+            if(corrected)
+            {
+                player.shiftLocation(corrected->x - p.x, corrected->y - p.y, corrected->z - p.z);
+                p = *corrected;
+            }
+        }
+    }
+}
+void World::agentTick()
+{
+    TRACE_SCOPE("agentTick");
+    if(agents.size() == 0)
+    {
+        return;
+    }
+    agents.tick([this](const double *xs, const double *zs, double *heights, int count)
+                {
+                    getTerrainHeightsAt(xs, zs, heights, count);
+                }, agentWorkers);
+}
+
+// Agents
+void World::spawnAgents(int count, int seed)
+{
+    if(currentChunks.empty())
+    {
+        return;
+    }
+    RandomNumberGenerator rng(seed);
+    std::vector<double> xs(count), zs(count), heights(count), angles(count);
+    for(int k = 0; k < count; k++)
+    {
+        // Pick one of the chunks around the player, then a place in it
+        int chunkIndex = std::min((int)(rng.getRandom() * currentChunks.size()), (int)currentChunks.size() - 1);
+        Point chunkCenter = currentChunks[chunkIndex]->getCenter();
+        xs[k] = chunkCenter.x + (rng.getRandom() - 0.5) * CHUNK_SIZE;
+        zs[k] = chunkCenter.z + (rng.getRandom() - 0.5) * CHUNK_SIZE;
+        angles[k] = 2*PI*rng.getRandom();
+    }
+    getTerrainHeightsAt(xs.data(), zs.data(), heights.data(), count);
+    for(int k = 0; k < count; k++)
+    {
+        // Don't put agents where there is no terrain yet
+        if(!std::isnan(heights[k]))
+        {
+            agents.addAgent({xs[k], heights[k] + PLAYER_HEIGHT/2, zs[k]}, AGENT_SPEED, angles[k]);
+        }
+    }
+}
+
+// Game Management
+void World::resetGame()
+{
+    initializePlayer();
+    agents.clear();
+    currentStatus = Playing;
+}
+void World::cycleColors()
+{
+    if(curColorScheme == Plain)
+    {
+        curColorScheme = Majestic;
+    }
+    else if(curColorScheme == Majestic)
+    {
+        curColorScheme = Lava;
+    }
+    else if(curColorScheme == Lava)
+    {
+        curColorScheme = Ice;
+    }
+    else if(curColorScheme == Ice)
+    {
+        curColorScheme = Plain;
+    }
+    updateColorScheme(curColorScheme);
+}
+void World::updateColorScheme(ColorScheme inputScheme)
+{
+    std::lock_guard<std::mutex> lock(chunkInputsMutex);
+    colorVersion++;
+    const TerrainColors &colors = COLOR_SCHEMES[inputScheme];
+    snowColor = colors.snow;
+    rockColor = colors.rock;
+    grassColor = colors.grass;
+    sandColor = colors.sand;
+    waterColor = colors.water;
+    allSeenChunks.forEach([this](const std::shared_ptr<Chunk> &c)
+                          {
+                              c->updateTerrainColors(snowColor, rockColor, grassColor, sandColor, waterColor);
+                          });
+}
+
+void World::deformTerrain(const TerrainBrush &brush)
+{
+    std::lock_guard<std::mutex> lock(chunkInputsMutex);
+    if(chunkScheduler.getNumJobs() == 0)
+    {
+        // Chunks that stitch from now on start with every edit so far
+        firstEditNumber += terrainEdits.size();
+        terrainEdits.clear();
+    }
+    terrainEdits.push_back(brush);
+    int minX = floor((brush.x - brush.radius) / CHUNK_SIZE), maxX = floor((brush.x + brush.radius) / CHUNK_SIZE);
+    int minZ = floor((brush.z - brush.radius) / CHUNK_SIZE), maxZ = floor((brush.z + brush.radius) / CHUNK_SIZE);
+    for(int x = minX; x <= maxX; x++)
+    {
+        for(int z = minZ; z <= maxZ; z++)
+        {
+            std::shared_ptr<Chunk> c = allSeenChunks.find(point2DtoChunkID({x, z}));
+            if(c)
+            {
+                c->deformTerrain(brush);
+            }
+        }
+    }
+}
+void World::deformTerrainAhead(BrushMode mode)
+{
+    if(currentStatus != Playing)
+    {
+        return;
+    }
+    Point location = player.getLocation();
+    TerrainBrush brush;
+    brush.x = location.x + EDIT_DISTANCE*cos(player.getXZAngle());
+    brush.z = location.z + EDIT_DISTANCE*sin(player.getXZAngle());
+    brush.radius = EDIT_RADIUS;
+    brush.mode = mode;
+    brush.amount = mode == Flatten ? 1 : EDIT_AMOUNT;
+    brush.targetHeight = allSeenChunks.find(currentPlayerChunkID)->getHeightAt(location);
+    deformTerrain(brush);
+}
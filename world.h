@@ -0,0 +1,234 @@
+#ifndef RANDOM_TERRAIN_WORLD_H
+#define RANDOM_TERRAIN_WORLD_H
+
+// The game without the window: the player, agents, and chunks, ticked on a
+// fixed timestep. Nothing here draws, so benchmarks and tools can run a whole
+// world without OpenGL. GameManager adds the menus and drawing on top.
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include "player.h"
+#include "structs.h"
+#include "chunk.h"
+#include "mathHelper.h"
+#include "perlinNoiseGenerator.h"
+#include "terrainRaycaster.h"
+#include "agentStore.h"
+#include "workerPool.h"
+#include "pathfinder.h"
+#include "chunkScheduler.h"
+#include "chunkCache.h"
+#include "worldSettings.h"
+
+enum GameStatus {Intro, Playing, End, Paused};
+
+class World
+{
+protected:
+    Player player;
+
+    // Simulated agents that share the player's physics
+    AgentStore agents;
+    // Tick the agents along with the game's thread
+    WorkerPool agentWorkers;
+
+    // Controls
+    bool wKey, aKey, sKey, dKey, spacebar, hyperSpeed;
+
+    // Chunks
+    // Everything random about the world comes from this, so the same seed
+    // makes the same world
+    int worldSeed;
+    PerlinNoiseGenerator chunkSeeds;
+    int renderRadius;
+    std::atomic<int> buildingRadius; // Chunks within this many chunks of the player have buildings
+    // Only the game's thread publishes chunks, but any thread can read them
+    ChunkCache allSeenChunks;
+    // The colors and terrain edits are only changed by the game's thread,
+    // holding this lock. The chunk scheduler's workers hold it to read them.
+    std::mutex chunkInputsMutex;
+    std::vector<std::shared_ptr<Chunk>> currentChunks;
+    int currentPlayerChunkID;
+    // New chunks are made by worker threads, or a few steps at a time within
+    // this much time per update if there aren't any
+    ChunkScheduler chunkScheduler;
+    double chunkMillisecondsPerUpdate;
+    int chunkStepsPerUpdate; // used instead of the time if it's more than 0
+    double lastChunkMilliseconds; // how long the scheduler ran in the last update
+
+    // The game ticks every TICK_MILLISECONDS no matter how often it is drawn.
+    // Time that hasn't been ticked yet builds up here.
+    double tickAccumulator;
+    // Where the player was before the last tick, for drawing in between ticks
+    Point previousPlayerLocation;
+    // Keeps cost grids and portal graphs of the chunks between searches
+    Pathfinder pathfinder;
+    ColorScheme curColorScheme;
+    RGBAcolor snowColor, rockColor, grassColor, sandColor, waterColor;
+    int colorVersion; // goes up when the colors change
+    // The terrain edits since the chunk scheduler last had no jobs, so a chunk
+    // that was being made during one can get it when it's published
+    std::vector<TerrainBrush> terrainEdits;
+    int firstEditNumber; // how many edits came before terrainEdits[0]
+
+    GameStatus currentStatus;
+
+    // Game parameters. The terrain's own are in worldSettings.h.
+    int POINTS_PER_CHUNK = 30;
+    int BUILDING_RADIUS = 2;
+    double PLAYER_HEIGHT = 10;
+    double PLAYER_RADIUS = 3;
+    double PLAYER_SPEED = 1.5;
+    double MOUSE_SENSITIVITY = 0.005;
+    int MAX_DISTANCE_FROM_SPAWN = 20480; // 40 chunks
+    double GRAVITY = -0.5;
+    double PLAYER_JUMP_AMOUNT = 6;
+    int HYPER_SPEED_FACTOR = 6;
+    double TICK_MILLISECONDS = 30;
+    int MAX_TICKS_PER_UPDATE = 5; // after a long stall, skip ahead instead of catching up
+    double CHUNK_MILLISECONDS_PER_UPDATE = 3;
+    double AGENT_SPEED = 1;
+    // Terrain edits from the keyboard, centered EDIT_DISTANCE in front of the player
+    double EDIT_RADIUS = 60;
+    double EDIT_AMOUNT = 10;
+    double EDIT_DISTANCE = 80;
+public:
+    World();
+    // A negative seed picks one at random
+    World(int inputRenderRadius, int inputPointsPerChunk = 30, int inputWorldSeed = -1);
+    // Stops the chunk workers before the rest of the world goes away
+    ~World();
+
+    // Helper functions for the constructors
+    void initializeWorldSeed(int inputWorldSeed);
+    void initializePlayer();
+    void initializeAgents();
+    void initializeChunkScheduler();
+
+    // Getters
+    Player getPlayer() const;
+    const AgentStore &getAgents() const;
+    bool getWKey() const;
+    bool getAKey() const;
+    bool getSKey() const;
+    bool getDKey() const;
+    bool getSpacebar() const;
+    GameStatus getCurrentStatus() const;
+    double getTickMilliseconds() const;
+    int getCurrentPlayerChunkID() const;
+    int getWorldSeed() const;
+    double getLastChunkMilliseconds() const;
+
+    // Setters
+    void setWKey(bool input);
+    void setAKey(bool input);
+    void setSKey(bool input);
+    void setDKey(bool input);
+    void setSpacebar(bool input);
+    void setHyperSpeed(bool input);
+    void setCurrentStatus(GameStatus input);
+    // Point the player without the mouse, in radians
+    void setPlayerAngles(double xzAngle, double yAngle);
+    void setBuildingRadius(int input);
+    // Including the game's thread
+    void setNumAgentThreads(int input);
+    void setChunkMillisecondsPerUpdate(double input);
+    // Run this many chunk steps each update instead of filling a time budget,
+    // so the same updates always make the same chunks. 0 goes back to the budget.
+    void setChunkStepsPerUpdate(int input);
+    // 0 makes the chunks on the game's thread
+    void setNumChunkThreads(int input);
+
+    // Chunks
+    // Chunks that haven't been made yet get jobs in the chunk scheduler,
+    // except the player's chunk, which is finished right away
+    void updateCurrentChunks();
+    // Run one step of making a chunk. This can be on a worker thread.
+    void runChunkJobStep(ChunkJob &job);
+    // Add a chunk the scheduler made to the game, on the game's thread
+    void publishChunkJob(ChunkJob &job);
+    // Make every chunk that has a job, ignoring the time budget
+    void finishChunkJobs();
+    int getNumChunkJobs() const;
+    // nullptr if the chunk hasn't been made
+    std::shared_ptr<Chunk> getChunk(int chunkID) const;
+    // Calls f on every chunk that has been made
+    void forEachChunk(const std::function<void(const std::shared_ptr<Chunk>&)> &f) const;
+    bool isInRenderRadius(Point2D p) const;
+    // Make buildings for chunks within buildingRadius of the player, and release the rest
+    void updateChunkBuildings(const std::vector<std::shared_ptr<Chunk>> &previousChunks);
+    // If the specified adjacent chunk has been created already, then
+    // this returns the relevant border of terrain points.
+    // Otherwise, returns empty vector
+    std::vector<double> getTerrainHeightsAbove(int chunkID, bool isRelative) const;
+    std::vector<double> getTerrainHeightsBelow(int chunkID, bool isRelative) const;
+    std::vector<double> getTerrainHeightsLeft(int chunkID, bool isRelative) const;
+    std::vector<double> getTerrainHeightsRight(int chunkID, bool isRelative) const;
+
+    // The seed for the chunk's own random values, which don't depend on what
+    // order the chunks are made in or which thread makes them
+    int getChunkSeed(int chunkID) const;
+
+    // Given the topLeft chunkCoords of a chunk, this returns the perlin seed
+    // (between 0 and 1) for it given by the chunkSeeds P.N.G.
+    double getPerlinValue(Point2D p);
+
+    // The terrain height at count points at once, stored as separate x and z arrays.
+    // Points are grouped by chunk first. Points in chunks that haven't been made get NAN.
+    void getTerrainHeightsAt(const double *xs, const double *zs, double *heights, int count) const;
+
+    // Find where rays hit the terrain or buildings, for picking and line of sight.
+    // Only chunks that have been generated can be hit.
+    std::experimental::optional<RayHit> castRay(const Ray &ray) const;
+    std::vector<std::experimental::optional<RayHit>> castRays(const std::vector<Ray> &rays) const;
+    // Whether anything blocks the straight line between the two points
+    bool hasLineOfSight(Point p1, Point p2) const;
+
+    // The points to walk through to get from start to goal over the terrain, avoiding
+    // water and cliffs. Empty if there is no way there through the chunks made so far.
+    std::vector<Point> findPath(Point start, Point goal);
+
+    // Camera
+    // The camera is drawn partway between the last two ticks, so it moves
+    // smoothly when frames come more often than ticks
+    double getInterpolationAlpha() const;
+    Point getCameraLocation() const;
+    Point getCameraLookingAt() const;
+    Point getCameraUp() const;
+    // False if the chunk is completely behind the camera
+    bool isChunkInView(const Chunk &c) const;
+
+    // Run as many ticks as fit in the time that has passed
+    void update(double elapsedMilliseconds);
+
+    // Tick helper functions
+    void tick();
+    void playerTick();
+    // Load new chunks if the player has moved into a different one
+    void updatePlayerChunk();
+    // Push the player out of any buildings they walked into
+    void correctPlayerCollisions();
+    void agentTick();
+
+    // Agents
+    // Put count agents on the terrain at random places in the chunks around the player,
+    // walking in random directions
+    void spawnAgents(int count, int seed);
+
+    // Game Management
+    void checkForGameEnd();
+    void resetGame();
+    void cycleColors();
+    void updateColorScheme(ColorScheme inputScheme);
+    // Apply the brush to the terrain of every chunk it reaches
+    void deformTerrain(const TerrainBrush &brush);
+    // Edit a circle of terrain in front of the player, if the game is being
+    // played. Flatten levels it toward the ground the player is standing on.
+    void deformTerrainAhead(BrushMode mode);
+};
+
+#endif //RANDOM_TERRAIN_WORLD_H
@@ -0,0 +1,39 @@
+#ifndef RANDOM_TERRAIN_WORLDSETTINGS_H
+#define RANDOM_TERRAIN_WORLDSETTINGS_H
+
+// The parameters that decide what the terrain looks like. The World and the
+// benchmarks both use these, so the benchmarks make the same chunks the game does.
+
+#include "structs.h"
+
+enum ColorScheme {Plain, Majestic, Lava, Ice};
+
+struct TerrainColors
+{
+    RGBAcolor snow, rock, grass, sand, water;
+};
+
+const int CHUNK_SIZE = 512;
+const int PERLIN_SEED_SIZE = 10;
+const double TERRAIN_HEIGHT_FACTOR = 500;
+const double SNOW_LIMIT = 920;
+const double ROCK_LIMIT = 750;
+const double GRASS_LIMIT = 120;
+const double WATER_LEVEL = 95;
+
+// Indexed by ColorScheme
+const TerrainColors COLOR_SCHEMES[] = {
+        // Plain
+        {{1.0, 0.9, 1.0, 1.0}, {0.6, 0.64, 0.62, 1.0}, {0.2, 0.75, 0.08, 1.0},
+         {1.0, 0.84, 0.33, 1.0}, {0.0, 0.24, 1.0, 0.75}},
+        // Majestic
+        {{1.0, 0.9, 0.9, 1.0}, {0.4, 0.1, 0.42, 1.0}, {0.1, 0.48, 0.13, 1.0},
+         {0.92, 0.82, 0.39, 1.0}, {0.0, 0.54, 0.44, 0.75}},
+        // Lava
+        {{0.8, 0.2, 0.2, 0.99}, {0.05, 0.0, 0.05, 1.0}, {0.2, 0.25, 0.25, 1.0},
+         {0.15, 0.02, 0.01, 1.0}, {0.9, 0.5, 0.0, 0.87}},
+        // Ice
+        {{0.5, 0.5, 1.0, 0.95}, {0.85, 0.85, 1.0, 0.95}, {0.65, 0.65, 0.65, 1.0},
+         {0.92, 0.82, 0.39, 1.0}, {0.75, 0.75, 1.0, 0.87}}};
+
+#endif //RANDOM_TERRAIN_WORLDSETTINGS_H